@@ -34,6 +34,7 @@
 #include "algebra.h"
 #include "raytracing.h"
 #include "zbuffer.h"
+#include "screen.h"                 /* exibe a imagem no canvas como uma textura */
 
 /* -- implemented in "iconlib.c" to load standard icon images into IUP */
 void IconLibOpen(void);
@@ -41,8 +42,10 @@ void IconLibOpen(void);
 /*- Contexto do Programa: -------------------------------------------------*/
 Scene* scene;         /* cena corrente */
 int yc=0;            /* y corrente para Ray Tracing incremetnal */
+int aa=AA_ADAPTIVE;  /* anti-aliasing do Ray Tracing (AntialiasMode); a tecla 'a' alterna */
 int width,height=-1;
 Image *image;        /* imagem que armazena o resultado at agora do algoritmo */
+Screen *screen;      /* textura que exibe a imagem no canvas */
 
 Ihandle* canvas;      /* ponteiro IUP dos canvas */
 Ihandle* label;       /* ponteiro IUP do label para colocar mensagens para usuario */
@@ -60,8 +63,6 @@ void ray_trace (void)
       Camera* camera=sceGetCamera(scene);
       int w = camGetScreenWidth(camera);
       int h = camGetScreenHeight(camera);
-      Vector ray;
-      Vector eye;
       int x,y;
 
       /* transformacao de instanciacao dos objetos no sistema de coordenadas da camera */
@@ -76,27 +77,17 @@ void ray_trace (void)
       glDisable     (GL_DEPTH_TEST);  /* desabilita o teste de profundidade do z-buffer */
       glDisable     (GL_LIGHTING);  /* desabilita a luz */
 
-      eye = camGetEye( camera );
-
       for (y=0;y<h;y++) {
-         glBegin(GL_POINTS);
    		for( x = 0; x < w; ++x ) {
-     		Color pixel = { 0.0, 0.0, 0.0 };
-			Color color;
-
-			ray = camGetRay( camera, x, y );
-
-			/* Obtm a amostra. */
-			color = rayTrace( scene, eye, ray, 0 );
-
-			/* Adiciona a contribuio da amostra  cor final */
-			pixel = colorAddition( pixel, color );
+			/* Obtm a cor do pixel, com mais amostras nas bordas se houver anti-aliasing */
+			Color pixel = rayTracePixel( scene, x, y, (AntialiasMode)aa, AA_THRESHOLD, NULL );
 
 			imageSetPixel( image, x, y, pixel );
-            glColor3f((float)pixel.red,(float)pixel.green,(float)pixel.blue);
-            glVertex2i(x,y);
          }
-		   glEnd();
+
+         /* Envia e desenha a linha inteira de uma vez */
+         scrUpload( screen, 0, y, w, 1 );
+         scrDraw( screen, 0, y, w, 1 );
          glFlush();
       }
    }
@@ -249,8 +240,6 @@ int idle_cb(void)
       Camera* camera=sceGetCamera(scene);
       int w = camGetScreenWidth(camera);
       int h = camGetScreenHeight(camera);
-      Vector ray;
-      Vector eye;
       int x;
 
       /* transformacao de instanciacao dos objetos no sistema de coordenadas da camera */
@@ -265,26 +254,16 @@ int idle_cb(void)
       glDisable     (GL_DEPTH_TEST);  /* desabilita o teste de profundidade do z-buffer */
       glDisable     (GL_LIGHTING);  /* desabilita a luz */
 
-      eye = camGetEye( camera );
-
-      glBegin(GL_POINTS);
    		for( x = 0; x < width; ++x ) {
-     		Color pixel = { 0.0, 0.0, 0.0 };
-			Color color;
-
-			ray = camGetRay( camera, x, yc );
-
-			/* Obtm a amostra. */
-			color = rayTrace( scene, eye, ray, 0 );
-
-			/* Adiciona a contribuio da amostra  cor final */
-			pixel = colorAddition( pixel, color );
+			/* Obtm a cor do pixel, com mais amostras nas bordas se houver anti-aliasing */
+			Color pixel = rayTracePixel( scene, x, yc, (AntialiasMode)aa, AA_THRESHOLD, NULL );
 
 			imageSetPixel( image, x, yc, pixel );
-            glColor3f((float)pixel.red,(float)pixel.green,(float)pixel.blue);
-            glVertex2i(x,yc);
          }
-		glEnd();
+
+		/* Envia e desenha a linha inteira de uma vez */
+		scrUpload( screen, 0, yc, width, 1 );
+		scrDraw( screen, 0, yc, width, 1 );
 		yc++;
 	}
    else {
@@ -322,8 +301,11 @@ int load_cb(void) {
   width = camGetScreenWidth( camera );
   height = camGetScreenHeight( camera );
 
+  scrDestroy(screen);
   if (image) imgDestroy(image);
   image = imgCreate( width, height );
+  IupGLMakeCurrent(canvas);
+  screen = scrCreate( image );
   IupSetfAttribute(label, "TITLE", "%s (%3dx%3d)", strrchr(filename,'\\')+1, width, height);
   IupSetFunction("repaint_cb", (Icallback) repaint_ogl_cb);
   sprintf(buffer,"%3dx%3d", width, height);
@@ -414,6 +396,14 @@ int keypress_cb( Ihandle *self, int c, int press )
   	      IupSetFunction (IUP_IDLE_ACTION, (Icallback) idle_cb); /* a imagem ja' esta' completa */
   			break;
 
+		/* alterna o anti-aliasing: desligado, adaptativo, 16 amostras */
+		case K_A:
+		case K_a:
+         aa = ( aa == AA_FULL ) ? AA_NONE : aa + 1;
+         IupSetfAttribute(label, "TITLE", "Anti-aliasing: %s",
+                          ( aa == AA_NONE ) ? "desligado" : ( aa == AA_ADAPTIVE ) ? "adaptativo" : "16 amostras");
+  			break;
+
 
 
 		case K_ESC:
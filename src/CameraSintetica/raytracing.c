@@ -73,6 +73,12 @@ static double getNearestObject( Scene* scene, Vector eye, Vector ray, Object* *o
  */
 static int isInShadow( Scene* scene, Vector point, Vector rayToLight, Vector lightLocation );
 
+/**
+ *	Acumula uma amostra de rayTracePixel(). Cada componente  limitada a [0,1], como
+ *	ser exibida, para que uma amostra muito clara no domine a mdia.
+ */
+static void addSample( double sum[3], Color color );
+
 
 /************************************************************************/
 /* Definio das Funes Exportadas                                     */
@@ -104,6 +110,72 @@ Color rayTrace( Scene* scene, Vector eye, Vector ray, int depth )
 	return shade( scene, eye, ray, object, point, normal, depth );
 }
 
+Color rayTracePixel( Scene* scene, int x, int y, AntialiasMode mode, double threshold, int *samples )
+{
+	/* Coluna da amostra inicial de cada linha da grade: uma por linha e por coluna */
+	static const int firstColumn[AA_GRID] = { 1, 3, 0, 2 };
+
+	Camera* camera = sceGetCamera( scene );
+	Vector eye = camGetEye( camera );
+	Color color, minimum, maximum;
+	double sum[3] = { 0, 0, 0 };
+	int count = 0;
+	int row, column;
+
+	if( mode == AA_NONE )
+	{
+		if( samples )
+			*samples = 1;
+		return rayTrace( scene, eye, camGetRay( camera, x, y ), 0 );
+	}
+
+	for( row = 0; row < AA_GRID; ++row )
+	{
+		color = rayTrace( scene, eye, camGetRay( camera, x + ( firstColumn[row] + 0.5 ) / AA_GRID,
+														 y + ( row + 0.5 ) / AA_GRID ), 0 );
+
+		if( row == 0 )
+			minimum = maximum = color;
+
+		minimum.red   = ( color.red   < minimum.red   ) ? color.red   : minimum.red;
+		minimum.green = ( color.green < minimum.green ) ? color.green : minimum.green;
+		minimum.blue  = ( color.blue  < minimum.blue  ) ? color.blue  : minimum.blue;
+		maximum.red   = ( color.red   > maximum.red   ) ? color.red   : maximum.red;
+		maximum.green = ( color.green > maximum.green ) ? color.green : maximum.green;
+		maximum.blue  = ( color.blue  > maximum.blue  ) ? color.blue  : maximum.blue;
+
+		addSample( sum, color );
+		++count;
+	}
+
+	/* S completa a grade onde as amostras iniciais discordam (bordas, sombras) */
+	if( mode == AA_FULL || maximum.red - minimum.red > threshold ||
+		maximum.green - minimum.green > threshold || maximum.blue - minimum.blue > threshold )
+	{
+		for( row = 0; row < AA_GRID; ++row )
+		{
+			for( column = 0; column < AA_GRID; ++column )
+			{
+				if( column == firstColumn[row] )
+					continue;
+
+				addSample( sum, rayTrace( scene, eye, camGetRay( camera, x + ( column + 0.5 ) / AA_GRID,
+																		  y + ( row + 0.5 ) / AA_GRID ), 0 ) );
+				++count;
+			}
+		}
+	}
+
+	if( samples )
+		*samples = count;
+
+	color.red = (float)( sum[0] / count );
+	color.green = (float)( sum[1] / count );
+	color.blue = (float)( sum[2] / count );
+
+	return color;
+}
+
 /************************************************************************/
 /* Definio das Funes Privadas                                       */
 /************************************************************************/
@@ -233,3 +305,9 @@ static int isInShadow( Scene* scene, Vector point, Vector rayToLight, Vector lig
 	return 0;
 }
 
+static void addSample( double sum[3], Color color )
+{
+	sum[0] += ( color.red   < 0 ) ? 0 : ( color.red   > 1 ) ? 1 : color.red;
+	sum[1] += ( color.green < 0 ) ? 0 : ( color.green > 1 ) ? 1 : color.green;
+	sum[2] += ( color.blue  < 0 ) ? 0 : ( color.blue  > 1 ) ? 1 : color.blue;
+}
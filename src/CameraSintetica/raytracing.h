@@ -20,6 +20,42 @@
 #include "color.h"
 
 
+/************************************************************************/
+/* Constantes Exportadas                                                */
+/************************************************************************/
+/** Lado da grade de amostras de um pixel com antialiasing (at 4x4 = 16 amostras) */
+#define AA_GRID			4
+
+/** Limiar usual de contraste entre as amostras iniciais de um pixel (veja AA_ADAPTIVE) */
+#define AA_THRESHOLD	0.1
+
+
+/************************************************************************/
+/* Tipos Exportados                                                     */
+/************************************************************************/
+/**
+ *   Modos de antialiasing de rayTracePixel().
+ */
+typedef enum
+{
+	/**
+	 *  Uma nica amostra por pixel.
+	 */
+	AA_NONE,
+	/**
+	 *  Uma amostra em cada linha e em cada coluna da grade (AA_GRID amostras); se
+	 *  alguma componente de cor variar entre elas mais que o limiar, o restante da
+	 *  grade tambm  amostrado.
+	 */
+	AA_ADAPTIVE,
+	/**
+	 *  Sempre a grade inteira (AA_GRID x AA_GRID amostras).
+	 */
+	AA_FULL
+}
+AntialiasMode;
+
+
 /************************************************************************/
 /* Funes Exportadas                                                   */
 /************************************************************************/
@@ -34,5 +70,22 @@
  *	@return cor  correspondente ao raio.
  */
 Color rayTrace( Scene* scene, Vector eye, Vector ray, int depth );
+
+/**
+ *	Calcula a cor de um pixel da cmera da cena, com antialiasing. As amostras
+ *	ficam nos centros das clulas de uma grade de AA_GRID x AA_GRID sobre o pixel,
+ *	e a cor  a mdia das amostras traadas.
+ *
+ *	@param scene Handle para cena.
+ *	@param x Coluna do pixel.
+ *	@param y Linha do pixel.
+ *	@param mode Modo de antialiasing.
+ *	@param threshold Contraste, em cada componente de cor, a partir do qual o modo
+ *					AA_ADAPTIVE amostra a grade inteira.
+ *	@param samples [out]Nmero de raios primrios traados. Pode ser NULL.
+ *
+ *	@return Cor do pixel.
+ */
+Color rayTracePixel( Scene* scene, int x, int y, AntialiasMode mode, double threshold, int *samples );
 #endif
 
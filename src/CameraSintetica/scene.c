@@ -45,18 +45,26 @@ struct _Scene
      */
 	int materialCount;
 	/**
-     *  Vetor com os materiais existentes na cena.
+     *  Capacidade alocada para o vetor de materiais.
      */
-	Material* materials[MAX_MATERIALS];
+	int materialCapacity;
+	/**
+     *  Vetor crescente com os materiais existentes na cena.
+     */
+	Material** materials;
 
 	/**
      *  Nmero de objetos existentes na cena.
      */
 	int objectCount;
 	/**
-     *  Vetor com os objetos existentes na cena.
+     *  Capacidade alocada para o vetor de objetos.
+     */
+	int objectCapacity;
+	/**
+     *  Vetor crescente com os objetos existentes na cena.
      */
-	Object* objects[MAX_OBJECTS];
+	Object** objects;
 
 	/**
      *  Intensidade rgb da luz ambiente da cena
@@ -67,9 +75,13 @@ struct _Scene
      */
 	int lightCount;
 	/**
-     *  Vetor com as fontes de luz existentes na cena.
+     *  Capacidade alocada para o vetor de fontes de luz.
      */
-	Light* lights[MAX_LIGHTS];
+	int lightCapacity;
+	/**
+     *  Vetor crescente com as fontes de luz existentes na cena.
+     */
+	Light** lights;
 
    /**
      * Um marcador de posicao 3D na cena utilizado para testar alg de visao computacional
@@ -77,6 +89,24 @@ struct _Scene
    Vector marker;
 };
 
+/************************************************************************/
+/* Funes Privadas                                                     */
+/************************************************************************/
+/**
+ *	Conta as definies de materiais, luzes e objetos de um arquivo rt4, para que
+ *	os vetores da cena sejam alocados de uma s vez. O arquivo  rebobinado ao final.
+ */
+static void sceCountCommands( FILE *file, int *materialCount, int *lightCount, int *objectCount );
+
+/**
+ *	Garante espao para pelo menos 'required' elementos de tamanho 'size' em um
+ *	vetor crescente, dobrando sua capacidade quando necessrio.
+ *
+ *	@return Zero se no houver memria (neste caso o vetor original  preservado).
+ */
+static int sceReserve( void **array, int *capacity, int required, size_t size );
+
+
 /************************************************************************/
 /* Definio das Funes Exportadas                                     */
 /************************************************************************/
@@ -213,6 +243,11 @@ Scene* sceLoad( const char *filename )
 	Vector tex2 = algVector( 0,0,0,1 );
 	Vector tex3 = algVector( 0,0,0,1 );
 	double radius;
+
+	/* Pr-contagem */
+	int materialTotal;
+	int lightTotal;
+	int objectTotal;
 	
 	file = fopen( filename, "rt" );
 	if( !file )
@@ -232,7 +267,19 @@ Scene* sceLoad( const char *filename )
 	scene->objectCount = 0;
 	scene->lightCount = 0;
 	scene->materialCount = 0;
+	scene->objectCapacity = 0;
+	scene->lightCapacity = 0;
+	scene->materialCapacity = 0;
+	scene->objects = NULL;
+	scene->lights = NULL;
+	scene->materials = NULL;
 	
+	/* Reserva os vetores de acordo com o que o arquivo define */
+	sceCountCommands( file, &materialTotal, &lightTotal, &objectTotal );
+	sceReserve( (void **)&scene->materials, &scene->materialCapacity, materialTotal, sizeof(Material*) );
+	sceReserve( (void **)&scene->lights, &scene->lightCapacity, lightTotal, sizeof(Light*) );
+	sceReserve( (void **)&scene->objects, &scene->objectCapacity, objectTotal, sizeof(Object*) );
+
 	while( fgets( buffer, sizeof(buffer), file ) ) 
 	{
 		if( sscanf( buffer, "RT %lf\n", &at ) == 1 )
@@ -279,10 +326,10 @@ Scene* sceLoad( const char *filename )
 				image = imgReadBMP (textureFileName);
 			}
 
-			if( scene->materialCount >= MAX_MATERIALS )
+			if( !sceReserve( (void **)&scene->materials, &scene->materialCapacity, scene->materialCount + 1, sizeof(Material*) ) )
 			{
 				imgDestroy( image );
-				fprintf( stderr, "sceLoad: Foi ultrapassado o limite de definicoes de materiais na cena. Ignorando." );
+				fprintf( stderr, "sceLoad: Memoria insuficiente para os materiais da cena. Ignorando." );
 				continue;
 			}
 
@@ -293,9 +340,9 @@ Scene* sceLoad( const char *filename )
 		} 
 		else if( sscanf( buffer, "LIGHT %lf %lf %lf %f %f %f\n", &pos1.x, &pos1.y, &pos1.z, &lightColor.red, &lightColor.green, &lightColor.blue ) == 6 )
 		{
-			if( scene->lightCount >= MAX_LIGHTS )
+			if( !sceReserve( (void **)&scene->lights, &scene->lightCapacity, scene->lightCount + 1, sizeof(Light*) ) )
 			{
-				fprintf( stderr, "sceLoad: Foi ultrapassado o limite de definicoes de luzes na cena. Ignorando." );
+				fprintf( stderr, "sceLoad: Memoria insuficiente para as luzes da cena. Ignorando." );
 				continue;
 			}
 
@@ -305,9 +352,9 @@ Scene* sceLoad( const char *filename )
 		} 
 		else if( sscanf( buffer, "SPHERE %d %lf %lf %lf %lf\n", &material, &radius, &pos1.x,&pos1.y,&pos1.z ) == 5 ) 
 		{
-			if( scene->objectCount >= MAX_OBJECTS )
+			if( !sceReserve( (void **)&scene->objects, &scene->objectCapacity, scene->objectCount + 1, sizeof(Object*) ) )
 			{
-				fprintf( stderr, "sceLoad: Foi ultrapassado o limite de definicoes de objetos na cena. Ignorando." );
+				fprintf( stderr, "sceLoad: Memoria insuficiente para os objetos da cena. Ignorando." );
 				continue;
 			}
 
@@ -315,9 +362,9 @@ Scene* sceLoad( const char *filename )
 		} 
 		else if( sscanf( buffer, "TRIANGLE %d %lf %lf %lf %lf %lf %lf %lf %lf %lf %lf %lf %lf %lf %lf %lf %lf\n", &material, &pos1.x, &pos1.y, &pos1.z, &pos2.x, &pos2.y, &pos2.z, &pos3.x, &pos3.y, &pos3.z, &tex1.x, &tex1.y, &tex2.x, &tex2.y, &tex3.x, &tex3.y) == 16 ) 
 		{
-			if( scene->objectCount >= MAX_OBJECTS )
+			if( !sceReserve( (void **)&scene->objects, &scene->objectCapacity, scene->objectCount + 1, sizeof(Object*) ) )
 			{
-				fprintf( stderr, "sceLoad: Foi ultrapassado o limite de definicoes de objetos na cena. Ignorando." );
+				fprintf( stderr, "sceLoad: Memoria insuficiente para os objetos da cena. Ignorando." );
 				continue;
 			}
 			
@@ -325,9 +372,9 @@ Scene* sceLoad( const char *filename )
 		}
 	  	else if( sscanf( buffer, "BOX %d %lf %lf %lf %lf %lf %lf\n", &material, &pos1.x, &pos1.y, &pos1.z, &pos2.x, &pos2.y, &pos2.z ) == 7 ) 
 		{
-			if( scene->objectCount >= MAX_OBJECTS )
+			if( !sceReserve( (void **)&scene->objects, &scene->objectCapacity, scene->objectCount + 1, sizeof(Object*) ) )
 			{
-				fprintf( stderr, "sceLoad: Foi ultrapassado o limite de definicoes de objetos na cena. Ignorando." );
+				fprintf( stderr, "sceLoad: Memoria insuficiente para os objetos da cena. Ignorando." );
 				continue;
 			}
 
@@ -387,7 +434,82 @@ void sceDestroy( Scene* scene )
 	{
 		matDestroy( scene->materials[i] );
 	}
+
+	for( i = 0; i < scene->lightCount; ++i )
+	{
+		lightDestroy( scene->lights[i] );
+	}
+
+	free( scene->objects );
+	free( scene->materials );
+	free( scene->lights );
 	
 	free( scene );
 }
 
+/************************************************************************/
+/* Definio das Funes Privadas                                       */
+/************************************************************************/
+static void sceCountCommands( FILE *file, int *materialCount, int *lightCount, int *objectCount )
+{
+	char buffer[512];
+	int lineStart = 1;
+
+	*materialCount = 0;
+	*lightCount = 0;
+	*objectCount = 0;
+
+	while( fgets( buffer, sizeof(buffer), file ) )
+	{
+		if( lineStart )
+		{
+			if( strncmp( buffer, "MATERIAL", 8 ) == 0 )
+			{
+				++*materialCount;
+			}
+			else if( strncmp( buffer, "LIGHT", 5 ) == 0 )
+			{
+				++*lightCount;
+			}
+			else if( strncmp( buffer, "SPHERE", 6 ) == 0 || strncmp( buffer, "TRIANGLE", 8 ) == 0 ||
+					 strncmp( buffer, "BOX", 3 ) == 0 )
+			{
+				++*objectCount;
+			}
+		}
+
+		/* Linhas maiores que o buffer so lidas em pedaos: s o primeiro conta */
+		lineStart = ( strchr( buffer, '\n' ) != NULL );
+	}
+
+	rewind( file );
+}
+
+static int sceReserve( void **array, int *capacity, int required, size_t size )
+{
+	int newCapacity;
+	void *newArray;
+
+	if( required <= *capacity )
+	{
+		return 1;
+	}
+
+	newCapacity = ( *capacity > 0 ) ? *capacity : 16;
+	while( newCapacity < required )
+	{
+		newCapacity *= 2;
+	}
+
+	newArray = realloc( *array, newCapacity * size );
+	if( !newArray )
+	{
+		return 0;
+	}
+
+	*array = newArray;
+	*capacity = newCapacity;
+
+	return 1;
+}
+
@@ -25,9 +25,6 @@
 /************************************************************************/
 /* Constantes Exportadas                                                */
 /************************************************************************/
-#define MAX_MATERIALS	64
-#define MAX_OBJECTS		128
-#define MAX_LIGHTS		100
 #define FILENAME_MAXLEN	64
 
 #ifndef EPSILON
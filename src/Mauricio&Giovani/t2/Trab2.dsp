@@ -91,6 +91,14 @@ SOURCE=.\algebra.c
 # End Source File
 # Begin Source File
 
+SOURCE=.\binary.c
+# End Source File
+# Begin Source File
+
+SOURCE=.\bvh.c
+# End Source File
+# Begin Source File
+
 SOURCE=.\camera.c
 # End Source File
 # Begin Source File
@@ -115,6 +123,10 @@ SOURCE=.\mainIUP.c
 # End Source File
 # Begin Source File
 
+SOURCE=.\mapping.c
+# End Source File
+# Begin Source File
+
 SOURCE=.\material.c
 # End Source File
 # Begin Source File
@@ -123,12 +135,36 @@ SOURCE=.\object.c
 # End Source File
 # Begin Source File
 
+SOURCE=.\packet.c
+# End Source File
+# Begin Source File
+
+SOURCE=.\primitive.c
+# End Source File
+# Begin Source File
+
 SOURCE=.\raytracing.c
 # End Source File
 # Begin Source File
 
 SOURCE=.\scene.c
 # End Source File
+# Begin Source File
+
+SOURCE=.\screen.c
+# End Source File
+# Begin Source File
+
+SOURCE=.\texture.c
+# End Source File
+# Begin Source File
+
+SOURCE=.\thread.c
+# End Source File
+# Begin Source File
+
+SOURCE=.\tokenizer.c
+# End Source File
 # End Group
 # Begin Group "Header Files"
 
@@ -139,6 +175,14 @@ SOURCE=.\algebra.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\binary.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\bvh.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\camera.h
 # End Source File
 # Begin Source File
@@ -155,6 +199,10 @@ SOURCE=.\light.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\mapping.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\material.h
 # End Source File
 # Begin Source File
@@ -163,12 +211,36 @@ SOURCE=.\object.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\packet.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\primitive.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\raytracing.h
 # End Source File
 # Begin Source File
 
 SOURCE=.\scene.h
 # End Source File
+# Begin Source File
+
+SOURCE=.\screen.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\texture.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\thread.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\tokenizer.h
+# End Source File
 # End Group
 # Begin Group "Resource Files"
 
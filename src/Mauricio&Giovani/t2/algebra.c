@@ -13,6 +13,9 @@
 #include <stdio.h>
 #include <math.h>
 #include <stdarg.h>
+
+/* As funes exportadas so definidas a partir das verses em linha do cabealho */
+#define ALGEBRA_NO_INLINE
 #include "algebra.h"
 
 #ifndef M_PI
@@ -27,8 +30,7 @@
 
 Vector algVector( real x, real y, real z, real w ) 
 {
-  Vector v = {x, y, z, w};
-  return v;
+  return algVectorInline( x, y, z, w );
 }
 
 real algGetX(Vector vector) 
@@ -65,46 +67,37 @@ Vector algCartesian( Vector vector )
 
 Vector algAdd( Vector v1, Vector v2 ) 
 {
-  Vector v = {v1.x + v2.x, v1.y + v2.y, v1.z + v2.z, v1.w};
-  return v;
+  return algAddInline( v1, v2 );
 }
 
 Vector algScale( real scalar, Vector vector ) 
 {
-  Vector v = {scalar*vector.x, scalar*vector.y, scalar*vector.z, vector.w};
-  return v;
+  return algScaleInline( scalar, vector );
 }
 
 Vector algSub( Vector v1, Vector v2 ) 
 {
-  Vector v = {v1.x - v2.x, v1.y - v2.y, v1.z - v2.z, v1.w};
-  return v;
+  return algSubInline( v1, v2 );
 }
 
 Vector algMinus( Vector vector ) 
 {
-  Vector v = {-vector.x, -vector.y, -vector.z, vector.w};
-  return v;
+  return algMinusInline( vector );
 }
 
 real algNorm( Vector vector ) 
 {
-  return (real) sqrt(vector.x*vector.x + vector.y*vector.y + vector.z*vector.z);
+  return algNormInline( vector );
 }
 
 Vector algUnit( Vector vector ) 
 {
-  real n = algNorm(vector);
-  if ( n > 1e-9 ) {
-    return algScale(1/n, vector);
-  } else {
-    return vector;
-  }
+  return algUnitInline( vector );
 }
 
 real algDot( Vector v1, Vector v2 ) 
 {
-  return v1.x*v2.x + v1.y*v2.y + v1.z*v2.z;
+  return algDotInline( v1, v2 );
 }
 
 real algDot4( Vector v1, Vector v2 ) 
@@ -114,29 +107,17 @@ real algDot4( Vector v1, Vector v2 )
 
 Vector algProj( Vector ofVector, Vector ontoVector ) 
 {
-	Vector vProjectVector;
-	real fNewScale = algDot(ofVector, ontoVector)/algDot(ontoVector,ontoVector);
-	vProjectVector = algScale(fNewScale , ontoVector);
-	return vProjectVector;
+  return algProjInline( ofVector, ontoVector );
 }
 
 Vector algCross( Vector v1, Vector v2 ) 
 {
-  Vector v = {
-    v1.y*v2.z - v1.z*v2.y, 
-    v1.z*v2.x - v1.x*v2.z, 
-    v1.x*v2.y - v1.y*v2.x,
-    1
-  };
-  return v;
+  return algCrossInline( v1, v2 );
 }
 
 Vector algReflect( Vector ofVector, Vector aroundVector ) 
 {
- Vector vProj = algProj(ofVector,aroundVector);
- Vector vIncrH = algSub(vProj,ofVector);
- Vector vReflect = algAdd(vProj, vIncrH);
- return vReflect;
+  return algReflectInline( ofVector, aroundVector );
 }
 
 Vector algLinComb( int count, ... ) 
@@ -159,6 +140,11 @@ Vector algLinComb( int count, ... )
 	return result;
 }
 
+Vector algLinComb2( real s1, Vector v1, real s2, Vector v2 ) 
+{
+  return algLinComb2Inline( s1, v1, s2, v2 );
+}
+
 Matrix algMatrix4x4( real a11, real a12, real a13, real a14, 
                      real a21, real a22, real a23, real a24,
                      real a31, real a32, real a33, real a34,
@@ -727,7 +713,7 @@ Vector algSnell(Vector in, Vector normal, double n1, double n2)
 
 	c_out = sqrt(1-s_out*s_in) ;
 	t     = algUnit(vt);
-	r     = algLinComb(2, s_out, t, c_out, normal) ;
+	r     = algLinComb2(s_out, t, c_out, normal) ;
 
 	return r;
 }
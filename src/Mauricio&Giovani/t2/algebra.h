@@ -13,6 +13,8 @@
 #ifndef   _ALGEBRA_H_
 #define   _ALGEBRA_H_
 
+#include <math.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -23,29 +25,57 @@ extern "C" {
 
 #define real double
 
+/**
+ *   Tipo das componentes de Vector (e de Color, veja color.h).
+ *
+ *   Compilando com ALGEBRA_FLOAT definido, as componentes so float e cada vetor
+ *   ocupa 16 bytes alinhados, metade do tamanho em double: x, y e z preenchem um
+ *   registrador SSE e w ocupa a posio que sobraria como enchimento. Matrizes e
+ *   quatrnios continuam em double, e as funes deste mdulo continuam recebendo
+ *   e retornando escalares em double.
+ */
+#ifdef ALGEBRA_FLOAT
+typedef float VectorReal;
+#else
+typedef double VectorReal;
+#endif
+
+/**
+ *   Alinhamento de 16 bytes dos vetores em preciso simples. No MSVC de 32 bits
+ *   parmetros alinhados no podem ser passados por valor, ento l o alinhamento
+ *    omitido (o tamanho continua sendo 16 bytes).
+ */
+#if defined( ALGEBRA_FLOAT ) && defined( __GNUC__ )
+#define ALG_ALIGN16 __attribute__(( aligned( 16 ) ))
+#elif defined( ALGEBRA_FLOAT ) && defined( _MSC_VER ) && defined( _M_X64 )
+#define ALG_ALIGN16 __declspec( align( 16 ) )
+#else
+#define ALG_ALIGN16
+#endif
+
 /**
  *   Vetor no espao 3D homogneo.
  *   Para representar vetores 2D, use z = 0 e w = 1.
  *   Para representar vetores 3D, use w = 1.
  */
-typedef struct
+typedef struct ALG_ALIGN16
 {
 /**
  * Valor na direcao x.
  */   
-   real x;
+   VectorReal x;
 /**
  * Valor na direcao y.
  */
-   real y;
+   VectorReal y;
 /**
  * Valor na direcao z (z = 0 para vetores 2D).
  */
-   real z;
+   VectorReal z;
 /**
  * Valor de w (w = 1 para vetores 2D e 3D).
  */
-   real w;
+   VectorReal w;
 }
 Vector;
 
@@ -196,6 +226,12 @@ Vector algReflect( Vector ofVector, Vector aroundVector );
  */
 Vector algLinComb( int count, ... );
 
+/**
+ *   Combinao linear de 2 vetores: s1 * v1 + s2 * v2 (w = 1).
+ *   Mesmo resultado de algLinComb( 2, s1, v1, s2, v2 ), sem argumentos variveis.
+ */
+Vector algLinComb2( real s1, Vector v1, real s2, Vector v2 );
+
 /**
  *  Cria uma matriz 4x4.
  */
@@ -381,6 +417,127 @@ void algQuatPrint(char *text, Quat v);
 
 Vector algSnell(Vector in, Vector normal, double n1, double n2);
 
+
+/************************************************************************/
+/* Verses em Linha                                                     */
+/************************************************************************/
+/**
+ *   As operaes usadas nos clculos de interseo e sombreamento tambm so
+ *   definidas aqui como static inline, para que o compilador possa expandi-las
+ *   em objIntercept(), shade() etc. em vez de chamar algebra.c.
+ *
+ *   As macros abaixo redirecionam os nomes usuais para essas verses. Quem
+ *   define ALGEBRA_NO_INLINE antes de incluir este arquivo (como algebra.c)
+ *   continua chamando as funes exportadas, que permanecem disponveis.
+ */
+#if defined( _MSC_VER )
+#define ALG_INLINE static __inline
+#elif defined( __GNUC__ )
+#define ALG_INLINE static __inline__
+#else
+#define ALG_INLINE static
+#endif
+
+ALG_INLINE Vector algVectorInline( real x, real y, real z, real w )
+{
+  Vector v = {x, y, z, w};
+  return v;
+}
+
+ALG_INLINE Vector algAddInline( Vector v1, Vector v2 )
+{
+  Vector v = {v1.x + v2.x, v1.y + v2.y, v1.z + v2.z, v1.w};
+  return v;
+}
+
+ALG_INLINE Vector algScaleInline( real scalar, Vector vector )
+{
+  Vector v = {scalar*vector.x, scalar*vector.y, scalar*vector.z, vector.w};
+  return v;
+}
+
+ALG_INLINE Vector algSubInline( Vector v1, Vector v2 )
+{
+  Vector v = {v1.x - v2.x, v1.y - v2.y, v1.z - v2.z, v1.w};
+  return v;
+}
+
+ALG_INLINE Vector algMinusInline( Vector vector )
+{
+  Vector v = {-vector.x, -vector.y, -vector.z, vector.w};
+  return v;
+}
+
+ALG_INLINE real algNormInline( Vector vector )
+{
+  return (real) sqrt(vector.x*vector.x + vector.y*vector.y + vector.z*vector.z);
+}
+
+ALG_INLINE Vector algUnitInline( Vector vector )
+{
+  real n = algNormInline(vector);
+  if ( n > 1e-9 ) {
+    return algScaleInline(1/n, vector);
+  } else {
+    return vector;
+  }
+}
+
+ALG_INLINE real algDotInline( Vector v1, Vector v2 )
+{
+  return v1.x*v2.x + v1.y*v2.y + v1.z*v2.z;
+}
+
+ALG_INLINE Vector algProjInline( Vector ofVector, Vector ontoVector )
+{
+  real fNewScale = algDotInline(ofVector, ontoVector)/algDotInline(ontoVector,ontoVector);
+  return algScaleInline(fNewScale , ontoVector);
+}
+
+ALG_INLINE Vector algCrossInline( Vector v1, Vector v2 )
+{
+  Vector v = {
+    v1.y*v2.z - v1.z*v2.y, 
+    v1.z*v2.x - v1.x*v2.z, 
+    v1.x*v2.y - v1.y*v2.x,
+    1
+  };
+  return v;
+}
+
+ALG_INLINE Vector algReflectInline( Vector ofVector, Vector aroundVector )
+{
+  Vector vProj = algProjInline(ofVector,aroundVector);
+  Vector vIncrH = algSubInline(vProj,ofVector);
+  return algAddInline(vProj, vIncrH);
+}
+
+ALG_INLINE Vector algLinComb2Inline( real s1, Vector v1, real s2, Vector v2 )
+{
+  Vector v = {
+    s1*v1.x + s2*v2.x,
+    s1*v1.y + s2*v2.y,
+    s1*v1.z + s2*v2.z,
+    1
+  };
+  return v;
+}
+
+#ifndef ALGEBRA_NO_INLINE
+#define algVector( x, y, z, w )				algVectorInline( x, y, z, w )
+#define algAdd( v1, v2 )					algAddInline( v1, v2 )
+#define algScale( scalar, vector )			algScaleInline( scalar, vector )
+#define algSub( v1, v2 )					algSubInline( v1, v2 )
+#define algMinus( vector )					algMinusInline( vector )
+#define algNorm( vector )					algNormInline( vector )
+#define algUnit( vector )					algUnitInline( vector )
+#define algDot( v1, v2 )					algDotInline( v1, v2 )
+#define algProj( ofVector, ontoVector )		algProjInline( ofVector, ontoVector )
+#define algCross( v1, v2 )					algCrossInline( v1, v2 )
+#define algReflect( ofVector, aroundVector ) algReflectInline( ofVector, aroundVector )
+#define algLinComb2( s1, v1, s2, v2 )		algLinComb2Inline( s1, v1, s2, v2 )
+#endif
+
 #undef real
 
 #ifdef __cplusplus
@@ -0,0 +1,761 @@
+/**
+ *	@file binary.c Binary: cenas compiladas. Uma cena lida de um arquivo rt4 pode ser
+ *		gravada em um formato binrio que j contm a geometria, a hierarquia de
+ *		volumes envolventes e os vetores de primitivas exatamente como ficam em
+ *		memria. Ao ser lido, o arquivo  mapeado em memria e usado diretamente,
+ *		sem interpretao de texto nem construo da hierarquia.
+ *
+ *		O arquivo comea com um cabealho (BinHeader) seguido de sees alinhadas a
+ *		BINARY_ALIGNMENT bytes, na ordem de BinSectionIndex. Materiais e luzes so
+ *		poucos e so recriados na leitura; todo o resto  usado no lugar.
+ *
+ *	@date
+ *			Criado em:			17 de Outubro de 2026
+ *
+ *	@version 2.0
+ */
+
+#include "binary.h"
+#include "texture.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+
+/************************************************************************/
+/* Constantes Privadas                                                  */
+/************************************************************************/
+#define BINARY_MAGIC		"RT4B"
+#define BINARY_VERSION		2
+
+/** Gravado como long: lido com outra ordem de bytes, o valor no confere */
+#define BINARY_BYTE_ORDER	0x01020304L
+
+/** Alinhamento das sees, suficiente para os vetores alinhados de ALGEBRA_FLOAT */
+#define BINARY_ALIGNMENT	16
+
+#define ALIGN( size )	( ( ( size ) + BINARY_ALIGNMENT - 1 ) & ~(unsigned long)( BINARY_ALIGNMENT - 1 ) )
+
+/**
+ *   Sees do arquivo, na ordem em que so gravadas.
+ */
+typedef enum
+{
+	SECTION_MATERIALS,			/* BinMaterial[materialCount] */
+	SECTION_LIGHTS,				/* BinLight[lightCount] */
+	SECTION_OBJECTS,			/* BinObject[objectCount], na ordem original */
+	SECTION_SPHERES,			/* Sphere[], na ordem original */
+	SECTION_TRIANGLES,			/* Triangle[], na ordem original */
+	SECTION_BOXES,				/* Box[], na ordem original */
+	SECTION_NODES,				/* BvhNode[nodeCount] */
+	SECTION_LEAVES,				/* BvhLeaf[leafCount] */
+	SECTION_SPHERE_ARRAYS,		/* SphereArray: PRIM_SPHERE_ARRAYS vetores e os ids */
+	SECTION_TRIANGLE_ARRAYS,	/* TriangleArray: PRIM_TRIANGLE_ARRAYS vetores e os ids */
+	SECTION_BOX_ARRAYS,			/* BoxArray: PRIM_BOX_ARRAYS vetores e os ids */
+	SECTION_COUNT
+}
+BinSectionIndex;
+
+
+/************************************************************************/
+/* Tipos Privados                                                       */
+/************************************************************************/
+/**
+ *   Posio de uma seo no arquivo e seu nmero de elementos.
+ */
+typedef struct
+{
+	unsigned long offset;
+	long count;
+}
+BinSection;
+
+/**
+ *   Cabealho do arquivo.
+ */
+typedef struct
+{
+	char magic[4];
+	long version;
+	long byteOrder;
+
+	/**
+	 *  Tamanhos dos tipos gravados como esto em memria. O arquivo s  aceito
+	 *  por uma compilao em que todos conferem.
+	 */
+	long headerSize;
+	long realSize;
+	long sphereSize;
+	long triangleSize;
+	long boxSize;
+	long nodeSize;
+	long leafSize;
+
+	/**
+	 *  Cmera (hasCamera  zero se o arquivo rt4 no definia uma).
+	 */
+	int hasCamera;
+	double eye[3];
+	double at[3];
+	double up[3];
+	double fovy;
+	double nearp;
+	double farp;
+	int screenWidth;
+	int screenHeight;
+
+	/**
+	 *  Fundo e luz ambiente (cores j normalizadas).
+	 */
+	double bgColor[3];
+	double ambientLight[3];
+	char bgFileName[FILENAME_MAXLEN];
+
+	BinSection sections[SECTION_COUNT];
+}
+BinHeader;
+
+typedef struct
+{
+	double diffuse[3];
+	double specular[3];
+	double specularExponent;
+	double reflectionFactor;
+	double refractionFactor;
+	double opacityFactor;
+	char textureFileName[FILENAME_MAXLEN];
+}
+BinMaterial;
+
+typedef struct
+{
+	double position[3];
+	double color[3];
+	/**
+	 *  Forma (LightType), raio das esferas e lados dos retngulos.
+	 */
+	int type;
+	int samples;
+	double radius;
+	double edgeU[3];
+	double edgeV[3];
+}
+BinLight;
+
+/**
+ *   Objeto: tipo, material e posio da sua geometria na seo do seu tipo.
+ */
+typedef struct
+{
+	int type;
+	int material;
+	long index;
+}
+BinObject;
+
+
+/************************************************************************/
+/* Funes Privadas                                                     */
+/************************************************************************/
+/**
+ *	Preenche os campos do cabealho que identificam o formato desta compilao.
+ */
+static void binSetLayout( BinHeader *header );
+
+/**
+ *	Tamanho em bytes de um elemento das sees com registros de tamanho fixo.
+ */
+static unsigned long binElementSize( int section );
+
+/**
+ *	Calcula o tamanho em bytes de uma seo com 'count' elementos, j alinhado.
+ */
+static unsigned long binSectionSize( int section, long count );
+
+/**
+ *	Obtm os vetores de componentes de cada tipo de primitiva, na ordem em que so gravados.
+ *
+ *	@return Nmero de vetores.
+ */
+static int binSphereArrays( SphereArray *spheres, VectorReal ***arrays );
+static int binTriangleArrays( TriangleArray *triangles, VectorReal ***arrays );
+static int binBoxArrays( BoxArray *boxes, VectorReal ***arrays );
+
+/**
+ *	Grava 'size' bytes seguidos de zeros at o prximo mltiplo de BINARY_ALIGNMENT.
+ *	O tamanho alinhado deve ser igual a binSectionSize() da seo.
+ *
+ *	@return No-zero em caso de sucesso.
+ */
+static int binWrite( FILE *file, const void *data, unsigned long size );
+static int binPad( FILE *file, unsigned long size );
+
+/**
+ *	Grava os vetores de componentes e os ids de um tipo de primitiva.
+ */
+static int binWriteArrays( FILE *file, VectorReal **arrays[], int arrayCount, const int *ids, long count );
+
+/**
+ *	Faz os vetores de componentes e os ids de um tipo de primitiva apontarem para o mapeamento.
+ */
+static void binMapArrays( const char *data, VectorReal **arrays[], int arrayCount, int **ids, long count );
+
+static void binCopy3( double dst[3], VectorReal x, VectorReal y, VectorReal z );
+
+
+/************************************************************************/
+/* Definio das Funes Exportadas                                     */
+/************************************************************************/
+int binSave( Scene scene, const char *filename )
+{
+	static const int objectSections[4] = { -1, SECTION_SPHERES, SECTION_TRIANGLES, SECTION_BOXES };
+	BinHeader header;
+	FILE *file;
+	Bvh bvh = scene->bvh;
+	PrimitiveStore store;
+	VectorReal **arrays[PRIM_TRIANGLE_ARRAYS];
+	unsigned long offset;
+	long typeCount[4] = { 0, 0, 0, 0 };
+	int ok = 1;
+	int i, t;
+
+	if( !bvh || ( !bvh->primitives && scene->objectCount > 0 ) )
+	{
+		return 0;
+	}
+
+	store = bvh->primitives;
+
+	memset( &header, 0, sizeof(header) );
+	binSetLayout( &header );
+
+	if( scene->camera )
+	{
+		header.hasCamera = 1;
+		binCopy3( header.eye, scene->camera->eye.x, scene->camera->eye.y, scene->camera->eye.z );
+		binCopy3( header.at, scene->camera->at.x, scene->camera->at.y, scene->camera->at.z );
+		binCopy3( header.up, scene->camera->up.x, scene->camera->up.y, scene->camera->up.z );
+		header.fovy = scene->camera->fovy;
+		header.nearp = scene->camera->nearp;
+		header.farp = scene->camera->farp;
+		header.screenWidth = camGetScreenWidth( scene->camera );
+		header.screenHeight = camGetScreenHeight( scene->camera );
+	}
+
+	binCopy3( header.bgColor, scene->bgColor.red, scene->bgColor.green, scene->bgColor.blue );
+	binCopy3( header.ambientLight, scene->ambientLight.red, scene->ambientLight.green, scene->ambientLight.blue );
+	strcpy( header.bgFileName, scene->bgFileName );
+
+	for( i = 0; i < scene->objectCount; ++i )
+	{
+		++typeCount[scene->objects[i]->type];
+	}
+
+	header.sections[SECTION_MATERIALS].count = scene->materialCount;
+	header.sections[SECTION_LIGHTS].count = scene->lightCount;
+	header.sections[SECTION_OBJECTS].count = scene->objectCount;
+	header.sections[SECTION_SPHERES].count = typeCount[TYPE_SPHERE];
+	header.sections[SECTION_TRIANGLES].count = typeCount[TYPE_TRIANGLE];
+	header.sections[SECTION_BOXES].count = typeCount[TYPE_BOX];
+	header.sections[SECTION_NODES].count = bvh->nodeCount;
+	header.sections[SECTION_LEAVES].count = bvhGetLeafCount( bvh );
+	header.sections[SECTION_SPHERE_ARRAYS].count = store ? store->spheres.count : 0;
+	header.sections[SECTION_TRIANGLE_ARRAYS].count = store ? store->triangles.count : 0;
+	header.sections[SECTION_BOX_ARRAYS].count = store ? store->boxes.count : 0;
+
+	offset = ALIGN( sizeof(BinHeader) );
+	for( i = 0; i < SECTION_COUNT; ++i )
+	{
+		header.sections[i].offset = offset;
+		offset += binSectionSize( i, header.sections[i].count );
+	}
+
+	file = fopen( filename, "wb" );
+	if( !file )
+	{
+		return 0;
+	}
+
+	ok = binWrite( file, &header, sizeof(header) );
+
+	for( i = 0; ok && i < scene->materialCount; ++i )
+	{
+		Material material = scene->materials[i];
+		BinMaterial record;
+
+		memset( &record, 0, sizeof(record) );
+		binCopy3( record.diffuse, material->diffuseColor.red, material->diffuseColor.green, material->diffuseColor.blue );
+		binCopy3( record.specular, material->specularColor.red, material->specularColor.green, material->specularColor.blue );
+		record.specularExponent = material->specularExponent;
+		record.reflectionFactor = material->reflectionFactor;
+		record.refractionFactor = material->refractionFactor;
+		record.opacityFactor = material->opacityFactor;
+		strcpy( record.textureFileName, scene->textureFileNames[i] );
+
+		ok = ( fwrite( &record, sizeof(record), 1, file ) == 1 );
+	}
+	ok = ok && binPad( file, scene->materialCount * sizeof(BinMaterial) );
+
+	for( i = 0; ok && i < scene->lightCount; ++i )
+	{
+		Light light = scene->lights[i];
+		Vector position = lightGetPosition( light );
+		Color color = lightGetColor( light );
+		BinLight record;
+
+		memset( &record, 0, sizeof(record) );
+		binCopy3( record.position, position.x, position.y, position.z );
+		binCopy3( record.color, color.red, color.green, color.blue );
+		record.type = light->type;
+		record.samples = light->samples;
+		record.radius = light->radius;
+		binCopy3( record.edgeU, light->edgeU.x, light->edgeU.y, light->edgeU.z );
+		binCopy3( record.edgeV, light->edgeV.x, light->edgeV.y, light->edgeV.z );
+
+		ok = ( fwrite( &record, sizeof(record), 1, file ) == 1 );
+	}
+	ok = ok && binPad( file, scene->lightCount * sizeof(BinLight) );
+
+	/* A geometria de cada tipo  gravada na ordem original dos objetos */
+	typeCount[TYPE_SPHERE] = typeCount[TYPE_TRIANGLE] = typeCount[TYPE_BOX] = 0;
+	for( i = 0; ok && i < scene->objectCount; ++i )
+	{
+		BinObject record;
+
+		record.type = scene->objects[i]->type;
+		record.material = scene->objects[i]->material;
+		record.index = typeCount[record.type]++;
+
+		ok = ( fwrite( &record, sizeof(record), 1, file ) == 1 );
+	}
+	ok = ok && binPad( file, scene->objectCount * sizeof(BinObject) );
+
+	for( t = TYPE_SPHERE; t <= TYPE_BOX; ++t )
+	{
+		unsigned long size = binElementSize( objectSections[t] );
+
+		for( i = 0; ok && i < scene->objectCount; ++i )
+		{
+			if( scene->objects[i]->type == t )
+			{
+				ok = ( fwrite( scene->objects[i]->data, size, 1, file ) == 1 );
+			}
+		}
+		ok = ok && binPad( file, typeCount[t] * size );
+	}
+
+	ok = ok && binWrite( file, bvh->nodes, bvh->nodeCount * sizeof(BvhNode) );
+	ok = ok && binWrite( file, bvh->leaves, header.sections[SECTION_LEAVES].count * sizeof(BvhLeaf) );
+
+	if( store )
+	{
+		ok = ok && binWriteArrays( file, arrays, binSphereArrays( &store->spheres, arrays ),
+								   store->spheres.ids, store->spheres.count );
+		ok = ok && binWriteArrays( file, arrays, binTriangleArrays( &store->triangles, arrays ),
+								   store->triangles.ids, store->triangles.count );
+		ok = ok && binWriteArrays( file, arrays, binBoxArrays( &store->boxes, arrays ),
+								   store->boxes.ids, store->boxes.count );
+	}
+
+	if( fclose( file ) != 0 )
+	{
+		ok = 0;
+	}
+
+	if( !ok )
+	{
+		remove( filename );
+	}
+
+	return ok;
+}
+
+int binIsCompiled( const char *filename )
+{
+	char magic[4];
+	FILE *file = fopen( filename, "rb" );
+	int compiled;
+
+	if( !file )
+	{
+		return 0;
+	}
+
+	compiled = ( fread( magic, 1, 4, file ) == 4 && memcmp( magic, BINARY_MAGIC, 4 ) == 0 );
+	fclose( file );
+
+	return compiled;
+}
+
+Scene binLoad( const char *filename )
+{
+	BinHeader expected;
+	const BinHeader *header;
+	const char *data;
+	const BinMaterial *materials;
+	const BinLight *lights;
+	const BinObject *objects;
+	MappedFile mapping;
+	PrimitiveStore store;
+	VectorReal **arrays[PRIM_TRIANGLE_ARRAYS];
+	Scene scene;
+	size_t size;
+	int i;
+
+	mapping = mapOpen( filename );
+	if( !mapping )
+	{
+		return NULL;
+	}
+
+	data = (const char *)mapGetData( mapping );
+	size = mapGetSize( mapping );
+	header = (const BinHeader *)data;
+
+	memset( &expected, 0, sizeof(expected) );
+	binSetLayout( &expected );
+
+	if( size < sizeof(BinHeader) || memcmp( header->magic, expected.magic, 4 ) != 0 ||
+		header->version != expected.version || header->byteOrder != expected.byteOrder ||
+		header->headerSize != expected.headerSize || header->realSize != expected.realSize ||
+		header->sphereSize != expected.sphereSize || header->triangleSize != expected.triangleSize ||
+		header->boxSize != expected.boxSize || header->nodeSize != expected.nodeSize ||
+		header->leafSize != expected.leafSize )
+	{
+		fprintf( stderr, "binLoad: %s foi compilado por outra versao do programa.\n", filename );
+		mapClose( mapping );
+		return NULL;
+	}
+
+	for( i = 0; i < SECTION_COUNT; ++i )
+	{
+		const BinSection *section = &header->sections[i];
+
+		/* Contagens absurdas so recusadas antes que binSectionSize() transborde */
+		if( section->count < 0 || (unsigned long)section->count > size ||
+			section->offset % BINARY_ALIGNMENT != 0 || section->offset > size ||
+			binSectionSize( i, section->count ) > size - section->offset )
+		{
+			fprintf( stderr, "binLoad: %s esta corrompido.\n", filename );
+			mapClose( mapping );
+			return NULL;
+		}
+	}
+
+	scene = (struct _Scene *)calloc( 1, sizeof(struct _Scene) );
+	if( !scene )
+	{
+		mapClose( mapping );
+		return NULL;
+	}
+
+	scene->mapping = mapping;
+	strcpy( scene->bgFileName, "null" );
+
+	scene->materialCount = header->sections[SECTION_MATERIALS].count;
+	scene->lightCount = header->sections[SECTION_LIGHTS].count;
+	scene->objectCount = header->sections[SECTION_OBJECTS].count;
+	scene->materialCapacity = scene->textureFileNameCapacity = scene->materialCount;
+	scene->lightCapacity = scene->lightCount;
+	scene->objectCapacity = scene->objectCount;
+
+	scene->materials = (Material *)calloc( scene->materialCount + 1, sizeof(Material) );
+	scene->textureFileNames = (char (*)[FILENAME_MAXLEN])calloc( scene->materialCount + 1, FILENAME_MAXLEN );
+	scene->lights = (Light *)calloc( scene->lightCount + 1, sizeof(Light) );
+	scene->objects = (Object *)calloc( scene->objectCount + 1, sizeof(Object) );
+	scene->objectBlock = (struct _Object *)malloc( ( scene->objectCount + 1 ) * sizeof(struct _Object) );
+	store = (struct _PrimitiveStore *)calloc( 1, sizeof(struct _PrimitiveStore) );
+
+	if( !scene->materials || !scene->textureFileNames || !scene->lights || !scene->objects ||
+		!scene->objectBlock || !store )
+	{
+		/* Os contadores s valem depois que os vetores forem preenchidos */
+		scene->materialCount = scene->lightCount = scene->objectCount = 0;
+		free( store );
+		sceDestroy( scene );
+		return NULL;
+	}
+
+	if( header->hasCamera )
+	{
+		scene->camera = camCreate( algVector( header->eye[0], header->eye[1], header->eye[2], 1 ),
+								   algVector( header->at[0], header->at[1], header->at[2], 1 ),
+								   algVector( header->up[0], header->up[1], header->up[2], 1 ),
+								   header->fovy, header->nearp, header->farp,
+								   header->screenWidth, header->screenHeight );
+	}
+
+	scene->bgColor.red = (VectorReal)header->bgColor[0];
+	scene->bgColor.green = (VectorReal)header->bgColor[1];
+	scene->bgColor.blue = (VectorReal)header->bgColor[2];
+	scene->ambientLight.red = (VectorReal)header->ambientLight[0];
+	scene->ambientLight.green = (VectorReal)header->ambientLight[1];
+	scene->ambientLight.blue = (VectorReal)header->ambientLight[2];
+
+	memcpy( scene->bgFileName, header->bgFileName, FILENAME_MAXLEN );
+	scene->bgFileName[FILENAME_MAXLEN - 1] = '\0';
+	if( strcmp( scene->bgFileName, "null" ) != 0 )
+	{
+		scene->bgImage = imageLoad( scene->bgFileName );
+		if( scene->camera && scene->bgImage )
+		{
+			scene->bgImage = imageResize( scene->bgImage, camGetScreenWidth( scene->camera ),
+										  camGetScreenHeight( scene->camera ) );
+		}
+	}
+
+	materials = (const BinMaterial *)( data + header->sections[SECTION_MATERIALS].offset );
+	for( i = 0; i < scene->materialCount; ++i )
+	{
+		const BinMaterial *record = &materials[i];
+		Texture texture = NULL;
+		Color diffuse, specular;
+
+		memcpy( scene->textureFileNames[i], record->textureFileName, FILENAME_MAXLEN );
+		scene->textureFileNames[i][FILENAME_MAXLEN - 1] = '\0';
+		if( strcmp( scene->textureFileNames[i], "null" ) != 0 )
+		{
+			texture = texAcquire( scene->textureFileNames[i] );
+		}
+
+		diffuse.red = (VectorReal)record->diffuse[0];
+		diffuse.green = (VectorReal)record->diffuse[1];
+		diffuse.blue = (VectorReal)record->diffuse[2];
+		specular.red = (VectorReal)record->specular[0];
+		specular.green = (VectorReal)record->specular[1];
+		specular.blue = (VectorReal)record->specular[2];
+
+		scene->materials[i] = matCreate( texture, diffuse, specular, record->specularExponent,
+										 record->reflectionFactor, record->refractionFactor, record->opacityFactor );
+	}
+
+	lights = (const BinLight *)( data + header->sections[SECTION_LIGHTS].offset );
+	for( i = 0; i < scene->lightCount; ++i )
+	{
+		const BinLight *record = &lights[i];
+		Vector position = algVector( record->position[0], record->position[1], record->position[2], 1 );
+		Color color;
+
+		color.red = (VectorReal)record->color[0];
+		color.green = (VectorReal)record->color[1];
+		color.blue = (VectorReal)record->color[2];
+
+		switch( record->type )
+		{
+		case LIGHT_SPHERE:
+			scene->lights[i] = lightCreateSphere( position, record->radius, color, record->samples );
+			break;
+
+		case LIGHT_QUAD:
+			scene->lights[i] = lightCreateQuad( position,
+												algVector( record->edgeU[0], record->edgeU[1], record->edgeU[2], 0 ),
+												algVector( record->edgeV[0], record->edgeV[1], record->edgeV[2], 0 ),
+												color, record->samples );
+			break;
+
+		default:
+			scene->lights[i] = lightCreate( position, color );
+			break;
+		}
+	}
+
+	/* Os objetos apontam para a geometria no mapeamento: nada  copiado */
+	objects = (const BinObject *)( data + header->sections[SECTION_OBJECTS].offset );
+	for( i = 0; i < scene->objectCount; ++i )
+	{
+		const BinObject *record = &objects[i];
+		struct _Object *object = &scene->objectBlock[i];
+		int section = ( record->type == TYPE_SPHERE ) ? SECTION_SPHERES :
+					  ( record->type == TYPE_TRIANGLE ) ? SECTION_TRIANGLES :
+					  ( record->type == TYPE_BOX ) ? SECTION_BOXES : -1;
+
+		if( section < 0 || record->index < 0 || record->index >= header->sections[section].count ||
+			record->material < 0 || record->material >= scene->materialCount )
+		{
+			fprintf( stderr, "binLoad: %s esta corrompido.\n", filename );
+			scene->objectCount = i;
+			free( store );
+			sceDestroy( scene );
+			return NULL;
+		}
+
+		object->type = record->type;
+		object->material = record->material;
+		object->data = (void *)( data + header->sections[section].offset +
+								 record->index * binElementSize( section ) );
+		scene->objects[i] = object;
+	}
+
+	store->spheres.count = header->sections[SECTION_SPHERE_ARRAYS].count;
+	binMapArrays( data + header->sections[SECTION_SPHERE_ARRAYS].offset, arrays,
+				  binSphereArrays( &store->spheres, arrays ), &store->spheres.ids, store->spheres.count );
+
+	store->triangles.count = header->sections[SECTION_TRIANGLE_ARRAYS].count;
+	binMapArrays( data + header->sections[SECTION_TRIANGLE_ARRAYS].offset, arrays,
+				  binTriangleArrays( &store->triangles, arrays ), &store->triangles.ids, store->triangles.count );
+
+	store->boxes.count = header->sections[SECTION_BOX_ARRAYS].count;
+	binMapArrays( data + header->sections[SECTION_BOX_ARRAYS].offset, arrays,
+				  binBoxArrays( &store->boxes, arrays ), &store->boxes.ids, store->boxes.count );
+
+	if( !bvhCheckMapped( (const BvhNode *)( data + header->sections[SECTION_NODES].offset ),
+						 header->sections[SECTION_NODES].count,
+						 (const BvhLeaf *)( data + header->sections[SECTION_LEAVES].offset ),
+						 header->sections[SECTION_LEAVES].count, store, scene->objectCount ) )
+	{
+		fprintf( stderr, "binLoad: %s esta corrompido.\n", filename );
+		free( store );
+		sceDestroy( scene );
+		return NULL;
+	}
+
+	scene->bvh = bvhCreateMapped( (const BvhNode *)( data + header->sections[SECTION_NODES].offset ),
+								  header->sections[SECTION_NODES].count,
+								  (const BvhLeaf *)( data + header->sections[SECTION_LEAVES].offset ),
+								  store, scene->objects, scene->objectCount );
+	if( !scene->bvh )
+	{
+		free( store );
+	}
+
+	return scene;
+}
+
+
+/************************************************************************/
+/* Definio das Funes Privadas                                       */
+/************************************************************************/
+static void binSetLayout( BinHeader *header )
+{
+	memcpy( header->magic, BINARY_MAGIC, 4 );
+	header->version = BINARY_VERSION;
+	header->byteOrder = BINARY_BYTE_ORDER;
+	header->headerSize = sizeof(BinHeader);
+	header->realSize = sizeof(VectorReal);
+	header->sphereSize = sizeof(Sphere);
+	header->triangleSize = sizeof(Triangle);
+	header->boxSize = sizeof(Box);
+	header->nodeSize = sizeof(BvhNode);
+	header->leafSize = sizeof(BvhLeaf);
+}
+
+static unsigned long binElementSize( int section )
+{
+	switch( section )
+	{
+	case SECTION_MATERIALS:	return sizeof(BinMaterial);
+	case SECTION_LIGHTS:	return sizeof(BinLight);
+	case SECTION_OBJECTS:	return sizeof(BinObject);
+	case SECTION_SPHERES:	return sizeof(Sphere);
+	case SECTION_TRIANGLES:	return sizeof(Triangle);
+	case SECTION_BOXES:		return sizeof(Box);
+	case SECTION_NODES:		return sizeof(BvhNode);
+	case SECTION_LEAVES:	return sizeof(BvhLeaf);
+	default:				return 0;
+	}
+}
+
+static unsigned long binSectionSize( int section, long count )
+{
+	unsigned long n = (unsigned long)count;
+	unsigned long ids = ALIGN( n * sizeof(int) );
+	unsigned long components = ALIGN( n * sizeof(VectorReal) );
+
+	switch( section )
+	{
+	case SECTION_SPHERE_ARRAYS:		return PRIM_SPHERE_ARRAYS * components + ids;
+	case SECTION_TRIANGLE_ARRAYS:	return PRIM_TRIANGLE_ARRAYS * components + ids;
+	case SECTION_BOX_ARRAYS:		return PRIM_BOX_ARRAYS * components + ids;
+	default:						return ALIGN( n * binElementSize( section ) );
+	}
+}
+
+static int binSphereArrays( SphereArray *spheres, VectorReal ***arrays )
+{
+	arrays[0] = &spheres->centerX;
+	arrays[1] = &spheres->centerY;
+	arrays[2] = &spheres->centerZ;
+	arrays[3] = &spheres->radius;
+
+	return PRIM_SPHERE_ARRAYS;
+}
+
+static int binTriangleArrays( TriangleArray *triangles, VectorReal ***arrays )
+{
+	arrays[0] = &triangles->v0X;
+	arrays[1] = &triangles->v0Y;
+	arrays[2] = &triangles->v0Z;
+	arrays[3] = &triangles->edge1X;
+	arrays[4] = &triangles->edge1Y;
+	arrays[5] = &triangles->edge1Z;
+	arrays[6] = &triangles->edge2X;
+	arrays[7] = &triangles->edge2Y;
+	arrays[8] = &triangles->edge2Z;
+
+	return PRIM_TRIANGLE_ARRAYS;
+}
+
+static int binBoxArrays( BoxArray *boxes, VectorReal ***arrays )
+{
+	arrays[0] = &boxes->minX;
+	arrays[1] = &boxes->minY;
+	arrays[2] = &boxes->minZ;
+	arrays[3] = &boxes->maxX;
+	arrays[4] = &boxes->maxY;
+	arrays[5] = &boxes->maxZ;
+
+	return PRIM_BOX_ARRAYS;
+}
+
+static int binWrite( FILE *file, const void *data, unsigned long size )
+{
+	if( size > 0 && fwrite( data, size, 1, file ) != 1 )
+	{
+		return 0;
+	}
+
+	return binPad( file, size );
+}
+
+static int binPad( FILE *file, unsigned long size )
+{
+	static const char zeros[BINARY_ALIGNMENT] = { 0 };
+	unsigned long padding = ALIGN( size ) - size;
+
+	return ( padding == 0 || fwrite( zeros, padding, 1, file ) == 1 );
+}
+
+static int binWriteArrays( FILE *file, VectorReal **arrays[], int arrayCount, const int *ids, long count )
+{
+	int k;
+
+	for( k = 0; k < arrayCount; ++k )
+	{
+		if( !binWrite( file, *arrays[k], count * sizeof(VectorReal) ) )
+		{
+			return 0;
+		}
+	}
+
+	return binWrite( file, ids, count * sizeof(int) );
+}
+
+static void binMapArrays( const char *data, VectorReal **arrays[], int arrayCount, int **ids, long count )
+{
+	unsigned long stride = ALIGN( count * sizeof(VectorReal) );
+	int k;
+
+	for( k = 0; k < arrayCount; ++k )
+	{
+		*arrays[k] = (VectorReal *)( data + k * stride );
+	}
+
+	*ids = (int *)( data + arrayCount * stride );
+}
+
+static void binCopy3( double dst[3], VectorReal x, VectorReal y, VectorReal z )
+{
+	dst[0] = x;
+	dst[1] = y;
+	dst[2] = z;
+}
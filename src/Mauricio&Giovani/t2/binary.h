@@ -0,0 +1,58 @@
+/**
+ *	@file binary.h Binary: cenas compiladas. Uma cena lida de um arquivo rt4 pode ser
+ *		gravada em um formato binrio que j contm a geometria, a hierarquia de
+ *		volumes envolventes e os vetores de primitivas exatamente como ficam em
+ *		memria. Ao ser lido, o arquivo  mapeado em memria e usado diretamente,
+ *		sem interpretao de texto nem construo da hierarquia.
+ *
+ *		O formato depende da compilao (tamanho de VectorReal, alinhamento e ordem
+ *		dos bytes); um arquivo gravado por outra compilao  recusado.
+ *
+ *	@date
+ *			Criado em:			17 de Outubro de 2026
+ *
+ *	@version 2.0
+ */
+
+#ifndef _BINARY_H_
+#define _BINARY_H_
+
+#include "scene.h"
+
+
+/************************************************************************/
+/* Constantes Exportadas                                                */
+/************************************************************************/
+/** Extenso usual dos arquivos de cena compilada */
+#define BINARY_EXTENSION	".rtb"
+
+
+/************************************************************************/
+/* Funes Exportadas                                                   */
+/************************************************************************/
+/**
+ *	Grava uma cena em formato compilado.
+ *
+ *	@param scene Cena lida com sceLoad().
+ *	@param filename Nome do arquivo a ser criado.
+ *
+ *	@return No-zero em caso de sucesso e zero caso contrrio.
+ */
+int binSave( Scene scene, const char *filename );
+
+/**
+ *	Verifica se um arquivo  uma cena compilada (pela assinatura no seu incio).
+ */
+int binIsCompiled( const char *filename );
+
+/**
+ *	L uma cena compilada, mapeando o arquivo em memria. O arquivo permanece
+ *	mapeado at sceDestroy().
+ *
+ *	@param filename Nome do arquivo.
+ *
+ *	@return Cena criada (NULL se o arquivo for invlido ou de outra compilao).
+ */
+Scene binLoad( const char *filename );
+
+#endif
@@ -0,0 +1,904 @@
+/**
+ *	@file bvh.c Bvh: hierarquia de volumes envolventes (BVH) sobre os objetos de uma cena.
+ *		A hierarquia  construda uma nica vez, aps a leitura da cena, usando a
+ *		heurstica de rea de superfcie (SAH) para escolher as parties.
+ *
+ *	@date
+ *			Criado em:			17 de Outubro de 2026
+ *
+ *	@version 2.0
+ */
+
+#include "bvh.h"
+#include <math.h>
+#include <float.h>
+#include <string.h>
+#include <stdlib.h>
+
+
+/************************************************************************/
+/* Constantes Privadas                                                  */
+/************************************************************************/
+/** Nmero de intervalos usados para avaliar a SAH em cada eixo */
+#define BVH_BINS				16
+
+/** Folhas com at este nmero de objetos so aceitas se a SAH no recomendar a diviso */
+#define BVH_MAX_LEAF_SIZE		4
+
+/** Profundidade a partir da qual a SAH  abandonada em favor da diviso pela mediana */
+#define BVH_MAX_SAH_DEPTH		32
+
+/** Tamanho da pilha de percurso: suficiente para BVH_MAX_SAH_DEPTH + log2(nmero de objetos) */
+#define BVH_STACK_SIZE			64
+
+/** Custos relativos de percorrer um n e de testar um objeto */
+#define BVH_TRAVERSAL_COST		1.0
+#define BVH_INTERSECTION_COST	1.0
+
+/** Folga adicionada s caixas para que primitivas planas no tenham espessura nula */
+#define BVH_EPSILON				1.0e-6
+
+
+/************************************************************************/
+/* Tipos Privados                                                       */
+/************************************************************************/
+/**
+ *   Caixa alinhada aos eixos.
+ */
+typedef struct
+{
+	double min[3];
+	double max[3];
+}
+Bounds;
+
+/**
+ *   Estado temporrio da construo da hierarquia.
+ */
+typedef struct
+{
+	/** Caixa envolvente de cada objeto (indexada pela posio original) */
+	Bounds *bounds;
+	/** Centride de cada objeto (trs valores por objeto) */
+	double *centroids;
+	/** Permutao dos objetos, particionada durante a construo */
+	int *indices;
+	/** Ns j criados */
+	BvhNode *nodes;
+	int nodeCount;
+}
+BvhBuilder;
+
+
+/************************************************************************/
+/* Funes Privadas                                                     */
+/************************************************************************/
+/**
+ *	Constri recursivamente o n nodeIndex sobre indices[first .. first + count - 1].
+ */
+static void buildNode( BvhBuilder *builder, int nodeIndex, int first, int count, int depth );
+
+/**
+ *	Copia a geometria das folhas para o PrimitiveStore da hierarquia, folha a folha
+ *	e, dentro de cada folha, um tipo de primitiva por vez. Cada folha passa a
+ *	referenciar seu registro em leaves.
+ */
+static void storeLeaves( BvhBuilder *builder, Bvh bvh );
+
+/**
+ *	Calcula a caixa de um intervalo de objetos e a caixa dos seus centrides.
+ */
+static void computeBounds( BvhBuilder *builder, int first, int count, Bounds *bounds, Bounds *centroidBounds );
+
+/**
+ *	Escolhe a melhor partio segundo a SAH.
+ *
+ *	@return Custo da partio escolhida (DBL_MAX se nenhuma partio for possvel).
+ */
+static double findSplit( BvhBuilder *builder, int first, int count, const Bounds *bounds,
+						const Bounds *centroidBounds, int *bestAxis, int *bestBin );
+
+/**
+ *	Calcula o intervalo de bins de um centride no eixo especificado.
+ */
+static int binOf( const Bounds *centroidBounds, int axis, double centroid );
+
+/**
+ *	Testa um raio contra a caixa de um n.
+ *
+ *	@return No-zero se o raio entra na caixa antes de maxDistance. Neste caso
+ *			'entry' recebe a distncia de entrada.
+ */
+static int intersectNode( const BvhNode *node, const double origin[3], const double inverse[3],
+						 double maxDistance, double *entry );
+
+/**
+ *	Verifica recursivamente a subrvore do n index para bvhCheckMapped().
+ *
+ *	@return ndice seguinte ao ltimo n da subrvore (-1 se ela for invlida).
+ */
+static int checkNode( const BvhNode *nodes, int nodeCount, const BvhLeaf *leaves, int leafCount,
+					 PrimitiveStore primitives, int index, int depth );
+
+/**
+ *	Verifica se um intervalo [first, first + count) cabe em um vetor de 'size' elementos.
+ */
+static int checkRange( int first, int count, int size );
+
+/**
+ *	Verifica se os identificadores de um vetor de primitivas indexam objetos existentes.
+ */
+static int checkIds( const int *ids, int size, int count );
+
+static void boundsEmpty( Bounds *bounds );
+static void boundsGrow( Bounds *bounds, const Bounds *other );
+static void boundsGrowPoint( Bounds *bounds, const double point[3] );
+static double boundsArea( const Bounds *bounds );
+
+
+/************************************************************************/
+/* Definio das Funes Exportadas                                     */
+/************************************************************************/
+Bvh bvhCreate( Object *objects, int count )
+{
+	BvhBuilder builder;
+	Bvh bvh;
+	int i;
+
+	bvh = (struct _Bvh *)malloc( sizeof(struct _Bvh) );
+	if( !bvh )
+	{
+		return NULL;
+	}
+
+	bvh->nodeCount = 0;
+	bvh->nodes = NULL;
+	bvh->leaves = NULL;
+	bvh->primitives = NULL;
+	bvh->objectCount = count;
+	bvh->objects = NULL;
+	bvh->mapped = 0;
+
+	if( count == 0 )
+	{
+		return bvh;
+	}
+
+	/* Uma rvore binria com 'count' folhas tem no mximo 2 * count - 1 ns */
+	builder.bounds = (Bounds *)malloc( count * sizeof(Bounds) );
+	builder.centroids = (double *)malloc( 3 * count * sizeof(double) );
+	builder.indices = (int *)malloc( count * sizeof(int) );
+	builder.nodes = (BvhNode *)malloc( ( 2 * count - 1 ) * sizeof(BvhNode) );
+	builder.nodeCount = 1;
+	bvh->objects = (Object *)malloc( count * sizeof(Object) );
+	bvh->leaves = (BvhLeaf *)malloc( count * sizeof(BvhLeaf) );
+	bvh->primitives = primCreate( objects, count );
+
+	if( !builder.bounds || !builder.centroids || !builder.indices || !builder.nodes ||
+		!bvh->objects || !bvh->leaves || !bvh->primitives )
+	{
+		free( builder.bounds );
+		free( builder.centroids );
+		free( builder.indices );
+		free( builder.nodes );
+		bvhDestroy( bvh );
+		return NULL;
+	}
+
+	for( i = 0; i < count; ++i )
+	{
+		Vector min, max;
+		Bounds *b = &builder.bounds[i];
+
+		objGetBoundingBox( objects[i], &min, &max );
+
+		b->min[0] = min.x - BVH_EPSILON;
+		b->min[1] = min.y - BVH_EPSILON;
+		b->min[2] = min.z - BVH_EPSILON;
+		b->max[0] = max.x + BVH_EPSILON;
+		b->max[1] = max.y + BVH_EPSILON;
+		b->max[2] = max.z + BVH_EPSILON;
+
+		builder.centroids[3 * i]     = 0.5 * ( b->min[0] + b->max[0] );
+		builder.centroids[3 * i + 1] = 0.5 * ( b->min[1] + b->max[1] );
+		builder.centroids[3 * i + 2] = 0.5 * ( b->min[2] + b->max[2] );
+
+		builder.indices[i] = i;
+	}
+
+	buildNode( &builder, 0, 0, count, 0 );
+
+	memcpy( bvh->objects, objects, count * sizeof(Object) );
+	storeLeaves( &builder, bvh );
+
+	bvh->nodeCount = builder.nodeCount;
+	bvh->nodes = (BvhNode *)realloc( builder.nodes, builder.nodeCount * sizeof(BvhNode) );
+	if( !bvh->nodes )
+	{
+		bvh->nodes = builder.nodes;
+	}
+
+	free( builder.bounds );
+	free( builder.centroids );
+	free( builder.indices );
+
+	return bvh;
+}
+
+double bvhGetNearestObject( Bvh bvh, Vector eye, Vector ray, Object *object, double *u, double *v )
+{
+	int stack[BVH_STACK_SIZE];
+	double stackEntry[BVH_STACK_SIZE];
+	int top = 0;
+	int index = 0;
+
+	double origin[3];
+	double inverse[3];
+	double closest = DBL_MAX;
+	int closestIndex = -1;
+	double entry;
+
+	if( !bvh || bvh->nodeCount == 0 )
+	{
+		return DBL_MAX;
+	}
+
+	origin[0] = eye.x;
+	origin[1] = eye.y;
+	origin[2] = eye.z;
+
+	/* Componentes nulas geram infinitos, tratados corretamente pelo teste de slabs */
+	inverse[0] = 1.0 / ray.x;
+	inverse[1] = 1.0 / ray.y;
+	inverse[2] = 1.0 / ray.z;
+
+	if( !intersectNode( &bvh->nodes[0], origin, inverse, closest, &entry ) )
+	{
+		return DBL_MAX;
+	}
+
+	for( ;; )
+	{
+		const BvhNode *node = &bvh->nodes[index];
+
+		if( node->count > 0 )
+		{
+			const BvhLeaf *leaf = &bvh->leaves[node->first];
+
+			/* Folha: testa as primitivas de um tipo de cada vez */
+			primNearestSphere( bvh->primitives, leaf->sphereFirst, leaf->sphereCount, eye, ray,
+							  &closest, &closestIndex );
+			primNearestTriangle( bvh->primitives, leaf->triangleFirst, leaf->triangleCount, eye, ray,
+								&closest, &closestIndex, u, v );
+			primNearestBox( bvh->primitives, leaf->boxFirst, leaf->boxCount, eye, ray,
+						   &closest, &closestIndex );
+		}
+		else
+		{
+			int left = index + 1;
+			int right = node->first;
+			double leftEntry, rightEntry;
+			int hitLeft = intersectNode( &bvh->nodes[left], origin, inverse, closest, &leftEntry );
+			int hitRight = intersectNode( &bvh->nodes[right], origin, inverse, closest, &rightEntry );
+
+			/* Visita primeiro o filho mais prximo, empilhando o outro */
+			if( hitLeft && hitRight )
+			{
+				if( leftEntry <= rightEntry )
+				{
+					stackEntry[top] = rightEntry;
+					stack[top++] = right;
+					index = left;
+				}
+				else
+				{
+					stackEntry[top] = leftEntry;
+					stack[top++] = left;
+					index = right;
+				}
+				continue;
+			}
+			else if( hitLeft )
+			{
+				index = left;
+				continue;
+			}
+			else if( hitRight )
+			{
+				index = right;
+				continue;
+			}
+		}
+
+		/* Desempilha o prximo n que ainda pode conter uma interseo to prxima quanto a atual */
+		do
+		{
+			if( top == 0 )
+			{
+				if( closestIndex >= 0 )
+				{
+					*object = bvh->objects[closestIndex];
+				}
+
+				return closest;
+			}
+
+			--top;
+		}
+		while( stackEntry[top] > closest );
+
+		index = stack[top];
+	}
+}
+
+int bvhIsOccluded( Bvh bvh, Vector eye, Vector ray, double minDistance, double maxDistance,
+				   int *blocker )
+{
+	int stack[BVH_STACK_SIZE];
+	int top = 0;
+	int index = 0;
+	int id;
+
+	double origin[3];
+	double inverse[3];
+	double entry;
+
+	if( !bvh || bvh->nodeCount == 0 )
+	{
+		return 0;
+	}
+
+	origin[0] = eye.x;
+	origin[1] = eye.y;
+	origin[2] = eye.z;
+
+	inverse[0] = 1.0 / ray.x;
+	inverse[1] = 1.0 / ray.y;
+	inverse[2] = 1.0 / ray.z;
+
+	if( !intersectNode( &bvh->nodes[0], origin, inverse, maxDistance, &entry ) )
+	{
+		return 0;
+	}
+
+	for( ;; )
+	{
+		const BvhNode *node = &bvh->nodes[index];
+
+		if( node->count > 0 )
+		{
+			const BvhLeaf *leaf = &bvh->leaves[node->first];
+
+			/* Qualquer bloqueador serve: no h por que procurar o mais prximo */
+			if( primAnySphere( bvh->primitives, leaf->sphereFirst, leaf->sphereCount, eye, ray,
+							   minDistance, maxDistance, &id ) ||
+				primAnyTriangle( bvh->primitives, leaf->triangleFirst, leaf->triangleCount, eye, ray,
+								 minDistance, maxDistance, &id ) ||
+				primAnyBox( bvh->primitives, leaf->boxFirst, leaf->boxCount, eye, ray,
+							minDistance, maxDistance, &id ) )
+			{
+				if( blocker )
+				{
+					*blocker = id;
+				}
+				return 1;
+			}
+		}
+		else
+		{
+			int left = index + 1;
+			int right = node->first;
+
+			/* A ordem de visita no importa, ento os filhos no so ordenados */
+			if( intersectNode( &bvh->nodes[left], origin, inverse, maxDistance, &entry ) )
+			{
+				if( intersectNode( &bvh->nodes[right], origin, inverse, maxDistance, &entry ) )
+				{
+					stack[top++] = right;
+				}
+
+				index = left;
+				continue;
+			}
+			else if( intersectNode( &bvh->nodes[right], origin, inverse, maxDistance, &entry ) )
+			{
+				index = right;
+				continue;
+			}
+		}
+
+		if( top == 0 )
+		{
+			return 0;
+		}
+
+		index = stack[--top];
+	}
+}
+
+Bvh bvhCreateMapped( const BvhNode *nodes, int nodeCount, const BvhLeaf *leaves,
+					 PrimitiveStore primitives, Object *objects, int count )
+{
+	Bvh bvh = (struct _Bvh *)malloc( sizeof(struct _Bvh) );
+
+	if( !bvh )
+	{
+		return NULL;
+	}
+
+	bvh->nodeCount = nodeCount;
+	bvh->nodes = (BvhNode *)nodes;
+	bvh->leaves = (BvhLeaf *)leaves;
+	bvh->primitives = primitives;
+	bvh->objectCount = count;
+	bvh->objects = NULL;
+	bvh->mapped = 1;
+
+	if( count > 0 )
+	{
+		bvh->objects = (Object *)malloc( count * sizeof(Object) );
+		if( !bvh->objects )
+		{
+			free( bvh );
+			return NULL;
+		}
+
+		memcpy( bvh->objects, objects, count * sizeof(Object) );
+	}
+
+	return bvh;
+}
+
+int bvhCheckMapped( const BvhNode *nodes, int nodeCount, const BvhLeaf *leaves, int leafCount,
+					PrimitiveStore primitives, int count )
+{
+	if( nodeCount < 0 || leafCount < 0 ||
+		!checkIds( primitives->spheres.ids, primitives->spheres.count, count ) ||
+		!checkIds( primitives->triangles.ids, primitives->triangles.count, count ) ||
+		!checkIds( primitives->boxes.ids, primitives->boxes.count, count ) )
+	{
+		return 0;
+	}
+
+	/* A raiz deve cobrir exatamente todos os ns */
+	return nodeCount == 0 ||
+		   checkNode( nodes, nodeCount, leaves, leafCount, primitives, 0, 0 ) == nodeCount;
+}
+
+int bvhGetLeafCount( Bvh bvh )
+{
+	int leafCount = 0;
+	int n;
+
+	for( n = 0; n < bvh->nodeCount; ++n )
+	{
+		if( bvh->nodes[n].count > 0 )
+		{
+			++leafCount;
+		}
+	}
+
+	return leafCount;
+}
+
+void bvhDestroy( Bvh bvh )
+{
+	if( !bvh )
+	{
+		return;
+	}
+
+	if( bvh->mapped )
+	{
+		free( bvh->primitives );
+	}
+	else
+	{
+		free( bvh->nodes );
+		free( bvh->leaves );
+		primDestroy( bvh->primitives );
+	}
+
+	free( bvh->objects );
+	free( bvh );
+}
+
+
+/************************************************************************/
+/* Definio das Funes Privadas                                       */
+/************************************************************************/
+static void buildNode( BvhBuilder *builder, int nodeIndex, int first, int count, int depth )
+{
+	BvhNode *node = &builder->nodes[nodeIndex];
+	Bounds bounds, centroidBounds;
+	int bestAxis = -1;
+	int bestBin = -1;
+	int leftCount;
+	int left, right;
+	double cost;
+
+	computeBounds( builder, first, count, &bounds, &centroidBounds );
+
+	memcpy( node->min, bounds.min, sizeof(node->min) );
+	memcpy( node->max, bounds.max, sizeof(node->max) );
+
+	if( count == 1 )
+	{
+		node->first = first;
+		node->count = count;
+		return;
+	}
+
+	if( depth < BVH_MAX_SAH_DEPTH )
+	{
+		cost = findSplit( builder, first, count, &bounds, &centroidBounds, &bestAxis, &bestBin );
+
+		/* Transforma em folha se dividir no compensa pela SAH */
+		if( count <= BVH_MAX_LEAF_SIZE && cost >= BVH_INTERSECTION_COST * count )
+		{
+			node->first = first;
+			node->count = count;
+			return;
+		}
+	}
+
+	leftCount = 0;
+
+	if( bestAxis >= 0 )
+	{
+		int i = first;
+		int j = first + count - 1;
+
+		/* Particiona os ndices: bins at bestBin ficam  esquerda */
+		while( i <= j )
+		{
+			int object = builder->indices[i];
+
+			if( binOf( &centroidBounds, bestAxis, builder->centroids[3 * object + bestAxis] ) <= bestBin )
+			{
+				++i;
+			}
+			else
+			{
+				builder->indices[i] = builder->indices[j];
+				builder->indices[j--] = object;
+			}
+		}
+
+		leftCount = i - first;
+	}
+
+	/* Sem partio til (centrides coincidentes ou rvore profunda demais): divide ao meio */
+	if( leftCount == 0 || leftCount == count )
+	{
+		leftCount = count / 2;
+	}
+
+	left = builder->nodeCount++;
+	buildNode( builder, left, first, leftCount, depth + 1 );
+
+	right = builder->nodeCount++;
+	buildNode( builder, right, first + leftCount, count - leftCount, depth + 1 );
+
+	/* O vetor de ns  pr-alocado, ento 'node' continua vlido */
+	node->first = right;
+	node->count = 0;
+}
+
+static void storeLeaves( BvhBuilder *builder, Bvh bvh )
+{
+	static const int types[3] = { TYPE_SPHERE, TYPE_TRIANGLE, TYPE_BOX };
+	PrimitiveStore store = bvh->primitives;
+	int leafCount = 0;
+	int n, t, i;
+
+	for( n = 0; n < builder->nodeCount; ++n )
+	{
+		BvhNode *node = &builder->nodes[n];
+		BvhLeaf *leaf;
+
+		if( node->count == 0 )
+		{
+			continue;
+		}
+
+		leaf = &bvh->leaves[leafCount];
+		leaf->sphereFirst = store->spheres.count;
+		leaf->triangleFirst = store->triangles.count;
+		leaf->boxFirst = store->boxes.count;
+
+		for( t = 0; t < 3; ++t )
+		{
+			for( i = node->first; i < node->first + node->count; ++i )
+			{
+				int object = builder->indices[i];
+
+				if( bvh->objects[object]->type == types[t] )
+				{
+					primAdd( store, bvh->objects[object], object );
+				}
+			}
+		}
+
+		leaf->sphereCount = store->spheres.count - leaf->sphereFirst;
+		leaf->triangleCount = store->triangles.count - leaf->triangleFirst;
+		leaf->boxCount = store->boxes.count - leaf->boxFirst;
+
+		node->first = leafCount++;
+	}
+}
+
+static void computeBounds( BvhBuilder *builder, int first, int count, Bounds *bounds, Bounds *centroidBounds )
+{
+	int i;
+
+	boundsEmpty( bounds );
+	boundsEmpty( centroidBounds );
+
+	for( i = first; i < first + count; ++i )
+	{
+		int object = builder->indices[i];
+
+		boundsGrow( bounds, &builder->bounds[object] );
+		boundsGrowPoint( centroidBounds, &builder->centroids[3 * object] );
+	}
+}
+
+static double findSplit( BvhBuilder *builder, int first, int count, const Bounds *bounds,
+						const Bounds *centroidBounds, int *bestAxis, int *bestBin )
+{
+	double bestCost = DBL_MAX;
+	double parentArea = boundsArea( bounds );
+	int axis;
+
+	if( parentArea <= 0.0 )
+	{
+		return DBL_MAX;
+	}
+
+	for( axis = 0; axis < 3; ++axis )
+	{
+		Bounds binBounds[BVH_BINS];
+		int binCount[BVH_BINS];
+		double rightArea[BVH_BINS];
+		int rightCount[BVH_BINS];
+		Bounds accumulated;
+		int accumulatedCount;
+		int i;
+
+		if( centroidBounds->max[axis] - centroidBounds->min[axis] <= 0.0 )
+		{
+			continue;
+		}
+
+		for( i = 0; i < BVH_BINS; ++i )
+		{
+			boundsEmpty( &binBounds[i] );
+			binCount[i] = 0;
+		}
+
+		for( i = first; i < first + count; ++i )
+		{
+			int object = builder->indices[i];
+			int bin = binOf( centroidBounds, axis, builder->centroids[3 * object + axis] );
+
+			boundsGrow( &binBounds[bin], &builder->bounds[object] );
+			++binCount[bin];
+		}
+
+		/* Varredura da direita para a esquerda: rea e contagem  direita de cada plano */
+		boundsEmpty( &accumulated );
+		accumulatedCount = 0;
+		for( i = BVH_BINS - 1; i > 0; --i )
+		{
+			boundsGrow( &accumulated, &binBounds[i] );
+			accumulatedCount += binCount[i];
+			rightArea[i] = boundsArea( &accumulated );
+			rightCount[i] = accumulatedCount;
+		}
+
+		/* Varredura da esquerda para a direita, avaliando o custo de cada plano */
+		boundsEmpty( &accumulated );
+		accumulatedCount = 0;
+		for( i = 0; i < BVH_BINS - 1; ++i )
+		{
+			double cost;
+
+			boundsGrow( &accumulated, &binBounds[i] );
+			accumulatedCount += binCount[i];
+
+			if( accumulatedCount == 0 || rightCount[i + 1] == 0 )
+			{
+				continue;
+			}
+
+			cost = BVH_TRAVERSAL_COST + BVH_INTERSECTION_COST *
+				( boundsArea( &accumulated ) * accumulatedCount + rightArea[i + 1] * rightCount[i + 1] ) / parentArea;
+
+			if( cost < bestCost )
+			{
+				bestCost = cost;
+				*bestAxis = axis;
+				*bestBin = i;
+			}
+		}
+	}
+
+	return bestCost;
+}
+
+static int binOf( const Bounds *centroidBounds, int axis, double centroid )
+{
+	double extent = centroidBounds->max[axis] - centroidBounds->min[axis];
+	int bin = (int)( BVH_BINS * ( centroid - centroidBounds->min[axis] ) / extent );
+
+	if( bin < 0 )
+	{
+		return 0;
+	}
+
+	return ( bin < BVH_BINS ) ? bin : ( BVH_BINS - 1 );
+}
+
+static int intersectNode( const BvhNode *node, const double origin[3], const double inverse[3],
+						 double maxDistance, double *entry )
+{
+	double tmin = 0.0;
+	double tmax = maxDistance;
+	int axis;
+
+	for( axis = 0; axis < 3; ++axis )
+	{
+		double t0 = ( node->min[axis] - origin[axis] ) * inverse[axis];
+		double t1 = ( node->max[axis] - origin[axis] ) * inverse[axis];
+
+		if( t0 > t1 )
+		{
+			double swap = t0;
+			t0 = t1;
+			t1 = swap;
+		}
+
+		/* Comparaes com NaN so falsas, o que ignora o eixo degenerado */
+		if( t0 > tmin )
+		{
+			tmin = t0;
+		}
+
+		if( t1 < tmax )
+		{
+			tmax = t1;
+		}
+
+		if( tmin > tmax )
+		{
+			return 0;
+		}
+	}
+
+	*entry = tmin;
+	return 1;
+}
+
+static int checkNode( const BvhNode *nodes, int nodeCount, const BvhLeaf *leaves, int leafCount,
+					 PrimitiveStore primitives, int index, int depth )
+{
+	const BvhNode *node = &nodes[index];
+	int end;
+
+	/* Cada nvel pode empilhar um n durante o percurso */
+	if( depth >= BVH_STACK_SIZE || node->count < 0 )
+	{
+		return -1;
+	}
+
+	if( node->count > 0 )
+	{
+		const BvhLeaf *leaf = &leaves[node->first];
+
+		if( node->first < 0 || node->first >= leafCount ||
+			!checkRange( leaf->sphereFirst, leaf->sphereCount, primitives->spheres.count ) ||
+			!checkRange( leaf->triangleFirst, leaf->triangleCount, primitives->triangles.count ) ||
+			!checkRange( leaf->boxFirst, leaf->boxCount, primitives->boxes.count ) )
+		{
+			return -1;
+		}
+
+		return index + 1;
+	}
+
+	/* O filho da esquerda  o n seguinte e o da direita vem logo depois da sua subrvore */
+	if( index + 1 >= nodeCount )
+	{
+		return -1;
+	}
+
+	end = checkNode( nodes, nodeCount, leaves, leafCount, primitives, index + 1, depth + 1 );
+	if( end < 0 || end >= nodeCount || node->first != end )
+	{
+		return -1;
+	}
+
+	return checkNode( nodes, nodeCount, leaves, leafCount, primitives, end, depth + 1 );
+}
+
+static int checkRange( int first, int count, int size )
+{
+	return first >= 0 && count >= 0 && first <= size && count <= size - first;
+}
+
+static int checkIds( const int *ids, int size, int count )
+{
+	int i;
+
+	for( i = 0; i < size; ++i )
+	{
+		if( ids[i] < 0 || ids[i] >= count )
+		{
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+static void boundsEmpty( Bounds *bounds )
+{
+	int axis;
+
+	for( axis = 0; axis < 3; ++axis )
+	{
+		bounds->min[axis] = DBL_MAX;
+		bounds->max[axis] = -DBL_MAX;
+	}
+}
+
+static void boundsGrow( Bounds *bounds, const Bounds *other )
+{
+	int axis;
+
+	for( axis = 0; axis < 3; ++axis )
+	{
+		if( other->min[axis] < bounds->min[axis] )
+		{
+			bounds->min[axis] = other->min[axis];
+		}
+
+		if( other->max[axis] > bounds->max[axis] )
+		{
+			bounds->max[axis] = other->max[axis];
+		}
+	}
+}
+
+static void boundsGrowPoint( Bounds *bounds, const double point[3] )
+{
+	int axis;
+
+	for( axis = 0; axis < 3; ++axis )
+	{
+		if( point[axis] < bounds->min[axis] )
+		{
+			bounds->min[axis] = point[axis];
+		}
+
+		if( point[axis] > bounds->max[axis] )
+		{
+			bounds->max[axis] = point[axis];
+		}
+	}
+}
+
+static double boundsArea( const Bounds *bounds )
+{
+	double dx = bounds->max[0] - bounds->min[0];
+	double dy = bounds->max[1] - bounds->min[1];
+	double dz = bounds->max[2] - bounds->min[2];
+
+	if( dx < 0.0 || dy < 0.0 || dz < 0.0 )
+	{
+		return 0.0;
+	}
+
+	return 2.0 * ( dx * dy + dy * dz + dz * dx );
+}
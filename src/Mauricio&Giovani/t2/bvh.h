@@ -0,0 +1,198 @@
+/**
+ *	@file bvh.h Bvh: hierarquia de volumes envolventes (BVH) sobre os objetos de uma cena.
+ *		A hierarquia  construda uma nica vez, aps a leitura da cena, usando a
+ *		heurstica de rea de superfcie (SAH) para escolher as parties.
+ *
+ *	@date
+ *			Criado em:			17 de Outubro de 2026
+ *
+ *	@version 2.0
+ */
+
+#ifndef _BVH_H_
+#define _BVH_H_
+
+#include "algebra.h"
+#include "object.h"
+#include "primitive.h"
+
+
+/************************************************************************/
+/* Tipos Exportados                                                     */
+/************************************************************************/
+/**
+ *   N da hierarquia, armazenado em profundidade: o filho da esquerda de um
+ *   n interno  sempre o n seguinte no vetor.
+ */
+typedef struct
+{
+	/**
+	 *  Canto mnimo da caixa envolvente do n.
+	 */
+	double min[3];
+	/**
+	 *  Canto mximo da caixa envolvente do n.
+	 */
+	double max[3];
+	/**
+	 *  N interno: ndice do filho da direita.
+	 *  Folha: ndice da folha em leaves.
+	 */
+	int first;
+	/**
+	 *  Nmero de objetos da folha (zero para ns internos).
+	 */
+	int count;
+}
+BvhNode;
+
+/**
+ *   Primitivas de uma folha: um intervalo contguo em cada vetor do PrimitiveStore.
+ */
+typedef struct
+{
+	int sphereFirst;
+	int sphereCount;
+	int triangleFirst;
+	int triangleCount;
+	int boxFirst;
+	int boxCount;
+}
+BvhLeaf;
+
+/**
+ *   Hierarquia de volumes envolventes.
+ */
+struct _Bvh
+{
+	/**
+	 *  Nmero de ns da hierarquia.
+	 */
+	int nodeCount;
+	/**
+	 *  Vetor com os ns (o n 0  a raiz).
+	 */
+	BvhNode *nodes;
+
+	/**
+	 *  Vetor com as folhas.
+	 */
+	BvhLeaf *leaves;
+
+	/**
+	 *  Geometria dos objetos, agrupada por folha e, dentro de cada folha, por tipo.
+	 *  O identificador de cada primitiva  a posio original do objeto, que
+	 *  tambm desempata intersees  mesma distncia, como no teste exaustivo.
+	 */
+	PrimitiveStore primitives;
+
+	/**
+	 *  Nmero de objetos referenciados pela hierarquia.
+	 */
+	int objectCount;
+	/**
+	 *  Objetos na ordem original, indexados pelos identificadores das primitivas.
+	 */
+	Object *objects;
+
+	/**
+	 *  No-zero se nodes, leaves e os vetores de primitives pertencem a um arquivo
+	 *  mapeado em memria (veja bvhCreateMapped()).
+	 */
+	int mapped;
+};
+
+typedef struct _Bvh * Bvh;
+
+
+/************************************************************************/
+/* Funes Exportadas                                                   */
+/************************************************************************/
+/**
+ *	Constri a hierarquia sobre um conjunto de objetos.
+ *	O vetor fornecido no  modificado; a hierarquia guarda sua prpria cpia.
+ *
+ *	@param objects Vetor de objetos.
+ *	@param count Nmero de objetos no vetor.
+ *
+ *	@return Handle para a hierarquia criada (NULL se no houver memria).
+ */
+Bvh bvhCreate( Object *objects, int count );
+
+/**
+ *	Cria uma hierarquia a partir de vetores j construdos por bvhCreate(), por
+ *	exemplo os de uma cena compilada mapeada em memria (veja binary.h). Nada 
+ *	copiado: bvhDestroy() libera apenas o vetor de objetos e os structs da
+ *	hierarquia e de 'primitives', nunca os vetores que eles referenciam.
+ *
+ *	@param nodes Ns da hierarquia (o n 0  a raiz).
+ *	@param nodeCount Nmero de ns.
+ *	@param leaves Folhas referenciadas pelos ns.
+ *	@param primitives Conjunto alocado com malloc() cujos vetores apontam para a
+ *					  geometria agrupada por folha.
+ *	@param objects Objetos na ordem original. O vetor  copiado.
+ *	@param count Nmero de objetos.
+ *
+ *	@return Handle para a hierarquia criada (NULL se no houver memria).
+ */
+Bvh bvhCreateMapped( const BvhNode *nodes, int nodeCount, const BvhLeaf *leaves,
+					 PrimitiveStore primitives, Object *objects, int count );
+
+/**
+ *	Verifica vetores que sero passados a bvhCreateMapped(). Os percursos no
+ *	testam ndices, ento vetores vindos de um arquivo precisam formar uma rvore
+ *	gravada em profundidade, rasa o bastante para a pilha de percurso, com folhas
+ *	e identificadores dentro dos vetores.
+ *
+ *	@param leafCount Nmero de folhas em leaves.
+ *	@param count Nmero de objetos que os identificadores das primitivas indexam.
+ *
+ *	@return No-zero se os vetores podem ser percorridos com segurana.
+ */
+int bvhCheckMapped( const BvhNode *nodes, int nodeCount, const BvhLeaf *leaves, int leafCount,
+					PrimitiveStore primitives, int count );
+
+/**
+ *	Obtm o nmero de folhas de uma hierarquia.
+ */
+int bvhGetLeafCount( Bvh bvh );
+
+/**
+ *	Encontra o objeto mais prximo interceptado por um raio.
+ *
+ *	@param bvh Handle para a hierarquia.
+ *	@param eye Origem do raio.
+ *	@param ray Direo do raio.
+ *	@param object Onde  retornado o objeto interceptado. No pode ser NULL.
+ *	@param u [out]Se o objeto interceptado for um tringulo, peso de v1 no ponto.
+ *	@param v [out]Se o objeto interceptado for um tringulo, peso de v2 no ponto.
+ *
+ *	@return Distncia entre eye e o objeto interceptado. DBL_MAX se nenhum
+ *			objeto  interceptado, neste caso 'object' no  modificado.
+ */
+double bvhGetNearestObject( Bvh bvh, Vector eye, Vector ray, Object *object, double *u, double *v );
+
+/**
+ *	Verifica se algum objeto intercepta um raio dentro de um intervalo de distncias.
+ *	Diferente de bvhGetNearestObject(), a busca termina no primeiro objeto encontrado
+ *	e nenhuma interseo mais prxima  calculada. Usada nos raios de sombra.
+ *
+ *	@param bvh Handle para a hierarquia.
+ *	@param eye Origem do raio.
+ *	@param ray Direo do raio.
+ *	@param minDistance Intersees a distncias menores ou iguais so ignoradas.
+ *	@param maxDistance Intersees a distncias maiores ou iguais so ignoradas.
+ *	@param blocker [out]ndice, no vetor original, do objeto que bloqueia o raio.
+ *					Pode ser NULL.
+ *
+ *	@return No-zero se algum objeto bloqueia o raio e zero caso contrrio.
+ */
+int bvhIsOccluded( Bvh bvh, Vector eye, Vector ray, double minDistance, double maxDistance,
+				   int *blocker );
+
+/**
+ *	Destri uma hierarquia criada com bvhCreate(). Os objetos no so destrudos.
+ */
+void bvhDestroy( Bvh bvh );
+
+#endif
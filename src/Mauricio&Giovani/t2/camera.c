@@ -80,6 +80,11 @@ Vector camGetRay( Camera camera, double x, double y )
 	return algUnit( algSub( point, camera->eye ) );
 }
 
+double camGetPixelAngle( Camera camera )
+{
+	return 2.0 * tan( ( M_PI * camera->fovy ) / ( 2.0 * 180.0 ) ) / camera->screenHeight;
+}
+
 int camGetScreenWidth( Camera camera )
 {
 	return (int)camera->screenWidth;
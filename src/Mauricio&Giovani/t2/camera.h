@@ -156,6 +156,13 @@ Vector camGetEye( Camera camera );
  */
 Vector camGetRay( Camera camera, double x, double y );
 
+/**
+ *	Obtm o ngulo, em radianos, entre os raios de dois pixels vizinhos no centro
+ *	da tela. A largura da regio vista por um raio cresce com a distncia nessa
+ *	proporo.
+ */
+double camGetPixelAngle( Camera camera );
+
 /**
  *	Obtm a largura da tela de uma cmera, em pixels.
  */
@@ -16,26 +16,28 @@
 #ifndef	_COLOR_H_
 #define	_COLOR_H_
 
+#include "algebra.h"
+
 /************************************************************************/
 /* Tipos Exportados                                                     */
 /************************************************************************/
 /**
- *   Cor rgb.
+ *   Cor rgb. Usa a mesma preciso de Vector (veja VectorReal em algebra.h).
  */
-typedef struct color_impl
+typedef struct ALG_ALIGN16 color_impl
 {
    /**
     * Componente vermelha.
     */
-	double red;
+	VectorReal red;
    /**
     * Componente verde.
     */
-	double green;
+	VectorReal green;
    /**
     * Componente azul.
     */
-	double blue;
+	VectorReal blue;
 }
 Color;
 
@@ -18,10 +18,124 @@
 #include <math.h>
 #include "image.h"
 
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define IMAGE_SSE2
+#include <emmintrin.h>
+#endif
+
+/************************************************************************/
+/* Constantes Privadas                                                  */
+/************************************************************************/
+
+/*  SRGB_TABLE_SIZE:
+ * Numero de entradas da tabela da curva sRGB, indexada pela cor linear em
+ * [0,1]. Com 4096 entradas os tons escuros, onde a curva e' mais inclinada,
+ * ainda tem mais de uma entrada por nivel de saida.
+ */
+#define SRGB_TABLE_SIZE  4096
+
+/*  TONE_BIAS:
+ * Somado antes do truncamento linear, para que as cores lidas de um arquivo
+ * (k/255 em ponto flutuante) voltem exatamente ao byte k.
+ */
+#define TONE_BIAS  1e-4f
+
 /************************************************************************/
 /* Definicao das Funcoes Privadas                                       */
 /************************************************************************/
 
+static unsigned char srgbTable[SRGB_TABLE_SIZE];
+static int srgbReady = 0;
+
+/*  initSRGB:
+ * Preenche a tabela da curva sRGB. Chamada na criacao das imagens, antes
+ * que qualquer thread as preencha.
+ */
+static void initSRGB(void)
+{
+   int i;
+   double c;
+
+   if (srgbReady) return;
+   for (i = 0; i < SRGB_TABLE_SIZE; i++)
+   {
+      c = (double)i / (SRGB_TABLE_SIZE - 1);
+      c = (c <= 0.0031308) ? 12.92*c : 1.055*pow(c, 1/2.4) - 0.055;
+      srgbTable[i] = (unsigned char)floor(255*c + 0.5);
+   }
+   srgbReady = 1;
+}
+
+/*  toneMapValue:
+ * Mapeia uma componente linear para o byte exibido. As comparacoes tratam
+ * NaN como zero, e os passos sao os mesmos da versao SIMD de toneMapBuffer.
+ */
+static unsigned char toneMapValue(const ImageToneMap *toneMap, float x)
+{
+   x *= toneMap->exposure;
+   if (!(x > 0.0f)) x = 0.0f;
+   if (toneMap->op == IMAGE_TONE_REINHARD) x = x / (1.0f + x);
+   if (!(x < 1.0f)) x = 1.0f;
+
+   if (toneMap->srgb)
+      return srgbTable[(int)(x * (SRGB_TABLE_SIZE - 1) + 0.5f)];
+   return (unsigned char)(int)(x * 255.0f + TONE_BIAS);
+}
+
+/*  toneMapBuffer:
+ * Mapeia n componentes lineares consecutivas (os canais nao precisam ser
+ * distinguidos). Com SSE2, quatro componentes sao tratadas por iteracao.
+ */
+static void toneMapBuffer(const ImageToneMap *toneMap, const float *src, unsigned char *dst, long n)
+{
+   long i = 0;
+
+#ifdef IMAGE_SSE2
+   __m128 exposure = _mm_set1_ps(toneMap->exposure);
+   __m128 zero = _mm_setzero_ps();
+   __m128 one = _mm_set1_ps(1.0f);
+   __m128 scale = _mm_set1_ps(toneMap->srgb ? (float)(SRGB_TABLE_SIZE - 1) : 255.0f);
+   __m128 bias = _mm_set1_ps(toneMap->srgb ? 0.5f : TONE_BIAS);
+   int reinhard = (toneMap->op == IMAGE_TONE_REINHARD);
+   __m128 x;
+   __m128i q;
+   int packed;
+   union { __m128i v; int i[4]; } index;
+
+   for (; i + 4 <= n; i += 4)
+   {
+      x = _mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src + i), exposure), zero);
+      if (reinhard) x = _mm_div_ps(x, _mm_add_ps(one, x));
+      x = _mm_min_ps(x, one);
+      q = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(x, scale), bias));
+
+      if (toneMap->srgb)
+      {
+         index.v = q;
+         dst[i  ] = srgbTable[index.i[0]];
+         dst[i+1] = srgbTable[index.i[1]];
+         dst[i+2] = srgbTable[index.i[2]];
+         dst[i+3] = srgbTable[index.i[3]];
+      }
+      else
+      {
+         q = _mm_packs_epi32(q, q);
+         packed = _mm_cvtsi128_si32(_mm_packus_epi16(q, q));
+         memcpy(dst + i, &packed, 4);
+      }
+   }
+#endif
+
+   for (; i < n; i++)
+      dst[i] = toneMapValue(toneMap, src[i]);
+}
+
+static int isLittleEndian(void)
+{
+   unsigned short probe = 1;
+   return *(unsigned char *)&probe == 1;
+}
+
 /*  getuint e putuint:
  * Funcoes auxiliares para ler e escrever inteiros na ordem (lo-hi)
  * Note que no Windows as variaveis tipo "unsigned short int" sao armazenadas 
@@ -63,6 +177,172 @@ static int putuint(unsigned short uint, FILE *output)
   return 1;
 }
 
+/*  TGA_STAGE_SIZE:
+ * Tamanho, em bytes, do buffer intermediario usado na escrita. Os pixels sao
+ * convertidos de RGB para BGR neste buffer, e nao no buffer da imagem, que
+ * pode estar sendo preenchido por outras threads enquanto e' gravado.
+ * Cabe com folga um pacote RLE completo (1 + 128*3 bytes).
+ */
+#define TGA_STAGE_SIZE  4096
+
+/*  TGA_MAX_PACKET:
+ * Numero maximo de pixels de um pacote RLE.
+ */
+#define TGA_MAX_PACKET  128
+
+typedef struct
+{
+   FILE          *file;
+   unsigned char  buf[TGA_STAGE_SIZE];
+   int            count;
+   int            ok;
+} TGAStage;
+
+static void stageFlush(TGAStage *stage)
+{
+   if (stage->count > 0 && fwrite(stage->buf, 1, stage->count, stage->file) != (size_t)stage->count)
+      stage->ok = 0;
+   stage->count = 0;
+}
+
+/*  stagePut:
+ * Copia n pixels RGB para o buffer intermediario, ja na ordem BGR do arquivo,
+ * precedidos do cabecalho de pacote (se header >= 0).
+ */
+static void stagePut(TGAStage *stage, int header, const unsigned char *rgb, int n)
+{
+   unsigned char *dst;
+
+   if (stage->count + 1 + 3*n > TGA_STAGE_SIZE)
+      stageFlush(stage);
+
+   dst = stage->buf + stage->count;
+   if (header >= 0)
+      *dst++ = (unsigned char)header;
+
+   for (; n > 0; n--, rgb += 3)
+   {
+      *dst++ = rgb[2];
+      *dst++ = rgb[1];
+      *dst++ = rgb[0];
+   }
+   stage->count = (int)(dst - stage->buf);
+}
+
+/*  stagePutRow:
+ * Escreve uma linha da imagem. Sem compressao, os pixels sao copiados em
+ * blocos do tamanho do buffer. Com compressao, a linha e' dividida em pacotes
+ * de repeticao (um pixel repetido ate' 128 vezes) e pacotes literais (ate'
+ * 128 pixels diferentes); nenhum pacote atravessa o fim da linha.
+ */
+static void stagePutRow(TGAStage *stage, const unsigned char *row, int width, int rle)
+{
+   int x, n, run;
+
+   if (!rle)
+   {
+      for (x = 0; x < width; x += n)
+      {
+         n = width - x;
+         if (n > TGA_STAGE_SIZE/3) n = TGA_STAGE_SIZE/3;
+         stagePut(stage, -1, row + 3*x, n);
+      }
+      return;
+   }
+
+   x = 0;
+   while (x < width)
+   {
+      /* pacote de repeticao: o pixel atual aparece ao menos duas vezes */
+      for (run = 1; x + run < width && run < TGA_MAX_PACKET; run++)
+         if (memcmp(row + 3*x, row + 3*(x+run), 3) != 0) break;
+
+      if (run > 1)
+      {
+         stagePut(stage, 0x80 | (run - 1), row + 3*x, 1);
+         x += run;
+         continue;
+      }
+
+      /* pacote literal: ate' o inicio da proxima repeticao */
+      for (n = 1; x + n < width && n < TGA_MAX_PACKET; n++)
+         if (x + n + 1 < width && memcmp(row + 3*(x+n), row + 3*(x+n+1), 3) == 0) break;
+
+      stagePut(stage, n - 1, row + 3*x, n);
+      x += n;
+   }
+}
+
+/*  readRLE:
+ * Le n pixels BGR comprimidos em pacotes RLE (imagens TGA do tipo 10).
+ */
+static void readRLE(unsigned char *buf, long n, FILE *input)
+{
+   int header, count;
+
+   while (n > 0 && (header = getc(input)) != EOF)
+   {
+      count = (header & 0x7f) + 1;
+      if (count > n) count = (int)n;
+
+      if (header & 0x80)
+      {
+         /* pacote de repeticao: um pixel, repetido count vezes */
+         if (fread(buf, 1, 3, input) != 3) return;
+         for (n -= count, buf += 3; --count > 0; buf += 3)
+            memcpy(buf, buf - 3, 3);
+      }
+      else
+      {
+         /* pacote literal: count pixels */
+         if (fread(buf, 1, 3*count, input) != (size_t)(3*count)) return;
+         n -= count;
+         buf += 3*count;
+      }
+   }
+}
+
+static int writeTGA(char *filename, Image image, int rle)
+{
+   unsigned char imageType = rle ? 10 : 2;  /* RGB sem compressao (2) ou com RLE (10) */
+   unsigned char bitDepth=24;      /* 24 bits por pixel */
+
+   TGAStage      stage;           /* buffer intermediario de escrita */
+   int           y;
+
+   unsigned char byteZero=0;      /* usado para escrever um byte zero no arquivo */
+   short int     shortZero=0;     /* usado para escrever um short int zero no arquivo */
+
+
+   /* cria um arquivo binario novo */
+   stage.file = fopen(filename, "wb");
+   if (!stage.file) return 0;
+   stage.count = 0;
+   stage.ok = 1;
+
+   /* escreve o cabecalho */
+   putc(byteZero,stage.file);     /* 0, no. de caracteres no campo de id da imagem */
+   putc(byteZero,stage.file);     /* = 0, imagem nao tem palheta de cores */
+   putc(imageType,stage.file);    /* = 2 ou 10 -> imagem "true color" (RGB) */
+   putuint(shortZero,stage.file); /* info sobre a tabela de cores (inexistente) */
+   putuint(shortZero,stage.file);              /* idem */
+   putc(byteZero,stage.file);                  /* idem */
+   putuint(shortZero,stage.file);    /* =0 origem em x */
+   putuint(shortZero,stage.file);    /* =0 origem em y */
+   putuint(image->width,stage.file);   /* largura da imagem em pixels */
+   putuint(image->height,stage.file);  /* altura da imagem em pixels */
+   putc(bitDepth,stage.file);      /* numero de bits de um pixel */
+   putc(byteZero, stage.file);   /* =0 origem no canto inf esquedo sem entrelacamento */
+
+   /* escreve as linhas, convertendo de RGB para BGR no buffer intermediario */
+   for (y = 0; y < image->height; y++)
+      stagePutRow(&stage, image->buf + 3*y*image->width, image->width, rle);
+   stageFlush(&stage);
+
+   if (fclose(stage.file) != 0) stage.ok = 0;
+   return stage.ok;
+}
+
 /************************************************************************/
 /* Definicao das Funcoes Exportadas                                     */
 /************************************************************************/
@@ -76,6 +356,10 @@ Image imageCreate (int w, int h)
    image->height =(unsigned int) h;
    image->buf = (unsigned char *) malloc (w * h * 3);
    assert(image->buf);
+   image->hdr = (float *) calloc (w * h * 3, sizeof(float));
+   assert(image->hdr);
+   image->toneMap = imageDefaultToneMap();
+   initSRGB();
    return image;
 }
 
@@ -84,6 +368,7 @@ void imageDestroy (Image image)
    if (image)
    {
       if (image->buf) free (image->buf);
+      if (image->hdr) free (image->hdr);
       free(image);
    }
 }
@@ -120,9 +405,13 @@ void imageSetPixel(Image image, int x, int y, Color color)
 {
    int pos = (y*image->width*3) + (x*3);
 
-   image->buf[pos  ] = (unsigned char)(color.red * 255);
-   image->buf[pos+1] = (unsigned char)(color.green * 255);
-   image->buf[pos+2] = (unsigned char)(color.blue * 255);
+   image->hdr[pos  ] = (float)color.red;
+   image->hdr[pos+1] = (float)color.green;
+   image->hdr[pos+2] = (float)color.blue;
+
+   image->buf[pos  ] = toneMapValue(&image->toneMap, image->hdr[pos  ]);
+   image->buf[pos+1] = toneMapValue(&image->toneMap, image->hdr[pos+1]);
+   image->buf[pos+2] = toneMapValue(&image->toneMap, image->hdr[pos+2]);
 }
 
 Color imageGetPixel(Image image, int x, int y)
@@ -166,10 +455,10 @@ Image imageLoad (char *filename)
    ucharSkip = getc(filePtr); 
    if (ucharSkip != 0) printf("erro na leitura de %s: imagem com tabela de cores\n", filename);
    
-   /* le o tipo de imagem (que deve ser obrigatoriamente 2).  
-      Não estamos tratando dos outros tipos */
+   /* le o tipo de imagem (que deve ser obrigatoriamente 2, ou 10 quando
+      comprimida com RLE). Não estamos tratando dos outros tipos */
    imageType=getc(filePtr);
-   assert(imageType == 2);
+   assert(imageType == 2 || imageType == 10);
 
    /* pula 9 bytes relacionados com a tabela de cores 
      (que nao existe quando a imagem e' RGB, imageType=2) */
@@ -195,7 +484,10 @@ Image imageLoad (char *filename)
    assert(image);
 
    /* read in image data */
-   fread(image->buf, sizeof(unsigned char), 3*imageWidth*imageHeight, filePtr);
+   if (imageType == 10)
+      readRLE(image->buf, (long)imageWidth*imageHeight, filePtr);
+   else
+      fread(image->buf, sizeof(unsigned char), 3*imageWidth*imageHeight, filePtr);
    
    /* change BGR to RGB so OpenGL can read the image data */
    for (imageIdx = 0; imageIdx < 3*imageWidth*imageHeight; imageIdx += 3)
@@ -205,61 +497,108 @@ Image imageLoad (char *filename)
       image->buf[imageIdx + 2] = colorSwap;
    }
 
+   /* as cores lineares sao os proprios bytes lidos */
+   for (imageIdx = 0; imageIdx < 3*imageWidth*imageHeight; imageIdx++)
+      image->hdr[imageIdx] = image->buf[imageIdx] / 255.0f;
+
    fclose(filePtr);
    return image;
 }
 
 int imageWriteTGA(char *filename, Image image)
 {
-   unsigned char imageType=2;      /* RGB(A) sem compressão */
-   unsigned char bitDepth=24;      /* 24 bits por pixel */
+   return writeTGA(filename, image, 0);
+}
 
-   FILE         *filePtr;         /* ponteiro do arquivo */
-   long        imageIdx;         /* indice para varrer os pixels */
-   unsigned char colorSwap;      /* variavel temporaria para trocar de RGBA para BGRA */ 
+int imageWriteTGARLE(char *filename, Image image)
+{
+   return writeTGA(filename, image, 1);
+}
 
-   unsigned char byteZero=0;      /* usado para escrever um byte zero no arquivo */
-   short int     shortZero=0;     /* usado para escrever um short int zero no arquivo */
+ImageToneMap imageDefaultToneMap(void)
+{
+   ImageToneMap toneMap;
 
+   toneMap.op = IMAGE_TONE_CLAMP;
+   toneMap.exposure = 1.0f;
+   toneMap.srgb = 0;
+   return toneMap;
+}
 
-   /* cria um arquivo binario novo */
-   filePtr = fopen(filename, "wb");
-   assert(filePtr);
+void imageToneMap(Image image, const ImageToneMap *toneMap)
+{
+   initSRGB();
+   image->toneMap = *toneMap;
+   toneMapBuffer(&image->toneMap, image->hdr, image->buf, 3L*image->width*image->height);
+}
 
-   /* escreve o cabecalho */
-   putc(byteZero,filePtr);     /* 0, no. de caracteres no campo de id da imagem */
-   putc(byteZero,filePtr);     /* = 0, imagem nao tem palheta de cores */
-   putc(imageType,filePtr);    /* = 2 -> imagem "true color" (RGB) */
-   putuint(shortZero,filePtr); /* info sobre a tabela de cores (inexistente) */
-   putuint(shortZero,filePtr);              /* idem */
-   putc(byteZero,filePtr);                  /* idem */
-   putuint(shortZero,filePtr);    /* =0 origem em x */
-   putuint(shortZero,filePtr);    /* =0 origem em y */
-   putuint(image->width,filePtr);   /* largura da imagem em pixels */
-   putuint(image->height,filePtr);  /* altura da imagem em pixels */
-   putc(bitDepth,filePtr);      /* numero de bits de um pixel */
-   putc(byteZero, filePtr);   /* =0 origem no canto inf esquedo sem entrelacamento */
-
-   /* muda os pixels de RGB para BGR */ 
-   for (imageIdx = 0; imageIdx < 3*image->width*image->height ; imageIdx += 3) 
+Image imageLoadPFM(char *filename)
+{
+   FILE          *filePtr;
+   Image          image;
+   char           magic[3];
+   int            width, height;
+   double         scale;
+   long           n, i;
+   unsigned char *bytes, swap;
+
+   filePtr = fopen(filename, "rb");
+   if (!filePtr) return NULL;
+
+   /* cabecalho: "PF", largura, altura e escala (negativa se little endian) */
+   if (fscanf(filePtr, "%2s %d %d %lf", magic, &width, &height, &scale) != 4 ||
+       strcmp(magic, "PF") != 0 || width <= 0 || height <= 0 ||
+       width > 65535 || height > 65535 || scale == 0)
    {
-      colorSwap = image->buf[imageIdx];
-      image->buf[imageIdx] = image->buf[imageIdx + 2];
-      image->buf[imageIdx + 2] = colorSwap;
+      fclose(filePtr);
+      return NULL;
    }
+   getc(filePtr);  /* um unico espaco separa o cabecalho dos dados */
 
-   /* escreve o buf de cores da imagem */
-   fwrite(image->buf, sizeof(unsigned char), 3*image->width*image->height, filePtr);
+   /* as linhas vem de baixo para cima, como em buf */
+   image = imageCreate(width, height);
+   n = 3L*width*height;
+   if (fread(image->hdr, sizeof(float), n, filePtr) != (size_t)n)
+   {
+      fclose(filePtr);
+      imageDestroy(image);
+      return NULL;
+   }
+   fclose(filePtr);
 
-   /* muda os pixels de BGR para RGB novamente */ 
-   for (imageIdx = 0; imageIdx < 3*image->width*image->height ; imageIdx += 3) 
+   if ((scale < 0) != isLittleEndian())
    {
-      colorSwap = image->buf[imageIdx];
-      image->buf[imageIdx] = image->buf[imageIdx + 2];
-      image->buf[imageIdx + 2] = colorSwap;
+      bytes = (unsigned char *)image->hdr;
+      for (i = 0; i < 4*n; i += 4)
+      {
+         swap = bytes[i];   bytes[i]   = bytes[i+3]; bytes[i+3] = swap;
+         swap = bytes[i+1]; bytes[i+1] = bytes[i+2]; bytes[i+2] = swap;
+      }
+   }
+   if (fabs(scale) != 1.0)
+   {
+      for (i = 0; i < n; i++)
+         image->hdr[i] *= (float)fabs(scale);
    }
 
-   fclose(filePtr);
-   return 1;
+   toneMapBuffer(&image->toneMap, image->hdr, image->buf, n);
+   return image;
+}
+
+int imageWritePFM(char *filename, Image image)
+{
+   FILE *filePtr;
+   long  n = 3L*image->width*image->height;
+   int   ok;
+
+   filePtr = fopen(filename, "wb");
+   if (!filePtr) return 0;
+
+   /* a escala negativa indica floats little endian; as linhas vao de baixo para cima */
+   fprintf(filePtr, "PF\n%d %d\n%s\n", image->width, image->height, isLittleEndian() ? "-1.0" : "1.0");
+   ok = (fwrite(image->hdr, sizeof(float), n, filePtr) == (size_t)n);
+
+   if (fclose(filePtr) != 0) ok = 0;
+   return ok;
 }
 
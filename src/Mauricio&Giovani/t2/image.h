@@ -19,6 +19,27 @@
 /************************************************************************/
 /* Tipos Exportados                                                     */
 /************************************************************************/
+/**
+ *   Operadores de mapeamento de tons.
+ */
+typedef enum
+{
+   IMAGE_TONE_CLAMP,      /**< satura as componentes em 1 */
+   IMAGE_TONE_REINHARD    /**< comprime as componentes com x/(1+x) */
+} ImageToneOperator;
+
+/**
+ *   Mapeamento de tons: como as cores lineares sao convertidas nos bytes de buf.
+ *   Cada componente e' multiplicada pela exposicao, comprimida pelo operador,
+ *   saturada em [0,1] e quantizada, linearmente ou com a curva sRGB.
+ */
+typedef struct
+{
+   ImageToneOperator op;        /**< operador de compressao */
+   float             exposure;  /**< fator aplicado antes do operador */
+   int               srgb;      /**< 1 para codificar com a curva sRGB */
+} ImageToneMap;
+
 /**
  *   Imagem com um buffer rgb.
  */
@@ -36,6 +57,15 @@ struct Image_imp
  * buffer RGB                  
  */
   unsigned char  *buf;              
+/**
+ * buffer RGB linear em ponto flutuante, com as cores sem saturacao.
+ * buf e' obtido deste buffer pelo mapeamento de tons.
+ */
+  float          *hdr;
+/**
+ * mapeamento de tons em uso
+ */
+  ImageToneMap    toneMap;
 };  
 
 typedef struct Image_imp * Image;
@@ -71,7 +101,8 @@ void    imageDestroy (Image image);
 void imageGetDimensions(Image image, int *w, int *h);
 
 /**
- *	Ajusta o pixel de uma imagem com a cor especificada.
+ *	Ajusta o pixel de uma imagem com a cor especificada. A cor e' guardada sem
+ *	saturacao e o byte exibido e' obtido pelo mapeamento de tons da imagem.
  *
  *	@param image Handle para uma imagem.
  *	@param x Posicao x na imagem.
@@ -102,7 +133,8 @@ Color imageGetPixel(Image image, int x, int y);
 Image imageResize(Image img0, int w1, int h1);
 
 /**
- *	Le a imagem a partir do arquivo especificado.
+ *	Le a imagem a partir do arquivo especificado (TGA de 24 bits, com ou sem
+ *	compressao RLE).
  *
  *	@param filename Nome do arquivo de imagem.
  *
@@ -112,6 +144,8 @@ Image imageLoad(char *filename);
 
 /**
  *	Salva a imagem no arquivo especificado em formato TGA.
+ *	O buffer da imagem apenas e' lido, de modo que a imagem pode ser salva
+ *	enquanto ainda esta sendo preenchida por outras threads.
  *
  *	@param filename Nome do arquivo de imagem.
  *	@param image Handle para uma imagem.
@@ -120,4 +154,52 @@ Image imageLoad(char *filename);
  */
 int imageWriteTGA(char *filename, Image image);
 
+/**
+ *	Salva a imagem no arquivo especificado em formato TGA comprimido com RLE
+ *	(tipo 10). Regioes de cor constante ocupam poucos bytes no arquivo.
+ *
+ *	@param filename Nome do arquivo de imagem.
+ *	@param image Handle para uma imagem.
+ *
+ *	@return retorna 1 caso nao haja erros.
+ */
+int imageWriteTGARLE(char *filename, Image image);
+
+/**
+ *	Mapeamento de tons padrao: satura, sem exposicao e sem curva sRGB (o
+ *	mesmo resultado de antes do buffer em ponto flutuante).
+ */
+ImageToneMap imageDefaultToneMap(void);
+
+/**
+ *	Troca o mapeamento de tons da imagem e recalcula todos os bytes de buf a
+ *	partir das cores lineares, sem renderizar de novo. Pode ser chamada
+ *	enquanto outras threads preenchem a imagem; os pixels gravados durante a
+ *	chamada podem usar qualquer um dos dois mapeamentos.
+ *
+ *	@param image Handle para uma imagem.
+ *	@param toneMap Novo mapeamento de tons.
+ */
+void imageToneMap(Image image, const ImageToneMap *toneMap);
+
+/**
+ *	Le uma imagem em ponto flutuante no formato PFM (Portable Float Map, "PF").
+ *	Os bytes de buf sao obtidos com o mapeamento de tons padrao.
+ *
+ *	@param filename Nome do arquivo de imagem.
+ *
+ *	@return imagem criada (NULL se o arquivo nao pode ser lido).
+ */
+Image imageLoadPFM(char *filename);
+
+/**
+ *	Salva as cores lineares da imagem, sem mapeamento de tons, no formato PFM.
+ *
+ *	@param filename Nome do arquivo de imagem.
+ *	@param image Handle para uma imagem.
+ *
+ *	@return retorna 1 caso nao haja erros.
+ */
+int imageWritePFM(char *filename, Image image);
+
 #endif
@@ -13,10 +13,31 @@
  */
 
 #include "light.h"
+#include <math.h>
 #include <string.h>
 #include <stdlib.h>
 
 
+/************************************************************************/
+/* Constantes Privadas                                                  */
+/************************************************************************/
+#define PI	3.14159265358979323846
+
+
+/************************************************************************/
+/* Funes Privadas                                                     */
+/************************************************************************/
+/**
+ *	Espalha os bits de um ponto em um inteiro, para deslocar as amostras.
+ */
+static unsigned long lightHash( Vector point );
+
+/**
+ *	Inverso radical de i na base 2: os bits de i espelhados depois da vrgula.
+ */
+static double lightRadicalInverse( unsigned long i );
+
+
 /************************************************************************/
 /* Definio das Funes Exportadas                                     */
 /************************************************************************/
@@ -26,6 +47,33 @@ Light lightCreate( Vector position, Color color )
 
 	light->position = position;
 	light->color = color;
+	light->type = LIGHT_POINT;
+	light->radius = 0;
+	light->edgeU = light->edgeV = algVector( 0, 0, 0, 0 );
+	light->samples = 1;
+
+	return light;
+}
+
+Light lightCreateSphere( Vector center, double radius, Color color, int samples )
+{
+	Light light = lightCreate( center, color );
+
+	light->type = LIGHT_SPHERE;
+	light->radius = radius;
+	light->samples = ( samples > 0 ) ? samples : 1;
+
+	return light;
+}
+
+Light lightCreateQuad( Vector corner, Vector edgeU, Vector edgeV, Color color, int samples )
+{
+	Light light = lightCreate( corner, color );
+
+	light->type = LIGHT_QUAD;
+	light->edgeU = edgeU;
+	light->edgeV = edgeV;
+	light->samples = ( samples > 0 ) ? samples : 1;
 
 	return light;
 }
@@ -40,6 +88,64 @@ Color lightGetColor( Light light )
 	return light->color;
 }
 
+LightType lightGetType( Light light )
+{
+	return light->type;
+}
+
+int lightGetSamples( Light light )
+{
+	return light->samples;
+}
+
+Vector lightSample( Light light, Vector point, int index, int count )
+{
+	if( light->type == LIGHT_POINT )
+	{
+		return light->position;
+	}
+
+	return lightSampleSeeded( light, point, lightHash( point ), index, count );
+}
+
+unsigned long lightGetSeed( Vector point )
+{
+	return lightHash( point );
+}
+
+Vector lightSampleSeeded( Light light, Vector point, unsigned long seed, int index, int count )
+{
+	double u, v;
+
+	if( light->type == LIGHT_POINT )
+	{
+		return light->position;
+	}
+
+	/* Conjunto de Hammersley com rotao de Cranley-Patterson prpria do ponto */
+	u = ( index + 0.5 ) / count + ( seed & 0xffff ) / 65536.0;
+	v = lightRadicalInverse( (unsigned long)index ) + ( ( seed >> 16 ) & 0xffff ) / 65536.0;
+	u -= floor( u );
+	v -= floor( v );
+
+	if( light->type == LIGHT_QUAD )
+	{
+		return algAdd( light->position, algAdd( algScale( u, light->edgeU ), algScale( v, light->edgeV ) ) );
+	}
+	else
+	{
+		/* Disco perpendicular  direo do ponto, com rea uniforme */
+		Vector w = algUnit( algSub( light->position, point ) );
+		Vector a = ( fabs( w.x ) > 0.9 ) ? algVector( 0, 1, 0, 0 ) : algVector( 1, 0, 0, 0 );
+		Vector s = algUnit( algCross( w, a ) );
+		Vector t = algCross( w, s );
+		double r = light->radius * sqrt( u );
+		double angle = 2 * PI * v;
+
+		return algAdd( light->position, algAdd( algScale( r * cos( angle ), s ), algScale( r * sin( angle ), t ) ) );
+	}
+}
+
 void lightDestroy( Light light )
 {
 	free( light );
@@ -55,3 +161,47 @@ void lightSetColor( Light light, Color color )
 	light->color = color;
 }
 
+
+/************************************************************************/
+/* Definio das Funes Privadas                                       */
+/************************************************************************/
+static unsigned long lightHash( Vector point )
+{
+	const unsigned char *bytes;
+	unsigned long hash = 2166136261UL;
+	VectorReal coordinates[3];
+	size_t i;
+
+	coordinates[0] = point.x;
+	coordinates[1] = point.y;
+	coordinates[2] = point.z;
+	bytes = (const unsigned char *)coordinates;
+
+	/* FNV-1a sobre os bytes das coordenadas, seguido de uma mistura final */
+	for( i = 0; i < sizeof(coordinates); ++i )
+	{
+		hash = ( ( hash ^ bytes[i] ) * 16777619UL ) & 0xffffffffUL;
+	}
+
+	hash ^= hash >> 15;
+	hash = ( hash * 0x2c1b3c6dUL ) & 0xffffffffUL;
+	hash ^= hash >> 12;
+
+	return hash;
+}
+
+static double lightRadicalInverse( unsigned long i )
+{
+	double result = 0;
+	double digit = 0.5;
+
+	for( ; i; i >>= 1, digit *= 0.5 )
+	{
+		if( i & 1 )
+		{
+			result += digit;
+		}
+	}
+
+	return result;
+}
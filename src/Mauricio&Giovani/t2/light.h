@@ -19,9 +19,36 @@
 #include "algebra.h"
 
 
+/************************************************************************/
+/* Constantes Exportadas                                                */
+/************************************************************************/
+/** Amostras de uma luz de rea quando o arquivo de cena no indica outro nmero */
+#define LIGHT_DEFAULT_SAMPLES	16
+
+
 /************************************************************************/
 /* Tipos Exportados                                                     */
 /************************************************************************/
+/**
+ *   Formas de fonte de luz.
+ */
+typedef enum
+{
+	/**
+	 *  Ponto em position.
+	 */
+	LIGHT_POINT,
+	/**
+	 *  Esfera de centro position e raio radius.
+	 */
+	LIGHT_SPHERE,
+	/**
+	 *  Retngulo (ou paralelogramo) com um canto em position e lados edgeU e edgeV.
+	 */
+	LIGHT_QUAD
+}
+LightType;
+
 /**
  *   Luz com posio e intensidade.
  */
@@ -35,6 +62,18 @@ struct _Light
      *  Intensidade da luz em rgb.
      */
 	Color color;
+
+	/**
+     *  Forma da luz e suas dimenses (veja LightType).
+     */
+	LightType type;
+	double radius;
+	Vector edgeU;
+	Vector edgeV;
+	/**
+     *  Nmero de pontos da luz amostrados a cada ponto iluminado (1 em uma luz pontual).
+     */
+	int samples;
 };
 
 typedef struct _Light * Light;
@@ -52,6 +91,32 @@ typedef struct _Light * Light;
  */
 Light lightCreate( Vector position, Color color );
 
+/**
+ *	Cria uma fonte de luz esfrica. Vista de um ponto, ela  amostrada no disco da
+ *	sua silhueta.
+ *
+ *	@param center Centro da esfera.
+ *	@param radius Raio da esfera.
+ *	@param color Cor da luz (somando todas as amostras).
+ *	@param samples Nmero de amostras por ponto iluminado.
+ *
+ *	@return Handle para a fonte de luz.
+ */
+Light lightCreateSphere( Vector center, double radius, Color color, int samples );
+
+/**
+ *	Cria uma fonte de luz retangular, que ilumina igualmente dos dois lados.
+ *
+ *	@param corner Um dos cantos do retngulo.
+ *	@param edgeU Lado do retngulo que parte de corner.
+ *	@param edgeV Outro lado do retngulo que parte de corner.
+ *	@param color Cor da luz (somando todas as amostras).
+ *	@param samples Nmero de amostras por ponto iluminado.
+ *
+ *	@return Handle para a fonte de luz.
+ */
+Light lightCreateQuad( Vector corner, Vector edgeU, Vector edgeV, Color color, int samples );
+
 /**
  *	Obtm a posio em que est localizada uma fonte de luz.
  *
@@ -70,6 +135,44 @@ Vector lightGetPosition( Light light );
  */
 Color lightGetColor( Light light );
 
+/**
+ *	Obtm a forma de uma fonte de luz.
+ */
+LightType lightGetType( Light light );
+
+/**
+ *	Obtm o nmero de amostras de uma fonte de luz por ponto iluminado.
+ */
+int lightGetSamples( Light light );
+
+/**
+ *	Obtm um ponto de uma fonte de luz, visto de um ponto iluminado. As amostras
+ *	0 a count-1 formam um conjunto de Hammersley sobre a luz (uma por faixa em cada
+ *	direo), deslocado de forma pseudo-aleatria a cada ponto iluminado: a penumbra
+ *	fica com rudo fino em vez de faixas. O resultado depende s dos parmetros, de
+ *	modo que pode ser chamada por vrias threads.
+ *
+ *	@param light Fonte de luz.
+ *	@param point Ponto iluminado.
+ *	@param index ndice da amostra, de 0 a count-1.
+ *	@param count Nmero total de amostras.
+ *
+ *	@return Ponto da luz (a prpria posio em uma luz pontual).
+ */
+Vector lightSample( Light light, Vector point, int index, int count );
+
+/**
+ *	Obtm o deslocamento pseudo-aleatrio das amostras de luz vistas de um ponto
+ *	(veja lightSample()). Depende s do ponto: pode ser calculado uma vez para todas
+ *	as amostras das luzes vistas dele.
+ */
+unsigned long lightGetSeed( Vector point );
+
+/**
+ *	Como lightSample(), com o deslocamento j obtido por lightGetSeed( point ).
+ */
+Vector lightSampleSeeded( Light light, Vector point, unsigned long seed, int index, int count );
+
 /**
  *	Destri uma fonte de luz criada com lightCreate().
  *
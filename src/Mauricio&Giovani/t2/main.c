@@ -18,12 +18,18 @@
  */
 
 #include "raytracing.h"
+#include "binary.h"
+#include "texture.h"
+#include "packet.h"
+#include "thread.h"
 #include <stdio.h>
-#include <time.h>
+#include <stdlib.h>
+#include <string.h>
 
 
 /*
- *	Imprime o tempo de renderizacao da cena.
+ *	Imprime o tempo de renderizacao da cena, dados os instantes de inicio e fim
+ *	em milissegundos (veja thrGetMilliseconds()).
  */
 void displayRenderingTime( unsigned long begin, unsigned long end );
  
@@ -32,6 +38,39 @@ void displayRenderingTime( unsigned long begin, unsigned long end );
  */
 void reportProgress( int percentage );
 
+/*
+ *	Verifica se o nome de um arquivo termina com a extensao especificada.
+ */
+int hasExtension( const char *filename, const char *extension );
+
+/*
+ *	Renderiza e destroi a cena, imprimindo o tempo e as estatisticas.
+ *	Retorna NULL em caso de erro.
+ */
+Image renderScene( Scene scene );
+
+/*
+ *	Le as opcoes de renderizacao (que ajustam as variaveis globais de raytracing.h)
+ *	e de gravacao da imagem. Retorna 0 se alguma opcao e' invalida.
+ */
+int readOptions( int argc, char *argv[], ImageToneMap *toneMap, int *compress );
+
+/*
+ *	Le o numero que segue a opcao argv[*i], avancando *i. Retorna 0 se nao ha'
+ *	argumento ou se ele nao e' um numero.
+ */
+int readNumber( int argc, char *argv[], int *i, double *value );
+
+/*
+ *	Converte o nome de um modo de antialiasing. Retorna -1 se o nome e' invalido.
+ */
+int readAntialias( const char *name );
+
+/*
+ *	Imprime as instrucoes de uso.
+ */
+void displayUsage( const char *program );
+
 /*
  *	Funcao principal.
  */
@@ -40,48 +79,75 @@ int main( int argc, char *argv[] )
 	Scene scene;
 	Image image;
 	int result;
-	unsigned long begin;
-	unsigned long end;
+	int compress;
+	ImageToneMap toneMap;
 
 	printf( "Computacao Grafica - Trabalho de Raytracing\n");
 
 	/* Checa argumentos */
-	if( argc != 3 )
+	if( argc < 3 || !readOptions( argc, argv, &toneMap, &compress ) )
 	{
-		printf( "Uso: %s <arquivo de entrada> <arquivo de saida>\n", argv[0] );
+		displayUsage( argv[0] );
 		return 1;
 	}
 
-	/* Le a cena especificada */
-	scene = sceLoad( argv[1] );
-	if( !scene )
+	/* Uma imagem em ponto flutuante e' apenas mapeada de novo, sem renderizar */
+	if( hasExtension( argv[1], ".pfm" ) )
 	{
-		printf( "ERRO: Nao foi possivel ler a cena do arquivo especificado (%s).\n", argv[1] );
-		return 1;
+		image = imageLoadPFM( argv[1] );
+		if( !image )
+		{
+			printf( "ERRO: Nao foi possivel ler a imagem %s.\n", argv[1] );
+			return 1;
+		}
 	}
+	else
+	{
+		/* Le a cena especificada */
+		scene = sceLoad( argv[1] );
+		if( !scene )
+		{
+			printf( "ERRO: Nao foi possivel ler a cena do arquivo especificado (%s).\n", argv[1] );
+			return 1;
+		}
 
-	/* Renderiza a cena */
-	printf( "\nProgresso de renderizacao:   0%%" );
+		if( texGetCount() > 0 )
+		{
+			printf( "Texturas: %d arquivo(s), %lu bytes em memoria.\n", texGetCount(), (unsigned long)texGetResidentBytes() );
+		}
 
-	begin = clock();
-	
-	image = rayTraceScene( scene, reportProgress );
-	
-	end = clock();
+		/* Compila a cena em vez de renderiza-la */
+		if( hasExtension( argv[2], BINARY_EXTENSION ) )
+		{
+			result = binSave( scene, argv[2] );
+			sceDestroy( scene );
 
-	sceDestroy( scene );
+			if( !result )
+			{
+				printf( "ERRO: Nao foi possivel gravar a cena compilada em %s.\n", argv[2] );
+				return 1;
+			}
 
-	/* Checa se a imagem obtida e valida */
-	if( !image )
-	{
-		printf( "\n\nERRO: funcao rayTraceScene().\n" );
-		return 1;
-	}
+			printf( "Cena compilada gravada em %s.\n", argv[2] );
+			return 0;
+		}
 
-	displayRenderingTime( begin, end );
+		image = renderScene( scene );
+		if( !image )
+			return 1;
+	}
 
-	/* Salva imagem no arquivo especificado */
-	result = imageWriteTGA( argv[2], image );	
+	/* Salva imagem no arquivo especificado: as cores lineares em PFM ou, em TGA,
+	   os bytes obtidos com o mapeamento de tons pedido */
+	if( hasExtension( argv[2], ".pfm" ) )
+	{
+		result = imageWritePFM( argv[2], image );
+	}
+	else
+	{
+		imageToneMap( image, &toneMap );
+		result = compress ? imageWriteTGARLE( argv[2], image ) : imageWriteTGA( argv[2], image );
+	}
 	imageDestroy( image );
 
 	if( !result )
@@ -95,7 +161,7 @@ int main( int argc, char *argv[] )
 
 void displayRenderingTime( unsigned long begin, unsigned long end )
 {
-	unsigned long duration = (( end - begin )*1000)/CLOCKS_PER_SEC;
+	unsigned long duration = end - begin;
 
 	unsigned long hours;
 	unsigned long minutes;
@@ -134,3 +200,155 @@ void reportProgress( int percentage )
 	printf( "\b\b\b\b%3i%%", percentage );
 }
 
+Image renderScene( Scene scene )
+{
+	Image image;
+	unsigned long begin;
+	unsigned long end;
+	ShadowStats shadowStats;
+
+	if( antialias != AA_NONE )
+	{
+		printf( "Antialiasing %s.\n", ( antialias == AA_FULL ) ? "com todas as amostras" : "adaptativo" );
+	}
+	else if( wavefront )
+	{
+		printf( "Raios tracados em ondas.\n" );
+	}
+	else if( packets )
+	{
+		printf( "Pacotes de raios: %s.\n", pktGetInstructionSet() );
+	}
+
+	/* Renderiza a cena */
+	printf( "\nProgresso de renderizacao:   0%%" );
+
+	begin = thrGetMilliseconds();
+	
+	image = rayTraceScene( scene, reportProgress );
+	
+	end = thrGetMilliseconds();
+
+	sceDestroy( scene );
+
+	/* Checa se a imagem obtida e valida */
+	if( !image )
+	{
+		printf( "\n\nERRO: funcao rayTraceScene().\n" );
+		return NULL;
+	}
+
+	displayRenderingTime( begin, end );
+
+	rayTraceGetShadowStats( &shadowStats );
+	if( shadowStats.blocked > 0 )
+	{
+		printf( "Raios de sombra: %ld, %ld bloqueados (%.1f%% pelo ultimo bloqueador da luz).\n",
+				shadowStats.traced, shadowStats.blocked, 100.0 * shadowStats.cacheHits / shadowStats.blocked );
+	}
+	if( shadowStats.saved != 0 )
+	{
+		printf( "Amostragem adaptativa: %ld raios de sombra poupados (%.1f%%).\n",
+				shadowStats.saved, 100.0 * shadowStats.saved / ( shadowStats.traced + shadowStats.saved ) );
+	}
+
+	return image;
+}
+
+int readOptions( int argc, char *argv[], ImageToneMap *toneMap, int *compress )
+{
+	int i;
+	double number;
+
+	*toneMap = imageDefaultToneMap();
+	*compress = 0;
+
+	for( i = 3; i < argc; ++i )
+	{
+		if( strcmp( argv[i], "-rle" ) == 0 )
+			*compress = 1;
+		else if( strcmp( argv[i], "-reinhard" ) == 0 )
+			toneMap->op = IMAGE_TONE_REINHARD;
+		else if( strcmp( argv[i], "-srgb" ) == 0 )
+			toneMap->srgb = 1;
+		else if( strcmp( argv[i], "-exposure" ) == 0 && readNumber( argc, argv, &i, &number ) && number > 0 )
+			toneMap->exposure = (float)number;
+		else if( strcmp( argv[i], "-packets" ) == 0 )
+			packets = 1;
+		else if( strcmp( argv[i], "-wavefront" ) == 0 )
+			wavefront = 1;
+		else if( strcmp( argv[i], "-aa" ) == 0 && i + 1 < argc && readAntialias( argv[i + 1] ) >= 0 )
+			antialias = readAntialias( argv[++i] );
+		else if( strcmp( argv[i], "-maxdepth" ) == 0 && readNumber( argc, argv, &i, &number ) &&
+				 number >= 0 && number <= 1000000 && number == (int)number )
+			maxDepth = (int)number;
+		else if( strcmp( argv[i], "-minweight" ) == 0 && readNumber( argc, argv, &i, &number ) &&
+				 number >= 0 && number < 1 )
+			minRayWeight = number;
+		else if( strcmp( argv[i], "-roulette" ) == 0 )
+			russianRoulette = 1;
+		else if( strcmp( argv[i], "-threads" ) == 0 && readNumber( argc, argv, &i, &number ) &&
+				 number >= 0 && number <= 1024 && number == (int)number )
+			renderThreads = (int)number;
+		else
+			return 0;
+	}
+
+	return 1;
+}
+
+int readNumber( int argc, char *argv[], int *i, double *value )
+{
+	char *end;
+
+	if( *i + 1 >= argc )
+		return 0;
+
+	*value = strtod( argv[*i + 1], &end );
+	if( end == argv[*i + 1] || *end != '\0' )
+		return 0;
+
+	++*i;
+	return 1;
+}
+
+int readAntialias( const char *name )
+{
+	if( strcmp( name, "none" ) == 0 )
+		return AA_NONE;
+	if( strcmp( name, "adaptive" ) == 0 )
+		return AA_ADAPTIVE;
+	if( strcmp( name, "full" ) == 0 )
+		return AA_FULL;
+	return -1;
+}
+
+void displayUsage( const char *program )
+{
+	printf( "Uso: %s <arquivo de entrada> <arquivo de saida> [opcoes]\n", program );
+	printf( "     Com saida %s a cena e' compilada em vez de renderizada.\n", BINARY_EXTENSION );
+	printf( "     Com saida .pfm as cores sao gravadas em ponto flutuante, sem mapeamento.\n" );
+	printf( "     Com entrada .pfm a imagem e' lida e mapeada de novo, sem renderizar.\n" );
+	printf( "Opcoes de renderizacao:\n" );
+	printf( "     -threads <n>    usa n threads (0: uma por processador)\n" );
+	printf( "     -packets        traca os raios primarios em pacotes de 2x2 pixels\n" );
+	printf( "     -wavefront      traca os raios em ondas ordenadas (em vez de pacotes)\n" );
+	printf( "     -aa <modo>      antialiasing: none, adaptive ou full\n" );
+	printf( "     -maxdepth <n>   profundidade maxima dos raios secundarios (%d)\n", maxDepth );
+	printf( "     -minweight <w>  peso minimo de um raio secundario na cor (%g)\n", minRayWeight );
+	printf( "     -roulette       roleta russa abaixo do peso minimo, em vez de descartar\n" );
+	printf( "Opcoes da saida TGA:\n" );
+	printf( "     -rle            grava comprimida (TGA RLE)\n" );
+	printf( "     -exposure <f>   multiplica as cores por f\n" );
+	printf( "     -reinhard       comprime as cores com x/(1+x) em vez de saturar\n" );
+	printf( "     -srgb           codifica com a curva sRGB\n" );
+}
+
+int hasExtension( const char *filename, const char *extension )
+{
+	size_t length = strlen( filename );
+	size_t extensionLength = strlen( extension );
+
+	return ( length >= extensionLength && strcmp( filename + length - extensionLength, extension ) == 0 );
+}
+
@@ -7,6 +7,8 @@
 
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
 /*- Inclusao das bibliotecas IUP e CD: ------------------------------------*/
@@ -21,6 +23,9 @@
 #include "color.h"
 #include "algebra.h"
 #include "raytracing.h"
+#include "thread.h"
+#include "packet.h"                 /* conjunto de instrucoes dos pacotes */
+#include "screen.h"                 /* exibe a imagem no canvas como uma textura */
 
 
 /************************************************************************/
@@ -29,13 +34,18 @@
 
 void paint(int x1,int x2, int y1, int y2);
 void setImg (int xRay, int x2, int yRay, int y2);
-void iniFilaQuad (int x1, int x2, int y1, int y2);
-void insFilaQuad (int x1, int x2, int y1, int y2);
-void delFilaQuad (int *x1, int *x2, int *y1, int *y2);
+int iniFilaQuad (long tam);
+long maxQuadCamada (int largura, int altura);
+int insFilaQuad (int x1, int x2, int y1, int y2);
+int delFilaQuad (int *x1, int *x2, int *y1, int *y2);
 void IconLibOpen(void);   /* implemented in "iconlib.c" */
 
 int RefInc(void);
 int RefProg(void);
+int iniRefProg(void);
+void fimRefProg(void);
+void refProgWorker(void *data);
+void novoQuad(int x1, int x2, int y1, int y2, int calcula);
 
 
 /************************************************************************/
@@ -46,8 +56,11 @@ int RefProg(void);
    Scene scene;         /* cena corrente */
    int ref=0;           /* Refinamento: 0-Incremental  1-Progressivo */
    int yc=0;            /* y corrente para Ray Tracing incremetnal */
+   int aa=AA_ADAPTIVE;  /* Anti-aliasing do refinamento incremental (AntialiasMode) */
+   long samples=0;      /* amostras usadas ate' agora pelo refinamento incremental */
    int width,height=-1; /* alrgura e altura corrente */
    Image image;         /* imagem que armazena o resultado at agora do algoritmo */
+   Screen screen;       /* textura que exibe a imagem no canvas */
    Vector eye;
    Camera camera;
 
@@ -59,39 +72,68 @@ int RefProg(void);
 
 
 /*********************************
-  Struct Fila de Quadrantes
+  Struct Quadrante
 *********************************/
 
 
-   typedef struct tgFilaQuad
+   typedef struct tgQuad
 	{
       int x1;
       int x2;
       int y1;
       int y2;
+		
+	} tpQuad ;  
+
+
+/*********************************
+  Struct Posicao da Fila de Quadrantes
+*********************************/
 
-      struct tgFilaQuad * pProx;
+   /* O numero de sequencia diz se a posicao esta' livre para o produtor da
+      volta 'seq' do anel (seq == posicao) ou pronta para o consumidor
+      (seq == posicao + 1) */
+
+   typedef struct tgPosFila
+	{
+      volatile long seq;
+      tpQuad quad;
 		
-	} tpFilaQuad ;  
+	} tpPosFila ;  
 
 
 /*********************************
   Struct Cabeca da Fila de Quadrantes
 *********************************/
 
+   /* Fila sem travas (lock-free) de capacidade fixa, que varias threads podem
+      usar ao mesmo tempo. As posicoes formam um anel alocado uma unica vez e
+      reaproveitado pelas imagens seguintes, sem malloc por quadrante */
 
    typedef struct tgCabecaFila
 	{
 
-      int elem;
-      struct tgFilaQuad * pIni;
-      struct tgFilaQuad * pFim;
+      tpPosFila * pAnel;
+      long tam;             /* capacidade do anel (potencia de 2) */
+      volatile long ini;    /* proxima posicao a retirar */
+      volatile long fim;    /* proxima posicao a inserir */
 		
 	} tpCabecaFila ;  
 
 
-   static tpFilaQuad * pFilaQuad = NULL;
-   static tpCabecaFila * pCabecaFila = NULL;
+   static tpCabecaFila cabecaFila = { NULL, 0, 0, 0 };
+
+
+/*********************************
+  Estado do Refinamento Progressivo
+*********************************/
+
+   static Thread * pThreads = NULL;       /* threads refinando; NULL se parado */
+   static int nThreads = 0;
+   static volatile long pendentes = 0;    /* quadrantes na fila ou sendo refinados */
+   static volatile long parar = 0;        /* pede que as threads terminem */
+   static volatile long filaCheia = 0;    /* um quadrante nao coube na fila (erro) */
+   static volatile long * pLinhaSuja = NULL; /* linhas alteradas desde o ultimo quadro */
 
 
 /************************************************************************/
@@ -153,8 +195,8 @@ static char * get_new_file_name( void )
 
   IupSetAttribute(getfile, IUP_TITLE, "Salva arquivo"  );
   IupSetAttribute(getfile, IUP_DIALOGTYPE, IUP_SAVE);
-  IupSetAttribute(getfile, IUP_FILTER, "*.tga");
-  IupSetAttribute(getfile, IUP_FILTERINFO, "Arquivo de imagem (*.tga)");
+  IupSetAttribute(getfile, IUP_FILTER, "*.tga;*.pfm");
+  IupSetAttribute(getfile, IUP_FILTERINFO, "Arquivo de imagem (*.tga, *.pfm)");
   IupPopup(getfile, IUP_CENTER, IUP_CENTER);  /* o posicionamento nao esta sendo respeitado no Windows */
 
   filename = IupGetAttribute(getfile, IUP_VALUE);
@@ -166,7 +208,24 @@ int save_cb(Ihandle *self)
 {
   char* filename = get_new_file_name( );  /* chama o dialogo de abertura de arquivo */
   if (filename==NULL) return 0;
-  imageWriteTGA(filename,image);
+  /* nenhum deles interrompe o refinamento em andamento */
+  if (strlen(filename) > 4 && strcmp(filename + strlen(filename) - 4, ".pfm") == 0)
+    imageWritePFM(filename,image);   /* cores lineares, sem mapeamento de tons */
+  else
+  {
+    /* TGA comprimido e' menor, mas nem todo programa le RLE */
+    switch (IupAlarm ("Salvar Imagem",
+         "== FORMATO TGA ==", "Sem compressao", "Comprimido (RLE)", "Cancelar"))
+    {
+      case 1:
+        imageWriteTGA(filename,image);
+        break;
+
+      case 2:
+        imageWriteTGARLE(filename,image);
+        break;
+    }
+  }
   return IUP_DEFAULT;
 }
 
@@ -176,8 +235,6 @@ int save_cb(Ihandle *self)
 int repaint_cb(Ihandle *self)
 {
   int w,h;
-  int x,y;
-  Color rgb;
 
 
   if (yc!= height) return IUP_DEFAULT; /* esta callback so'desenha depois que o algoritmo termina a imagem */
@@ -187,15 +244,8 @@ int repaint_cb(Ihandle *self)
   glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
   glClear(GL_COLOR_BUFFER_BIT);
 
-  glBegin(GL_POINTS);
-    for (y=0;y<h;y++) {
-      for (x=0; x<w; x++) {
-         rgb=imageGetPixel(image, x, y);
-         glColor3f((float)rgb.red,(float)rgb.green,(float)rgb.blue);
-         glVertex2i(x,y);
-       }
-    }
-  glEnd();
+  /* A textura ja' tem a imagem inteira: um unico quadrilatero */
+  scrDraw(screen, 0, 0, w, h);
   
   glFlush();
   return IUP_DEFAULT; /* retorna o controle para o gerenciador de eventos */
@@ -218,7 +268,8 @@ int repaint_cb(Ihandle *self)
 
    int idle_cb(void)
    {
-      if (ref== 1)
+      /* Uma vez iniciado, o refinamento progressivo vai ate' o fim */
+      if (ref== 1 || pThreads != NULL)
          return RefProg();
 
       else
@@ -240,32 +291,43 @@ int repaint_cb(Ihandle *self)
 
    int RefInc(void)
    {
-	   int x;
+	   int x, y2;
 	   
-	   /* Faz uma linha de pixels por vez */
-       if (yc<height) {
+	   /* Com pacotes ou ondas (e sem anti-aliasing) faz duas linhas, a altura de um pacote */
+       if (yc<height && (packets || wavefront) && aa==AA_NONE) {
            IupGLMakeCurrent(canvas);
-           glBegin(GL_POINTS);
-   		   for( x = 0; x < width; ++x ) {
-     		   Color pixel = { 0.0, 0.0, 0.0 };
-			   Vector ray;				
-			   Color color;
+           y2 = (yc+2 < height) ? yc+2 : height;
+           rayTraceRegion( scene, image, 0, yc, width, y2 );
+           samples += (long)width*(y2-yc);
 
-			   ray = camGetRay( camera, x, yc );
+           paint(0, width-1, yc, y2-1);
+           yc = y2;
 
-			   /* Obtm a amostra. */
-			   color = rayTrace( scene, eye, ray, 0 );
+		   if (yc==height)
+		     IupSetfAttribute(label, "TITLE", "%3dx%3d  %s %s", width, height,
+		                      wavefront ? "ondas" : "pacotes", wavefront ? "" : pktGetInstructionSet());
+       }
+	   /* Faz uma linha de pixels por vez */
+       else if (yc<height) {
+           IupGLMakeCurrent(canvas);
+   		   for( x = 0; x < width; ++x ) {
+			   Color pixel;
+			   int n;
 
-			   /* Adiciona a contribuio da amostra  cor final */
-			   pixel = colorAddition( pixel, color );
+			   /* Obtm a cor do pixel, com mais amostras nas bordas se houver anti-aliasing */
+			   pixel = rayTracePixel( scene, x, yc, (AntialiasMode)aa, AA_THRESHOLD, &n );
+			   samples += n;
 
 			   imageSetPixel( image, x, yc, pixel );
-               glColor3f((float)pixel.red,(float)pixel.green,(float)pixel.blue);
-               glVertex2i(x,yc);
-			   
  		   }
-		   glEnd();
+
+		   /* Envia a linha inteira de uma vez */
+		   paint(0, width-1, yc, yc);
 		   yc++;
+
+		   if (yc==height)
+		     IupSetfAttribute(label, "TITLE", "%3dx%3d  %.2f amostras/pixel", width, height,
+		                      (double)samples/((double)width*height));
 	   }
 	   else
 	     IupSetFunction (IUP_IDLE_ACTION, (Icallback) NULL); /* a imagem ja' esta' completa */
@@ -281,43 +343,211 @@ int repaint_cb(Ihandle *self)
 		===================================
 
   Funcao:  RefProg
-  Ideia:   Refinamento de mosaico inverso.
+  Ideia:   Refinamento de mosaico inverso, calculado por varias threads.
+          A cada camada de idle, so' envia para a tela as linhas que as
+          threads alteraram desde a anterior.
 
 **********************************************************************/
 
 
    int RefProg(void)
    {
-      int w,h;
-      int xm, ym, x, y;
+      int y, y1, y2;
+      int terminou;
 
 
-      Color pixel = { 0.0, 0.0, 0.0 };			   
+      /* Primeira chamada: dispara as threads */
+
+      if (pThreads == NULL)
+      {
+         if (!iniRefProg())
+            IupSetFunction (IUP_IDLE_ACTION, (Icallback) NULL);
+
+         return IUP_DEFAULT;
+      }
 
-      w=width-1;
-      h=height-1;   
+
+      /* Lido antes da pintura: as linhas marcadas pelos ultimos quadrantes
+         ainda serao pintadas abaixo */
+
+      terminou = (pendentes == 0 || filaCheia);
+
+
+      /* Pintar as linhas alteradas desde o ultimo quadro, como um unico
+         retangulo que vai da primeira 'a ultima */
+
+      y1 = height;
+      y2 = -1;
+
+      for (y=0; y<height; y++)
+      {
+         if (thrAtomicCompareExchange (&pLinhaSuja[y], 1, 0) == 1)
+         {
+            if (y < y1) y1 = y;
+            y2 = y;
+         }
+      }
+
+      if (y2 >= y1)
+      {
+         IupGLMakeCurrent(canvas);
+         paint (0, width-1, y1, y2);
+         glFlush();
+      }
+
+
+      if (terminou)
+      {
+         fimRefProg();
+
+         if (filaCheia)
+            IupSetfAttribute(label, "TITLE", "%3dx%3d  ERRO: fila de quadrantes cheia", width, height);
+
+      /* Para que o canvas possa ser redezenhado */
+
+         yc = height;
+         IupSetFunction (IUP_IDLE_ACTION, (Icallback) NULL);
+      }
+      else
+         Sleep (10);   /* ~100 quadros por segundo; o resto do processador fica com as threads */
+
+	   return IUP_DEFAULT;
+   }
+
+
+/**********************************************************************
+
+		===================================
+			Iniciar o Refinamento
+		===================================
+
+  Funcao:  iniRefProg
+  Ideia:   Pinta a imagem inteira com a cor do pixel inferior esquerdo,
+          poe o quadro inteiro na fila e dispara as threads.
+
+**********************************************************************/
+
+   int iniRefProg(void)
+   {
+      int i;
+      int iniciadas;
+      long tam;
+
+
+      nThreads = (renderThreads > 0) ? renderThreads : thrGetProcessorCount();
+
+      /* A fila nunca guarda mais que a maior camada da arvore de quadrantes;
+         alem dela, cada thread pode estar lendo uma posicao */
+
+      for (tam = 1; tam < maxQuadCamada (width, height) + nThreads; tam *= 2)
+         ;
+
+      free ((void *) pLinhaSuja);
+      pLinhaSuja = (volatile long *) calloc (height, sizeof (long));
+
+      if (pLinhaSuja == NULL || !iniFilaQuad (tam))
+         return 0;
+
+      pThreads = (Thread *) calloc (nThreads, sizeof (Thread));
+      if (pThreads == NULL)
+         return 0;
 
 
       /* Inicializa Fila - Quadro da imagem inteira */
 
-      iniFilaQuad (0, w, 0, h);
+      setImg (0, width-1, 0, height-1);
 
-      setImg (0, w, 0, h);
-      
-      glBegin(GL_POINTS);
-      paint  (0, w, 0, h);
-      glFlush();
-      glEnd();
+      pendentes = 1;
+      parar = 0;
+      filaCheia = 0;
+      insFilaQuad (0, width-1, 0, height-1);
+
+      iniciadas = 0;
+      for (i = 0; i < nThreads; i++)
+      {
+         pThreads[i] = thrCreate (refProgWorker, NULL);
+         if (pThreads[i] != NULL)
+            iniciadas++;
+      }
+
+      /* Nenhuma thread pode ser criada: a propria thread da interface refina
+         a imagem inteira, e o proximo RefProg pinta o resultado e termina */
+
+      if (iniciadas == 0)
+      {
+         refProgWorker (NULL);
+         iniciadas = 1;
+      }
+
+      IupSetfAttribute(label, "TITLE", "%3dx%3d  %d threads", width, height, iniciadas);
+
+      return 1;
+   }
+
+
+/**********************************************************************
+
+		===================================
+			Terminar o Refinamento
+		===================================
+
+  Funcao:  fimRefProg
+  Ideia:   Espera as threads terminarem. Com 'parar' ligado, elas param
+          sem esvaziar a fila (nova cena carregada no meio da imagem).
+
+**********************************************************************/
+
+   void fimRefProg(void)
+   {
+      int i;
 
+      if (pThreads == NULL)
+         return;
 
-      while (pCabecaFila->elem != 0)
+      for (i = 0; i < nThreads; i++)
       {
-         glBegin(GL_POINTS);
+         if (pThreads[i] != NULL)
+            thrJoin (pThreads[i]);
+      }
+
+      free (pThreads);
+      pThreads = NULL;
+      parar = 0;
+   }
+
+
+/**********************************************************************
+
+		===================================
+			Thread de Refinamento
+		===================================
 
+  Funcao:  refProgWorker
+  Ideia:   Retira quadrantes da fila, calcula as cores dos quadrantes
+          filhos e os devolve a' fila, ate' nao restar nenhum.
+
+**********************************************************************/
+
+   void refProgWorker(void *data)
+   {
+      int x, w, y, h;
+      int xm, ym;
+
+      while (!parar)
+      {
 
          /* Retira o primeiro da fila */
 
-         delFilaQuad (&x, &w, &y, &h);
+         if (!delFilaQuad (&x, &w, &y, &h))
+         {
+            /* Fila vazia: acabou, ou outra thread ainda vai inserir os filhos do seu quadrante */
+
+            if (pendentes == 0)
+               break;
+
+            thrYield();
+            continue;
+         }
          
          xm = (x+w)/2;
          ym = (y+h)/2;
@@ -331,39 +561,64 @@ int repaint_cb(Ihandle *self)
 
          /* Quadrante 1 - Sup. Esq. */
             
-            insFilaQuad (x,xm,ym+1,h);
-            setImg      (x,xm,ym+1,h);
+            novoQuad (x,xm,ym+1,h, 1);
 
          /* Quadrante 2 - Inf. Dir. */
             
-            insFilaQuad (xm+1,w,y,ym);
-            setImg      (xm+1,w,y,ym);
+            novoQuad (xm+1,w,y,ym, 1);
 
          /* Quadrante 3 - Sup. Dir. */
             
-            insFilaQuad (xm+1,w,ym+1,h);
-            setImg      (xm+1,w,ym+1,h);
+            novoQuad (xm+1,w,ym+1,h, 1);
             
-         /* Quadrante 4 - Inf. Esq. */
+         /* Quadrante 4 - Inf. Esq.: o pixel inferior esquerdo e' o do pai */
             
-            insFilaQuad (x,xm,y,ym);
+            novoQuad (x,xm,y,ym, 0);
 
          }
-         
-      
-      /* Pintar Pixeis calculados na tela */
 
-         paint (0, w, 0, h);   
-         glFlush();
-         glEnd();
+         /* Os filhos ja' foram contados: 'pendentes' so' zera no ultimo quadrante */
+
+         thrAtomicAdd (&pendentes, -1);
       }
-   
+   }
 
-   /* Para que o canvas possa ser redezenhado */
-   
-      yc = height; 
 
-	   return IUP_DEFAULT;
+/**********************************************************************
+
+		===================================
+			Novo Quadrante
+		===================================
+
+  Funcao:  novoQuad
+  Ideia:   Pinta o quadrante com a cor do seu pixel inferior esquerdo
+          (se 'calcula') e o insere na fila. Quadrantes vazios, das
+          bordas de regioes com uma unica coluna ou linha, sao ignorados,
+          e os de um pixel ja' estao prontos: nao entram na fila.
+          Como a fila comporta a maior camada, nao caber nela e' um
+          erro: o refinamento para e o erro aparece no titulo.
+
+**********************************************************************/
+
+   void novoQuad(int x1, int x2, int y1, int y2, int calcula)
+   {
+      if (x1 > x2 || y1 > y2)
+         return;
+
+      if (calcula)
+         setImg (x1, x2, y1, y2);
+
+      if (x1 == x2 && y1 == y2)
+         return;
+
+      thrAtomicIncrement (&pendentes);
+
+      if (!insFilaQuad (x1, x2, y1, y2))
+      {
+         thrAtomicAdd (&pendentes, -1);
+         filaCheia = 1;
+         parar = 1;
+      }
    }
 
 
@@ -374,126 +629,201 @@ int repaint_cb(Ihandle *self)
 		===================================
 
   Funcao:  iniFilaQuad
-  Ideia:   Incializar a fila com o valor do Quadrante dado.
+  Ideia:   Esvazia a fila, garantindo espaco para 'tam' quadrantes (uma
+          potencia de 2). O anel so' e' realocado se precisar crescer.
 
 **********************************************************************/
 
-   void iniFilaQuad (int x1, int x2, int y1, int y2)
+   int iniFilaQuad (long tam)
    {
-      tpFilaQuad   * pFilaQuadAux   = NULL;
-      tpCabecaFila * pCabecaFilaAux = NULL;
+      long i;
 
-      pFilaQuadAux   = (tpFilaQuad *) malloc (1 * (sizeof (tpFilaQuad)));
-      pCabecaFilaAux = (tpCabecaFila *) malloc (1 * (sizeof (tpCabecaFila)));
- 
-      pFilaQuadAux->x1    = x1;
-      pFilaQuadAux->x2    = x2;
-      pFilaQuadAux->y1    = y1;
-      pFilaQuadAux->y2    = y2;
-      pFilaQuadAux->pProx = NULL;
+      if (tam > cabecaFila.tam)
+      {
+         free (cabecaFila.pAnel);
+         cabecaFila.tam   = 0;
+         cabecaFila.pAnel = (tpPosFila *) malloc (tam * sizeof (tpPosFila));
+
+         if (cabecaFila.pAnel == NULL)
+            return 0;
 
-      pFilaQuad = pFilaQuadAux;
+         cabecaFila.tam = tam;
+      }
 
-      pCabecaFilaAux->elem = 1;
-      pCabecaFilaAux->pIni = pFilaQuad;
-      pCabecaFilaAux->pFim = pFilaQuad;
+      for (i = 0; i < cabecaFila.tam; i++)
+         cabecaFila.pAnel[i].seq = i;
 
-      pCabecaFila = pCabecaFilaAux;
+      cabecaFila.ini = 0;
+      cabecaFila.fim = 0;
          
-      return;
+      return 1;
    }
 
 /**********************************************************************
 
 		===================================
-			Insere na Fila
+			Maior Camada de Quadrantes
 		===================================
 
-  Funcao:  insFilaQuad
-  Ideia:   Insere na fila o Quadrante dado.
+  Funcao:  maxQuadCamada
+  Ideia:   Conta, camada a camada, os quadrantes que entram na fila
+          (os de mais de um pixel). Cada eixo e' dividido ao meio
+          independentemente, entao os intervalos de uma camada tem
+          so' dois tamanhos, 't' e 't-1': basta contar quantos ha'
+          de cada. A fila e' percorrida em largura, entao seu tamanho
+          maximo e' o da maior camada (a raiz sempre entra).
 
 **********************************************************************/
 
-   void insFilaQuad (int x1, int x2, int y1, int y2)
+   static void divideEixo (long *t, long n[2])
    {
+      long novoT = (*t + 1) / 2;
+      long novoN[2];
+      long tam;
+      int k;
 
-      tpFilaQuad * pFilaQuadAux = NULL;
-
-      if(pCabecaFila->pIni == NULL)
-         iniFilaQuad (x1, x2, y1, y2);
+      novoN[0] = novoN[1] = 0;
 
-      else
+      for (k = 0; k < 2; k++)
       {
-         pFilaQuadAux = (tpFilaQuad *) malloc (1 * (sizeof (tpFilaQuad)));
- 
-         pFilaQuadAux->x1    = x1;
-         pFilaQuadAux->x2    = x2;
-         pFilaQuadAux->y1    = y1;
-         pFilaQuadAux->y2    = y2;
-         pFilaQuadAux->pProx = NULL;
+         tam = *t - k;
+         if (tam <= 0)
+            continue;
+
+         /* [x, xm] e [xm+1, w]: metades de (tam+1)/2 e tam/2 */
+         novoN[novoT - (tam + 1) / 2] += n[k];
+         if (tam / 2 > 0)
+            novoN[novoT - tam / 2] += n[k];
+      }
+
+      *t = novoT;
+      n[0] = novoN[0];
+      n[1] = novoN[1];
+   }
+
+   static long umPixel (long t, const long n[2])
+   {
+      return (t == 1) ? n[0] : (t == 2) ? n[1] : 0;
+   }
 
+   long maxQuadCamada (int largura, int altura)
+   {
+      long tx = largura, ty = altura;
+      long nx[2], ny[2];
+      long camada, maior = 1;
 
-         (pCabecaFila->pFim)->pProx = pFilaQuadAux;
+      nx[0] = ny[0] = 1;
+      nx[1] = ny[1] = 0;
 
-         pCabecaFila->pFim = pFilaQuadAux;
+      while (tx > 1 || ty > 1)
+      {
+         divideEixo (&tx, nx);
+         divideEixo (&ty, ny);
 
-         pCabecaFila->elem += 1;
+         camada = (nx[0] + nx[1]) * (ny[0] + ny[1]) - umPixel (tx, nx) * umPixel (ty, ny);
+         if (camada > maior)
+            maior = camada;
       }
 
-      return;
-
+      return maior;
    }
 
 /**********************************************************************
 
 		===================================
-			Remove da Fila
+			Insere na Fila
 		===================================
 
-  Funcao:  delFilaQuad
-  Ideia:   Remove o primeiro quadrante da fila.
+  Funcao:  insFilaQuad
+  Ideia:   Insere na fila o Quadrante dado. Varias threads podem inserir
+          e retirar ao mesmo tempo: cada uma reserva uma posicao avancando
+          'fim' com uma troca atomica, e so' depois escreve o quadrante
+          e libera a posicao para os consumidores.
 
 **********************************************************************/
 
-   void delFilaQuad (int *x1, int *x2, int *y1, int *y2)
+   int insFilaQuad (int x1, int x2, int y1, int y2)
    {
-      int xf1, xf2, yf1, yf2;
+      tpPosFila * pPos;
+      long pos, ant, dif;
 
-      tpFilaQuad * pFilaQuadAux = NULL;
+      pos = cabecaFila.fim;
 
-      pFilaQuadAux = pCabecaFila->pIni;
- 
-      xf1 = pFilaQuadAux->x1;
-      xf2 = pFilaQuadAux->x2;
-      yf1 = pFilaQuadAux->y1;
-      yf2 = pFilaQuadAux->y2;
+      for (;;)
+      {
+         pPos = &cabecaFila.pAnel[pos & (cabecaFila.tam - 1)];
+         dif  = pPos->seq - pos;
 
+         if (dif == 0)
+         {
+            ant = thrAtomicCompareExchange (&cabecaFila.fim, pos, pos + 1);
+            if (ant == pos)
+               break;
+            pos = ant;
+         }
+         else if (dif < 0)
+            return 0;   /* fila cheia */
+         else
+            pos = cabecaFila.fim;
+      }
+
+      pPos->quad.x1 = x1;
+      pPos->quad.x2 = x2;
+      pPos->quad.y1 = y1;
+      pPos->quad.y2 = y2;
+
+      /* seq = pos + 1: pronta para o consumidor */
+      thrAtomicIncrement (&pPos->seq);
+
+      return 1;
+   }
+
+/**********************************************************************
 
-      pCabecaFila->elem -= 1;
+		===================================
+			Remove da Fila
+		===================================
 
-      pCabecaFila->pIni = pFilaQuadAux->pProx;
+  Funcao:  delFilaQuad
+  Ideia:   Retira o primeiro Quadrante da fila, do mesmo modo que
+          insFilaQuad reserva as posicoes.
 
-      pFilaQuad = pCabecaFila->pIni;
+**********************************************************************/
 
-      pFilaQuadAux->pProx = NULL;
+   int delFilaQuad (int *x1, int *x2, int *y1, int *y2)
+   {
+      tpPosFila * pPos;
+      long pos, ant, dif;
 
-      free(pFilaQuadAux);
+      pos = cabecaFila.ini;
 
+      for (;;)
+      {
+         pPos = &cabecaFila.pAnel[pos & (cabecaFila.tam - 1)];
+         dif  = pPos->seq - (pos + 1);
 
-      if(pCabecaFila->elem == 1)
-         pCabecaFila->pFim = pCabecaFila->pIni;
-         
+         if (dif == 0)
+         {
+            ant = thrAtomicCompareExchange (&cabecaFila.ini, pos, pos + 1);
+            if (ant == pos)
+               break;
+            pos = ant;
+         }
+         else if (dif < 0)
+            return 0;   /* fila vazia */
+         else
+            pos = cabecaFila.ini;
+      }
 
-      if(pCabecaFila->elem == 0)
-         pCabecaFila->pFim = NULL;
-         
+      (*x1) = pPos->quad.x1;
+      (*x2) = pPos->quad.x2;
+      (*y1) = pPos->quad.y1;
+      (*y2) = pPos->quad.y2;
 
-      (*x1) = xf1;
-      (*x2) = xf2;
-      (*y1) = yf1;
-      (*y2) = yf2;
+      /* seq = pos + tam: livre para o produtor da proxima volta do anel */
+      thrAtomicAdd (&pPos->seq, cabecaFila.tam - 1);
 
-      return;
+      return 1;
    }
 
 
@@ -535,6 +865,10 @@ int repaint_cb(Ihandle *self)
 
       }
 
+      /* Marca as linhas para o proximo quadro (depois de escritos os pixels) */
+      for (y=y1; y<=y2; y++)
+         thrAtomicCompareExchange (&pLinhaSuja[y], 0, 1);
+
       return;
    }
 
@@ -547,7 +881,8 @@ int repaint_cb(Ihandle *self)
 		===================================
 
   Funcao:  paint
-  Ideia:   Pinta na tela o quadrante.
+  Ideia:   Envia o quadrante para a textura da tela e o pinta, como
+          um unico quadrilatero.
 
 **********************************************************************/
 
@@ -555,19 +890,9 @@ int repaint_cb(Ihandle *self)
 
    void paint(int x1,int x2, int y1, int y2)
    {
-      int x, y;
-      Color rgb;
+      scrUpload (screen, x1, y1, x2-x1+1, y2-y1+1);
+      scrDraw   (screen, x1, y1, x2-x1+1, y2-y1+1);
 
-      for (y=y1;y<=y2;y++) {
-         for (x=x1; x<=x2; x++)
-         {
-            rgb=imageGetPixel(image, x, y);
-            glColor3f((float)rgb.red,(float)rgb.green,(float)rgb.blue);
-            glVertex2i(x,y);
-         }
-      }
-
-      IupSetFunction (IUP_IDLE_ACTION, (Icallback) NULL); 
       return;
    
    }
@@ -607,6 +932,165 @@ int repaint_cb(Ihandle *self)
 
 
 
+/**********************************************************************
+
+		===================================
+			CALLBACK Anti-aliasing
+		===================================
+
+  Ideia:   Escolhe quantas amostras por pixel o refinamento incremental
+          usa. O adaptativo so' refina os pixels com bordas.
+
+**********************************************************************/
+
+   int aa_cb(Ihandle *self)
+   {
+      switch (IupAlarm ("Selecionar Anti-aliasing",
+           "== ANTI-ALIASING ==", "Desligado", "Adaptativo", "16 amostras"))
+      {
+         case 1:
+            aa=AA_NONE;
+            break;
+
+         case 2:
+            aa=AA_ADAPTIVE;
+            break;
+
+         case 3:
+            aa=AA_FULL;
+            break;
+     }
+
+     return IUP_DEFAULT;
+
+   }
+
+
+
+/**********************************************************************
+
+		===================================
+			CALLBACK Modo de traado
+		===================================
+
+  Ideia:   Escolhe se o refinamento incremental traa os raios um a um,
+          em pacotes de 2x2 pixels ou em ondas ordenadas (so' sem
+          anti-aliasing), para comparar os caminhos.
+
+**********************************************************************/
+
+   int mode_cb(Ihandle *self)
+   {
+      switch (IupAlarm ("Selecionar Modo de Tracado",
+           "== MODO DE TRACADO ==", "Raio a raio", "Pacotes 2x2", "Ondas"))
+      {
+         case 1:
+            packets=0;
+            wavefront=0;
+            break;
+
+         case 2:
+            packets=1;
+            wavefront=0;
+            break;
+
+         case 3:
+            packets=0;
+            wavefront=1;
+            break;
+     }
+
+     return IUP_DEFAULT;
+
+   }
+
+
+
+/**********************************************************************
+
+		===================================
+			CALLBACKS Mapeamento de tons
+		===================================
+
+  Ideia:   A imagem guarda as cores lineares, sem saturacao. Trocar o
+          operador ou a exposicao apenas recalcula os bytes exibidos,
+          sem renderizar de novo (mesmo durante o refinamento).
+
+**********************************************************************/
+
+   void remapeia(ImageToneMap *toneMap)
+   {
+      int w,h;
+
+      imageGetDimensions(image,&w,&h);
+      imageToneMap(image,toneMap);
+
+      IupGLMakeCurrent(canvas);
+      paint(0, w-1, 0, h-1);
+      glFlush();
+   }
+
+   int tone_cb(Ihandle *self)
+   {
+      ImageToneMap toneMap;
+
+      if (image == NULL) return IUP_DEFAULT;
+      toneMap = image->toneMap;
+
+      switch (IupAlarm ("Selecionar Mapeamento de Tons",
+           "== MAPEAMENTO DE TONS ==", "Saturar", "Reinhard", "Reinhard sRGB"))
+      {
+         case 1:
+            toneMap.op=IMAGE_TONE_CLAMP;
+            toneMap.srgb=0;
+            break;
+
+         case 2:
+            toneMap.op=IMAGE_TONE_REINHARD;
+            toneMap.srgb=0;
+            break;
+
+         case 3:
+            toneMap.op=IMAGE_TONE_REINHARD;
+            toneMap.srgb=1;
+            break;
+     }
+
+     remapeia(&toneMap);
+     return IUP_DEFAULT;
+
+   }
+
+   int exposure_cb(Ihandle *self)
+   {
+      ImageToneMap toneMap;
+
+      if (image == NULL) return IUP_DEFAULT;
+      toneMap = image->toneMap;
+
+      switch (IupAlarm ("Selecionar Exposicao",
+           "== EXPOSICAO ==", "Mais clara (x2)", "Mais escura (/2)", "Original"))
+      {
+         case 1:
+            toneMap.exposure*=2;
+            break;
+
+         case 2:
+            toneMap.exposure/=2;
+            break;
+
+         case 3:
+            toneMap.exposure=1;
+            break;
+     }
+
+     remapeia(&toneMap);
+     return IUP_DEFAULT;
+
+   }
+
+
+
 /* --------------- Gattass ---------------------------- */
 
 /* carrega uma nova cena */
@@ -617,20 +1101,36 @@ int load_cb(void) {
 
   if (filename==NULL) return 0;
 
+  /* Interrompe o refinamento progressivo da cena anterior */
+  parar = 1;
+  fimRefProg();
+
+  /* Libera a cena anterior: as texturas que so' ela usava saem do cache */
+  if (scene) sceDestroy(scene);
+
   /* Le a cena especificada */
   scene = sceLoad( filename );
-  if( scene == NULL ) return IUP_DEFAULT;
+  if( scene == NULL )
+  {
+    /* Nao ha' mais cena para o refinamento incremental continuar */
+    IupSetFunction (IUP_IDLE_ACTION, (Icallback) NULL);
+    return IUP_DEFAULT;
+  }
 
   camera = sceGetCamera( scene );
   eye = camGetEye( camera );
   width = camGetScreenWidth( camera );
   height = camGetScreenHeight( camera );
   yc=0;
+  samples=0;
 
+  scrDestroy(screen);
   if (image) imageDestroy(image);//
 
 
   image = imageCreate( width, height );
+  IupGLMakeCurrent(canvas);
+  screen = scrCreate( image );
   IupSetfAttribute(label, "TITLE", "%3dx%3d", width, height);
   IupSetFunction (IUP_IDLE_ACTION, (Icallback) idle_cb);
   sprintf(buffer,"%3dx%3d", width, height);
@@ -649,7 +1149,7 @@ int init(void)
 {
   Ihandle *dialog, *statusbar,  *box;
 
-  Ihandle *toolbar, *load, *save, *ref;
+  Ihandle *toolbar, *load, *save, *ref, *antialias, *mode, *tone, *exposure;
 
   /* creates the toolbar and its buttons */
   load = IupButton("", "load_cb");
@@ -664,11 +1164,27 @@ int init(void)
   ref = IupButton("", "ref_cb");
   IupSetAttribute(ref,"TIP","Refinamento.");
   IupSetAttribute(ref,"IMAGE","icon_lib_preview");
+
+  antialias = IupButton("AA", "aa_cb");
+  IupSetAttribute(antialias,"TIP","Anti-aliasing.");
+
+  mode = IupButton("Modo", "mode_cb");
+  IupSetAttribute(mode,"TIP","Raios um a um, em pacotes ou em ondas.");
+
+  tone = IupButton("Tons", "tone_cb");
+  IupSetAttribute(tone,"TIP","Mapeamento de tons.");
+
+  exposure = IupButton("Exp", "exposure_cb");
+  IupSetAttribute(exposure,"TIP","Exposicao.");
   
   toolbar = IupHbox(
        load, 
        save,
        ref,
+       antialias,
+       mode,
+       tone,
+       exposure,
 	   IupFill(),
      NULL);
 
@@ -684,6 +1200,10 @@ int init(void)
   IupSetFunction("repaint_cb", (Icallback) repaint_cb);
   IupSetFunction("save_cb", (Icallback)save_cb);
   IupSetFunction("ref_cb", (Icallback)ref_cb);
+  IupSetFunction("aa_cb", (Icallback)aa_cb);
+  IupSetFunction("mode_cb", (Icallback)mode_cb);
+  IupSetFunction("tone_cb", (Icallback)tone_cb);
+  IupSetFunction("exposure_cb", (Icallback)exposure_cb);
   IupSetFunction("resize_cb", (Icallback) resize_cb);
   IupSetFunction (IUP_IDLE_ACTION, (Icallback) NULL);
 
@@ -723,5 +1243,11 @@ void main(void) {
     IconLibOpen();
     if ( init() )
 		IupMainLoop();
+
+    /* As threads de refinamento usam a cena: param antes que ela seja liberada */
+    parar = 1;
+    fimRefProg();
+    if (scene) sceDestroy(scene);
+
     IupClose();
 }
\ No newline at end of file
@@ -0,0 +1,145 @@
+/**
+ *	@file mapping.c Mapping: mapeamento de arquivos em memria, somente para leitura,
+ *		implementado sobre a API Win32 ou sobre mmap.
+ *
+ *	@date
+ *			Criado em:			17 de Outubro de 2026
+ *
+ *	@version 2.0
+ */
+
+#include "mapping.h"
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+/************************************************************************/
+/* Tipos Privados                                                       */
+/************************************************************************/
+struct _MappedFile
+{
+	/**
+	 *  Contedo mapeado e seu tamanho.
+	 */
+	const void *data;
+	size_t size;
+
+	/**
+	 *  Handles do sistema (no Win32 o arquivo e o objeto de mapeamento).
+	 */
+#ifdef _WIN32
+	HANDLE file;
+	HANDLE mapping;
+#else
+	int file;
+#endif
+};
+
+
+/************************************************************************/
+/* Definio das Funes Exportadas                                     */
+/************************************************************************/
+MappedFile mapOpen( const char *filename )
+{
+	MappedFile file = (struct _MappedFile *)malloc( sizeof(struct _MappedFile) );
+
+	if( !file )
+	{
+		return NULL;
+	}
+
+#ifdef _WIN32
+	file->file = CreateFile( filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+							 FILE_ATTRIBUTE_NORMAL, NULL );
+	if( file->file == INVALID_HANDLE_VALUE )
+	{
+		free( file );
+		return NULL;
+	}
+
+	file->size = (size_t)GetFileSize( file->file, NULL );
+	file->mapping = ( file->size > 0 ) ? CreateFileMapping( file->file, NULL, PAGE_READONLY, 0, 0, NULL ) : NULL;
+	file->data = file->mapping ? MapViewOfFile( file->mapping, FILE_MAP_READ, 0, 0, 0 ) : NULL;
+
+	if( !file->data )
+	{
+		if( file->mapping )
+		{
+			CloseHandle( file->mapping );
+		}
+		CloseHandle( file->file );
+		free( file );
+		return NULL;
+	}
+#else
+	{
+		struct stat info;
+		void *data;
+
+		file->file = open( filename, O_RDONLY );
+		if( file->file < 0 )
+		{
+			free( file );
+			return NULL;
+		}
+
+		if( fstat( file->file, &info ) != 0 || info.st_size <= 0 )
+		{
+			close( file->file );
+			free( file );
+			return NULL;
+		}
+
+		file->size = (size_t)info.st_size;
+		data = mmap( NULL, file->size, PROT_READ, MAP_PRIVATE, file->file, 0 );
+		if( data == MAP_FAILED )
+		{
+			close( file->file );
+			free( file );
+			return NULL;
+		}
+
+		file->data = data;
+	}
+#endif
+
+	return file;
+}
+
+const void *mapGetData( MappedFile file )
+{
+	return file->data;
+}
+
+size_t mapGetSize( MappedFile file )
+{
+	return file->size;
+}
+
+void mapClose( MappedFile file )
+{
+	if( !file )
+	{
+		return;
+	}
+
+#ifdef _WIN32
+	UnmapViewOfFile( (LPVOID)file->data );
+	CloseHandle( file->mapping );
+	CloseHandle( file->file );
+#else
+	munmap( (void *)file->data, file->size );
+	close( file->file );
+#endif
+
+	free( file );
+}
@@ -0,0 +1,52 @@
+/**
+ *	@file mapping.h Mapping: mapeamento de arquivos em memria, somente para leitura,
+ *		implementado sobre a API Win32 ou sobre mmap.
+ *
+ *	@date
+ *			Criado em:			17 de Outubro de 2026
+ *
+ *	@version 2.0
+ */
+
+#ifndef _MAPPING_H_
+#define _MAPPING_H_
+
+#include <stddef.h>
+
+
+/************************************************************************/
+/* Tipos Exportados                                                     */
+/************************************************************************/
+typedef struct _MappedFile * MappedFile;
+
+
+/************************************************************************/
+/* Funes Exportadas                                                   */
+/************************************************************************/
+/**
+ *	Mapeia um arquivo inteiro em memria. As pginas so lidas do disco sob demanda,
+ *	 medida que so acessadas.
+ *
+ *	@param filename Nome do arquivo.
+ *
+ *	@return Handle para o mapeamento (NULL se o arquivo no existe, est vazio ou
+ *			no pde ser mapeado).
+ */
+MappedFile mapOpen( const char *filename );
+
+/**
+ *	Obtm o incio do contedo mapeado. O endereo  alinhado a uma pgina.
+ */
+const void *mapGetData( MappedFile file );
+
+/**
+ *	Obtm o tamanho do arquivo mapeado, em bytes.
+ */
+size_t mapGetSize( MappedFile file );
+
+/**
+ *	Desfaz o mapeamento. Ponteiros para o contedo deixam de ser vlidos.
+ */
+void mapClose( MappedFile file );
+
+#endif
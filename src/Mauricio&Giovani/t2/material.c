@@ -21,7 +21,7 @@
 /************************************************************************/
 /* Definio das Funes Exportadas                                     */
 /************************************************************************/
-Material matCreate( Image texture, Color diffuseColor, 
+Material matCreate( Texture texture, Color diffuseColor, 
 					Color specularColor, double specularExponent,
 					double reflectionFactor, double refractionFactor, double opacityFactor )
 {
@@ -38,24 +38,14 @@ Material matCreate( Image texture, Color diffuseColor,
 	return material;
 }
 
-Color matGetDiffuse( Material material, Vector textureCoordinate )
+Color matGetDiffuse( Material material, Vector textureCoordinate, double footprint )
 {
-	int x;
-	int y;
-	int width;
-	int height;
-
 	if( material->texture == NULL )
 	{
 		return material->diffuseColor;
 	}
 
-	imageGetDimensions( material->texture, &width, &height );
-	
-	x = ( (int)( textureCoordinate.x * ( width - 1 ) ) % width );
-	y = ( (int)( textureCoordinate.y * ( height - 1 ) ) % height );
-
-	return imageGetPixel( material->texture, x, y );
+	return texGetColor( material->texture, textureCoordinate.x, textureCoordinate.y, footprint );
 }
 
 Color matGetSpecular( Material material )
@@ -85,6 +75,7 @@ double matGetOpacity( Material material )
 
 void matDestroy( Material material )
 {
+	texRelease( material->texture );
 	free( material );
 }
 
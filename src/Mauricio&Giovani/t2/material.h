@@ -17,7 +17,7 @@
 #define _MATERIAL_H_
 
 #include "color.h"
-#include "image.h"
+#include "texture.h"
 #include "algebra.h"
 
 
@@ -32,7 +32,7 @@ struct _Material
 	/**
      *  Textura do material.
      */
-	Image texture;
+	Texture texture;
 
 	/**
      *  Cor base do material (difusa).
@@ -70,7 +70,8 @@ typedef struct _Material * Material;
 /**
  *	Cria um novo material com as propriedades especificadas.
  *
- *	@param texture Imagem contendo textura do material (pode ser NULL).
+ *	@param texture Textura do material (pode ser NULL). Deve ser uma referncia
+ *				obtida com texAcquire(), que passa a pertencer ao material.
  *	@param diffusecolor Cor base do material ( substituido pela textura, quando presente).
  *	@param specularColor Cor do brilho especular para este material.
  *	@param specularExponent Coeficiente que define o brilho especular.
@@ -81,7 +82,7 @@ typedef struct _Material * Material;
  *
  *	@return Handle para o material criado.
  */
-Material matCreate( Image texture, Color diffuseColor, 
+Material matCreate( Texture texture, Color diffuseColor, 
 					Color specularColor, double specularExponent,
 					double reflectionFactor, double refractionFactor, double opacityFactor );
 
@@ -90,10 +91,12 @@ Material matCreate( Image texture, Color diffuseColor,
  *
  *	@param material Handle para o material do objeto.
  *	@param textureCoordinate Coordenada de textura calculada para o objeto em questo.
+ *	@param footprint Largura, em unidades de coordenada de textura, da regio da
+ *					superfcie vista pelo raio (veja texGetColor()).
  *
  *	@return Cor difusa do objeto num certo ponto.
  */
-Color matGetDiffuse( Material material, Vector textureCoordinate );
+Color matGetDiffuse( Material material, Vector textureCoordinate, double footprint );
 
 /**
  *	Obtm a cor do brilho especular de um material.
@@ -121,7 +124,7 @@ double matGetRefractionIndex( Material material );
 double matGetOpacity( Material material );
 
 /**
- *	Destri um material criado com matCreate().
+ *	Destri um material criado com matCreate(), liberando sua referncia  textura.
  */
 void matDestroy( Material material );
 
@@ -27,6 +27,7 @@
 /* Constantes Privadas                                                  */
 /************************************************************************/
 #define MIN( a, b ) ( ( a < b ) ? a : b )
+#define MAX( a, b ) ( ( a > b ) ? a : b )
 
 #ifndef EPSILON
 #define EPSILON	1.0e-3
@@ -37,15 +38,6 @@
 #endif
 
 
-enum
-{
-	TYPE_UNKNOWN,
-	TYPE_SPHERE,
-	TYPE_TRIANGLE,
-	TYPE_BOX
-};
-
-
 /************************************************************************/
 /* Definio das Funes Exportadas                                     */
 /************************************************************************/
@@ -85,6 +77,10 @@ Object objCreateTriangle( int material, const Vector v0, const Vector v1, const
 	triangle->tex1 = tex1;
 	triangle->tex2 = tex2;
 
+	triangle->edge1 = algSub( v1, v0 );
+	triangle->edge2 = algSub( v2, v0 );
+	triangle->normal = algCross( triangle->edge1, triangle->edge2 );
+
 	object->type = TYPE_TRIANGLE;
 	object->material = material;
 	object->data = triangle;
@@ -113,6 +109,14 @@ Object objCreateBox( int material, const Vector bottomLeft, const Vector topRigh
 
 
 double objIntercept( Object object, Vector eye, Vector ray )
+{
+	double u, v;
+
+	return objInterceptBarycentric( object, eye, ray, &u, &v );
+}
+
+
+double objInterceptBarycentric( Object object, Vector eye, Vector ray, double *u, double *v )
 {
 	switch( object->type )
 	{
@@ -150,45 +154,37 @@ double objIntercept( Object object, Vector eye, Vector ray )
 		{
 			Triangle *t = (Triangle *)object->data;
 
+			/* Mller-Trumbore, com as arestas pr-calculadas em objCreateTriangle() */
+			Vector p = algCross( ray, t->edge2 );
+			double det = algDot( t->edge1, p );
+			double inverse, a, b;
+			Vector s, q;
 
-			double dividend, divisor;
-			double distance = -1.0;
-
-			Vector v0ToV1 = algSub( t->v1, t->v0 );
-			Vector v1ToV2 = algSub( t->v2, t->v1 );
-			Vector normal = algCross( v0ToV1, v1ToV2 );
-			Vector eyeToV0 = algSub( t->v0, eye );
-
-			dividend = algDot( eyeToV0, normal );
-			divisor = algDot( ray, normal );
-
-			if( divisor <= -EPSILON )
+			/* det = -(ray . normal): s a face voltada para o raio  atingida */
+			if( det < EPSILON )
 			{
-				distance = ( dividend / divisor );
+				return -1.0;
 			}
 
-			if( distance >= 1.0 )
+			inverse = 1.0 / det;
+			s = algSub( eye, t->v0 );
+			a = algDot( s, p ) * inverse;
+			if( a < 0.0 || a > 1.0 )
 			{
-				double a0, a1, a2;
-
-				Vector v2ToV0 = algSub( t->v0, t->v2 );
-				Vector p = algAdd( eye, algScale( distance, ray ) );
-				Vector n0 = algCross( v0ToV1, algSub( p, t->v0 ) );
-				Vector n1 = algCross( v1ToV2, algSub( p, t->v1 ) );
-				Vector n2 = algCross( v2ToV0, algSub( p, t->v2 ) );
-
-				normal = algUnit(normal);
-				a0 = ( 0.5 * algDot( normal, n0 ) );
-				a1 = ( 0.5 * algDot( normal, n1 ) );
-				a2 = ( 0.5 * algDot( normal, n2 ) );
+				return -1.0;
+			}
 
-				if ( (a0>0) && (a1>0) && (a2>0) ) 
-					return distance;
-				else
-					return -1.0;
+			q = algCross( s, t->edge1 );
+			b = algDot( ray, q ) * inverse;
+			if( b < 0.0 || a + b > 1.0 )
+			{
+				return -1.0;
 			}
 
-			return distance;
+			*u = a;
+			*v = b;
+
+			return algDot( t->edge2, q ) * inverse;
 		}
 
 	case TYPE_BOX:
@@ -295,8 +291,7 @@ Vector objNormalAt( Object object, Vector point )
 	{
 		Triangle *triangle = (Triangle *)object->data;
 
-		return algCross( algSub( triangle->v1, triangle->v0 ),
-					algSub( triangle->v2, triangle->v0 ) );
+		return triangle->normal;
 	}
 	else if ( object->type == TYPE_BOX )
 	{
@@ -380,49 +375,16 @@ Vector objTextureCoordinateAt( Object object, Vector point )
 
 	else if( object->type == TYPE_TRIANGLE )
 	{
-      Vector n = objNormalAt( object, point );  //unitario?
-      double A1, A2, A3, Ar;
-      double L1, L2, L3;
-
-      Triangle *triangle = (Triangle *)object->data;
-      double u1,u2,u3, v1,v2,v3, u,v;
-      Vector p1, p2, p3, pi;
-      Vector v23, v31, v12;
-
-      u1 = triangle->tex0.x ;
-      v1 = triangle->tex0.y ;
-      u2 = triangle->tex1.x ;
-      v2 = triangle->tex1.y ;
-      u3 = triangle->tex2.x ;
-      v3 = triangle->tex2.y ;
-
-      p1 = triangle->v0;
-      p2 = triangle->v1;
-      p3 = triangle->v2;
-      pi = point;
-
-      v23 = algSub(p2,p3);
-      v31 = algSub(p3,p1);
-      v12 = algSub(p1,p2);
-         
-      A1 = algDot( n , algCross(v23, algSub(pi,p2)) );
-      //A1 = A1/2.0;
-      A2 = algDot( n , algCross(v31, algSub(pi,p3)) );
-      //A2 = A2/2.0;
-      A3 = algDot( n , algCross(v12, algSub(pi,p1)) );
-      //A3 = A3/2.0;
-
-      Ar = A1 + A2 + A3;
-
-      L1 = A1 / Ar;
-      L2 = A2 / Ar;
-      //L3 = A3 / Ar;
-      L3 = 1 - (L1 + L2);
-
-      u= (L1*u1) + (L2*u2) + (L3*u3);
-      v= (L1*v1) + (L2*v2) + (L3*v3);
-		
-		return algVector( u, v, 0, 1 );
+		/* Coordenadas baricntricas pelas reas orientadas, usando a normal pr-calculada */
+		Triangle *triangle = (Triangle *)object->data;
+		Vector n = triangle->normal;
+		Vector fromV0 = algSub( point, triangle->v0 );
+		double area = algDot( n, n );
+
+		double u = algDot( n, algCross( fromV0, triangle->edge2 ) ) / area;
+		double v = algDot( n, algCross( triangle->edge1, fromV0 ) ) / area;
+
+		return objTextureCoordinateAtBarycentric( object, point, u, v );
 	} 
 
 
@@ -433,11 +395,113 @@ Vector objTextureCoordinateAt( Object object, Vector point )
 
 
 
+Vector objTextureCoordinateAtBarycentric( Object object, Vector point, double u, double v )
+{
+	if( object->type == TYPE_TRIANGLE )
+	{
+		Triangle *triangle = (Triangle *)object->data;
+		double w = 1.0 - ( u + v );
+
+		return algVector( ( w * triangle->tex0.x ) + ( u * triangle->tex1.x ) + ( v * triangle->tex2.x ),
+						  ( w * triangle->tex0.y ) + ( u * triangle->tex1.y ) + ( v * triangle->tex2.y ), 0, 1 );
+	}
+
+	return objTextureCoordinateAt( object, point );
+}
+
+double objGetTextureScale( Object object, Vector point )
+{
+	if( object->type == TYPE_SPHERE )
+	{
+		/* As coordenadas variam de 6 ao longo do equador e de 3 entre os plos */
+		Sphere *sphere = (Sphere *)object->data;
+
+		return 3.0 / ( M_PI * sphere->radius );
+	}
+	else if( object->type == TYPE_BOX )
+	{
+		Box *box = (Box *)object->data;
+		double dx = box->topRight.x - box->bottomLeft.x;
+		double dy = box->topRight.y - box->bottomLeft.y;
+		double dz = box->topRight.z - box->bottomLeft.z;
+
+		/* Cada face  mapeada inteira em [0,1]x[0,1]; as faces so as de objTextureCoordinateAt() */
+		if( ( fabs( point.x - box->bottomLeft.x ) < EPSILON ) || ( fabs( point.x - box->topRight.x ) < EPSILON ) )
+		{
+			return 1.0 / sqrt( dy * dz );
+		}
+		else if( ( fabs( point.y - box->bottomLeft.y ) < EPSILON ) || ( fabs( point.y - box->topRight.y ) < EPSILON ) )
+		{
+			return 1.0 / sqrt( dz * dx );
+		}
+		return 1.0 / sqrt( dx * dy );
+	}
+	else if( object->type == TYPE_TRIANGLE )
+	{
+		/* Raiz da razo entre a rea do tringulo no espao de textura e no espao do objeto */
+		Triangle *triangle = (Triangle *)object->data;
+		double textureArea = fabs( ( triangle->tex1.x - triangle->tex0.x ) * ( triangle->tex2.y - triangle->tex0.y ) -
+								   ( triangle->tex2.x - triangle->tex0.x ) * ( triangle->tex1.y - triangle->tex0.y ) );
+		double area = algNorm( triangle->normal );
+
+		return ( area > 0 ) ? sqrt( textureArea / area ) : 0;
+	}
+
+	/* Tipo de Objeto Invlido: nunca deve acontecer */
+	return 0;
+}
+
 int objGetMaterial( Object object )
 {
 	return object->material;
 }
 
+void objGetBoundingBox( Object object, Vector *min, Vector *max )
+{
+	switch( object->type )
+	{
+	case TYPE_SPHERE:
+		{
+			Sphere *s = (Sphere *)object->data;
+
+			*min = algVector( s->center.x - s->radius, s->center.y - s->radius, s->center.z - s->radius, 1 );
+			*max = algVector( s->center.x + s->radius, s->center.y + s->radius, s->center.z + s->radius, 1 );
+			return;
+		}
+
+	case TYPE_TRIANGLE:
+		{
+			Triangle *t = (Triangle *)object->data;
+
+			*min = algVector( MIN( t->v0.x, MIN( t->v1.x, t->v2.x ) ),
+							  MIN( t->v0.y, MIN( t->v1.y, t->v2.y ) ),
+							  MIN( t->v0.z, MIN( t->v1.z, t->v2.z ) ), 1 );
+			*max = algVector( MAX( t->v0.x, MAX( t->v1.x, t->v2.x ) ),
+							  MAX( t->v0.y, MAX( t->v1.y, t->v2.y ) ),
+							  MAX( t->v0.z, MAX( t->v1.z, t->v2.z ) ), 1 );
+			return;
+		}
+
+	case TYPE_BOX:
+		{
+			Box *box = (Box *)object->data;
+
+			*min = algVector( MIN( box->bottomLeft.x, box->topRight.x ),
+							  MIN( box->bottomLeft.y, box->topRight.y ),
+							  MIN( box->bottomLeft.z, box->topRight.z ), 1 );
+			*max = algVector( MAX( box->bottomLeft.x, box->topRight.x ),
+							  MAX( box->bottomLeft.y, box->topRight.y ),
+							  MAX( box->bottomLeft.z, box->topRight.z ), 1 );
+			return;
+		}
+
+	default:
+		/* Tipo de Objeto Invlido: nunca deve acontecer */
+		*min = algVector( 0, 0, 0, 1 );
+		*max = algVector( 0, 0, 0, 1 );
+	}
+}
+
 void objDestroy( Object object )
 {
 	free( object );
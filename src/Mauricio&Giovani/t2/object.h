@@ -22,6 +22,21 @@
 #include "material.h"
 
 
+/************************************************************************/
+/* Constantes Exportadas                                                */
+/************************************************************************/
+/**
+ *   Tipos de objeto (campo type de struct _Object).
+ */
+enum
+{
+	TYPE_UNKNOWN,
+	TYPE_SPHERE,
+	TYPE_TRIANGLE,
+	TYPE_BOX
+};
+
+
 /************************************************************************/
 /* Tipos Exportados                                                     */
 /************************************************************************/
@@ -83,6 +98,16 @@ typedef struct
 	Vector tex0;  /* coordenada de textura do verive 0 */
 	Vector tex1;  /* coordenada de textura do verive 1 */
 	Vector tex2;  /* coordenada de textura do verive 2 */
+
+	/**
+	 *  Arestas v1 - v0 e v2 - v0, pr-calculadas para o teste de Mller-Trumbore.
+	 */
+	Vector edge1;
+	Vector edge2;
+	/**
+	 *  Normal (no normalizada) edge1 x edge2, pr-calculada.
+	 */
+	Vector normal;
 }
 Triangle;
 
@@ -158,6 +183,22 @@ Object objCreateBox( int material, const Vector bottomLeft, const Vector topRigh
  */
 double objIntercept( Object object, Vector eye, Vector ray );
 
+/**
+ *	Igual a objIntercept(), mas tambm retorna as coordenadas baricntricas do ponto
+ *	de interseo quando o objeto  um tringulo, para que a coordenada de textura
+ *	seja obtida sem refazer as contas (veja objTextureCoordinateAtBarycentric()).
+ *
+ *	@param object Handle para um objeto.
+ *	@param eye Origem do raio.
+ *	@param ray Direo do raio.
+ *	@param u [out]Peso de v1 no ponto de interseo (s  alterado para tringulos).
+ *	@param v [out]Peso de v2 no ponto de interseo (s  alterado para tringulos).
+ *
+ *	@return Distncia de eye at a superfcie do objeto no ponto onde ocorreu a
+ *				interseo. Menor ou igual a zero se no houver interseo.
+ */
+double objInterceptBarycentric( Object object, Vector eye, Vector ray, double *u, double *v );
+
 /**
  *	Calcula o vetor normal a um objeto em um ponto.
  *
@@ -179,11 +220,48 @@ Vector objNormalAt( Object object, Vector point );
  */
 Vector objTextureCoordinateAt( Object object, Vector point );
 
+/**
+ *	Estima quanto a coordenada de textura varia por unidade de comprimento sobre a
+ *	superfcie de um objeto, em um ponto. Usada para escolher o nvel de detalhe
+ *	das texturas; em direes diferentes a variao pode ser diferente, e o valor
+ *	retornado  a mdia geomtrica.
+ *
+ *	@param object Handle para um objeto.
+ *	@param point Ponto na superfcie do objeto.
+ *
+ *	@return Variao da coordenada de textura por unidade de comprimento.
+ */
+double objGetTextureScale( Object object, Vector point );
+
+/**
+ *	Calcula a coordenada de textura para um objeto em um ponto de interseo.
+ *	Para tringulos, interpola as coordenadas dos vrtices com as coordenadas
+ *	baricntricas retornadas pela interseo; para os demais tipos, equivale a
+ *	objTextureCoordinateAt().
+ *
+ *	@param object Handle para um objeto.
+ *	@param point Ponto de interseo na superfcie do objeto.
+ *	@param u Peso de v1, retornado por objInterceptBarycentric().
+ *	@param v Peso de v2, retornado por objInterceptBarycentric().
+ *
+ *	@return Coordenada de textura para o objeto no ponto especificado.
+ */
+Vector objTextureCoordinateAtBarycentric( Object object, Vector point, double u, double v );
+
 /**
  *	Obtm o Material de um objeto.
  */
 int objGetMaterial( Object object );
 
+/**
+ *	Calcula a caixa alinhada aos eixos que envolve um objeto.
+ *
+ *	@param object Handle para um objeto.
+ *	@param min [out]Retorna o canto mnimo da caixa.
+ *	@param max [out]Retorna o canto mximo da caixa.
+ */
+void objGetBoundingBox( Object object, Vector *min, Vector *max );
+
 /**
  *	Destri um objeto criado com as funes objCreate*().
  */
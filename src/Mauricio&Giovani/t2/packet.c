@@ -0,0 +1,701 @@
+/**
+ *	@file packet.c Packet: traado de pacotes de raios coerentes (raios primrios de
+ *		pixels vizinhos) com instrues SIMD. Os raios de um pacote percorrem a
+ *		hierarquia juntos e cada primitiva  testada contra todos de uma vez.
+ *		Usa AVX ou SSE2 quando o compilador os oferece; caso contrrio cada raio
+ *		 traado individualmente por bvhGetNearestObject().
+ *
+ *		As contas de cada raio so feitas com as mesmas operaes, na mesma ordem,
+ *		que o traado escalar (primitive.c), ento os resultados so idnticos.
+ *		Compilando com ALGEBRA_FLOAT os quatro raios cabem em um nico registrador
+ *		SSE de floats; nesse caso as contas so feitas em preciso simples e podem
+ *		diferir do traado escalar (que calcula em double) no ltimo bit.
+ *
+ *	@date
+ *			Criado em:			17 de Outubro de 2026
+ *
+ *	@version 2.0
+ */
+
+#include "scene.h"
+#include "packet.h"
+#include <float.h>
+#include <stddef.h>
+
+#if defined( ALGEBRA_FLOAT ) && ( defined( __SSE2__ ) || defined( _M_X64 ) )
+#define PACKET_SSE
+#include <emmintrin.h>
+#elif defined( __AVX__ )
+#define PACKET_AVX
+#include <immintrin.h>
+#elif defined( __SSE2__ ) || defined( _M_X64 )
+#define PACKET_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#define LANE_INLINE static __inline
+#else
+#define LANE_INLINE static __inline__
+#endif
+
+
+#if defined( PACKET_SSE ) || defined( PACKET_AVX ) || defined( PACKET_SSE2 )
+
+/************************************************************************/
+/* Constantes Privadas                                                  */
+/************************************************************************/
+/** Tamanho da pilha de percurso (o mesmo limite usado em bvh.c) */
+#define PACKET_STACK_SIZE	64
+
+/** Maior valor representvel em uma posio de Lanes (distncia "sem interseo") */
+#ifdef PACKET_SSE
+#define LANE_MAX	FLT_MAX
+#else
+#define LANE_MAX	DBL_MAX
+#endif
+
+
+/************************************************************************/
+/* Tipos Privados                                                       */
+/************************************************************************/
+/**
+ *   Quatro valores, um por raio do pacote. Comparaes retornam mscaras com
+ *   todos os bits de cada posio ligados ou desligados.
+ */
+#ifdef PACKET_SSE
+typedef float LaneReal;
+typedef __m128 Lanes;
+#elif defined( PACKET_AVX )
+typedef double LaneReal;
+typedef __m256d Lanes;
+#else
+typedef double LaneReal;
+typedef struct
+{
+	__m128d lo;
+	__m128d hi;
+}
+Lanes;
+#endif
+
+/**
+ *   Identificadores de objeto, um por raio. Em float s os inteiros at 2^24 so
+ *   exatos, ento com PACKET_SSE eles ficam em um registrador de inteiros.
+ */
+#ifdef PACKET_SSE
+typedef __m128i LaneIds;
+#else
+typedef Lanes LaneIds;
+#endif
+
+/**
+ *   Estado de um pacote durante o percurso da hierarquia.
+ */
+typedef struct
+{
+	/** Direes dos raios e seus inversos (para o teste das caixas) */
+	Lanes rayX, rayY, rayZ;
+	Lanes inverseX, inverseY, inverseZ;
+
+	/** 2 * (ray . ray) e 4 * (ray . ray), usados pelas esferas */
+	Lanes twoA;
+	Lanes fourA;
+
+	/** Interseo mais prxima de cada raio at agora */
+	Lanes closest;
+	LaneIds closestId;
+	Lanes u, v;
+}
+Packet;
+
+
+/************************************************************************/
+/* Operaes sobre Lanes                                                */
+/************************************************************************/
+#ifdef PACKET_SSE
+
+LANE_INLINE Lanes laneSet( double a )					{ return _mm_set1_ps( (float)a ); }
+LANE_INLINE Lanes laneLoad( const float *p )			{ return _mm_loadu_ps( p ); }
+LANE_INLINE void laneStore( float *p, Lanes a )		{ _mm_storeu_ps( p, a ); }
+LANE_INLINE Lanes laneAdd( Lanes a, Lanes b )			{ return _mm_add_ps( a, b ); }
+LANE_INLINE Lanes laneSub( Lanes a, Lanes b )			{ return _mm_sub_ps( a, b ); }
+LANE_INLINE Lanes laneMul( Lanes a, Lanes b )			{ return _mm_mul_ps( a, b ); }
+LANE_INLINE Lanes laneDiv( Lanes a, Lanes b )			{ return _mm_div_ps( a, b ); }
+LANE_INLINE Lanes laneSqrt( Lanes a )					{ return _mm_sqrt_ps( a ); }
+LANE_INLINE Lanes laneLt( Lanes a, Lanes b )			{ return _mm_cmplt_ps( a, b ); }
+LANE_INLINE Lanes laneLe( Lanes a, Lanes b )			{ return _mm_cmple_ps( a, b ); }
+LANE_INLINE Lanes laneGt( Lanes a, Lanes b )			{ return _mm_cmpgt_ps( a, b ); }
+LANE_INLINE Lanes laneGe( Lanes a, Lanes b )			{ return _mm_cmpge_ps( a, b ); }
+LANE_INLINE Lanes laneEq( Lanes a, Lanes b )			{ return _mm_cmpeq_ps( a, b ); }
+LANE_INLINE Lanes laneAnd( Lanes a, Lanes b )			{ return _mm_and_ps( a, b ); }
+LANE_INLINE Lanes laneOr( Lanes a, Lanes b )			{ return _mm_or_ps( a, b ); }
+LANE_INLINE Lanes laneNeg( Lanes a )					{ return _mm_xor_ps( a, _mm_set1_ps( -0.0f ) ); }
+LANE_INLINE Lanes laneAbs( Lanes a )					{ return _mm_andnot_ps( _mm_set1_ps( -0.0f ), a ); }
+LANE_INLINE Lanes laneSelect( Lanes m, Lanes a, Lanes b ) { return _mm_or_ps( _mm_and_ps( m, a ), _mm_andnot_ps( m, b ) ); }
+LANE_INLINE int laneMask( Lanes m )					{ return _mm_movemask_ps( m ); }
+
+#elif defined( PACKET_AVX )
+
+LANE_INLINE Lanes laneSet( double a )					{ return _mm256_set1_pd( a ); }
+LANE_INLINE Lanes laneLoad( const double *p )			{ return _mm256_loadu_pd( p ); }
+LANE_INLINE void laneStore( double *p, Lanes a )		{ _mm256_storeu_pd( p, a ); }
+LANE_INLINE Lanes laneAdd( Lanes a, Lanes b )			{ return _mm256_add_pd( a, b ); }
+LANE_INLINE Lanes laneSub( Lanes a, Lanes b )			{ return _mm256_sub_pd( a, b ); }
+LANE_INLINE Lanes laneMul( Lanes a, Lanes b )			{ return _mm256_mul_pd( a, b ); }
+LANE_INLINE Lanes laneDiv( Lanes a, Lanes b )			{ return _mm256_div_pd( a, b ); }
+LANE_INLINE Lanes laneSqrt( Lanes a )					{ return _mm256_sqrt_pd( a ); }
+LANE_INLINE Lanes laneLt( Lanes a, Lanes b )			{ return _mm256_cmp_pd( a, b, _CMP_LT_OQ ); }
+LANE_INLINE Lanes laneLe( Lanes a, Lanes b )			{ return _mm256_cmp_pd( a, b, _CMP_LE_OQ ); }
+LANE_INLINE Lanes laneGt( Lanes a, Lanes b )			{ return _mm256_cmp_pd( a, b, _CMP_GT_OQ ); }
+LANE_INLINE Lanes laneGe( Lanes a, Lanes b )			{ return _mm256_cmp_pd( a, b, _CMP_GE_OQ ); }
+LANE_INLINE Lanes laneEq( Lanes a, Lanes b )			{ return _mm256_cmp_pd( a, b, _CMP_EQ_OQ ); }
+LANE_INLINE Lanes laneAnd( Lanes a, Lanes b )			{ return _mm256_and_pd( a, b ); }
+LANE_INLINE Lanes laneOr( Lanes a, Lanes b )			{ return _mm256_or_pd( a, b ); }
+LANE_INLINE Lanes laneNeg( Lanes a )					{ return _mm256_xor_pd( a, _mm256_set1_pd( -0.0 ) ); }
+LANE_INLINE Lanes laneAbs( Lanes a )					{ return _mm256_andnot_pd( _mm256_set1_pd( -0.0 ), a ); }
+LANE_INLINE Lanes laneSelect( Lanes m, Lanes a, Lanes b ) { return _mm256_blendv_pd( b, a, m ); }
+LANE_INLINE int laneMask( Lanes m )					{ return _mm256_movemask_pd( m ); }
+
+#else
+
+LANE_INLINE Lanes laneSet( double a )
+{
+	Lanes r;
+	r.lo = r.hi = _mm_set1_pd( a );
+	return r;
+}
+
+LANE_INLINE Lanes laneLoad( const double *p )
+{
+	Lanes r;
+	r.lo = _mm_loadu_pd( p );
+	r.hi = _mm_loadu_pd( p + 2 );
+	return r;
+}
+
+LANE_INLINE void laneStore( double *p, Lanes a )
+{
+	_mm_storeu_pd( p, a.lo );
+	_mm_storeu_pd( p + 2, a.hi );
+}
+
+/** Aplica uma operao binria de __m128d s duas metades */
+#define LANE_BINARY( name, op )							\
+	LANE_INLINE Lanes name( Lanes a, Lanes b )			\
+	{													\
+		Lanes r;										\
+		r.lo = op( a.lo, b.lo );						\
+		r.hi = op( a.hi, b.hi );						\
+		return r;										\
+	}
+
+LANE_BINARY( laneAdd, _mm_add_pd )
+LANE_BINARY( laneSub, _mm_sub_pd )
+LANE_BINARY( laneMul, _mm_mul_pd )
+LANE_BINARY( laneDiv, _mm_div_pd )
+LANE_BINARY( laneLt, _mm_cmplt_pd )
+LANE_BINARY( laneLe, _mm_cmple_pd )
+LANE_BINARY( laneGt, _mm_cmpgt_pd )
+LANE_BINARY( laneGe, _mm_cmpge_pd )
+LANE_BINARY( laneEq, _mm_cmpeq_pd )
+LANE_BINARY( laneAnd, _mm_and_pd )
+LANE_BINARY( laneOr, _mm_or_pd )
+
+LANE_INLINE Lanes laneSqrt( Lanes a )
+{
+	Lanes r;
+	r.lo = _mm_sqrt_pd( a.lo );
+	r.hi = _mm_sqrt_pd( a.hi );
+	return r;
+}
+
+LANE_INLINE Lanes laneNeg( Lanes a )
+{
+	Lanes r;
+	__m128d sign = _mm_set1_pd( -0.0 );
+	r.lo = _mm_xor_pd( a.lo, sign );
+	r.hi = _mm_xor_pd( a.hi, sign );
+	return r;
+}
+
+LANE_INLINE Lanes laneAbs( Lanes a )
+{
+	Lanes r;
+	__m128d sign = _mm_set1_pd( -0.0 );
+	r.lo = _mm_andnot_pd( sign, a.lo );
+	r.hi = _mm_andnot_pd( sign, a.hi );
+	return r;
+}
+
+LANE_INLINE Lanes laneSelect( Lanes m, Lanes a, Lanes b )
+{
+	Lanes r;
+	r.lo = _mm_or_pd( _mm_and_pd( m.lo, a.lo ), _mm_andnot_pd( m.lo, b.lo ) );
+	r.hi = _mm_or_pd( _mm_and_pd( m.hi, a.hi ), _mm_andnot_pd( m.hi, b.hi ) );
+	return r;
+}
+
+LANE_INLINE int laneMask( Lanes m )
+{
+	return _mm_movemask_pd( m.lo ) | ( _mm_movemask_pd( m.hi ) << 2 );
+}
+
+#endif
+
+#ifdef PACKET_SSE
+
+LANE_INLINE LaneIds laneIdSet( int a )				{ return _mm_set1_epi32( a ); }
+LANE_INLINE Lanes laneIdLt( LaneIds a, LaneIds b )	{ return _mm_castsi128_ps( _mm_cmplt_epi32( a, b ) ); }
+LANE_INLINE void laneIdStore( int *p, LaneIds a )	{ _mm_storeu_si128( (__m128i *)p, a ); }
+
+LANE_INLINE LaneIds laneIdSelect( Lanes m, LaneIds a, LaneIds b )
+{
+	__m128i mask = _mm_castps_si128( m );
+	return _mm_or_si128( _mm_and_si128( mask, a ), _mm_andnot_si128( mask, b ) );
+}
+
+#else
+
+/* Em double os identificadores so exatos: usam as prprias operaes de Lanes */
+LANE_INLINE LaneIds laneIdSet( int a )				{ return laneSet( (double)a ); }
+LANE_INLINE Lanes laneIdLt( LaneIds a, LaneIds b )	{ return laneLt( a, b ); }
+LANE_INLINE LaneIds laneIdSelect( Lanes m, LaneIds a, LaneIds b ) { return laneSelect( m, a, b ); }
+
+LANE_INLINE void laneIdStore( int *p, LaneIds a )
+{
+	LaneReal values[PACKET_SIZE];
+	int k;
+
+	laneStore( values, a );
+	for( k = 0; k < PACKET_SIZE; ++k )
+	{
+		p[k] = (int)values[k];
+	}
+}
+
+#endif
+
+
+/************************************************************************/
+/* Funes Privadas                                                     */
+/************************************************************************/
+/**
+ *	Testa os raios do pacote contra a caixa de um n (mesmo teste de bvh.c).
+ *
+ *	@return Mscara dos raios que entram na caixa antes da sua interseo mais
+ *			prxima. 'entry' recebe as distncias de entrada.
+ */
+static Lanes intersectNode( const BvhNode *node, Vector eye, const Packet *packet, Lanes *entry );
+
+/**
+ *	Menor valor de 'values' entre as posies ligadas em 'mask'.
+ */
+static double nearestOf( Lanes values, Lanes mask );
+
+/**
+ *	Maior valor de 'values'.
+ */
+static double farthestOf( Lanes values );
+
+/**
+ *	Atualiza a interseo mais prxima dos raios onde 'distance'  melhor.
+ *
+ *	@return Mscara dos raios atualizados.
+ */
+static Lanes updateClosest( Packet *packet, Lanes distance, int id );
+
+/**
+ *	Testam as primitivas de um intervalo de cada tipo contra todos os raios do pacote.
+ */
+static void nearestSpheres( const SphereArray *spheres, int first, int count, Vector eye, Packet *packet );
+static void nearestTriangles( const TriangleArray *triangles, int first, int count, Vector eye, Packet *packet );
+static void nearestBoxes( const BoxArray *boxes, int first, int count, Vector eye, Packet *packet );
+
+
+/************************************************************************/
+/* Definio das Funes Exportadas                                     */
+/************************************************************************/
+void pktGetNearestObjects( Bvh bvh, Vector eye, const Vector rays[PACKET_SIZE], PacketHit *hit )
+{
+	Packet packet;
+	LaneReal x[PACKET_SIZE], y[PACKET_SIZE], z[PACKET_SIZE];
+	LaneReal distance[PACKET_SIZE], u[PACKET_SIZE], v[PACKET_SIZE];
+	int ids[PACKET_SIZE];
+#ifdef PACKET_SSE
+	double refinedU, refinedV;
+#endif
+	int stack[PACKET_STACK_SIZE];
+	double stackEntry[PACKET_STACK_SIZE];
+	int top = 0;
+	int index = 0;
+	Lanes entry;
+	Lanes a;
+	int k;
+
+	for( k = 0; k < PACKET_SIZE; ++k )
+	{
+		x[k] = rays[k].x;
+		y[k] = rays[k].y;
+		z[k] = rays[k].z;
+	}
+
+	packet.rayX = laneLoad( x );
+	packet.rayY = laneLoad( y );
+	packet.rayZ = laneLoad( z );
+	packet.inverseX = laneDiv( laneSet( 1.0 ), packet.rayX );
+	packet.inverseY = laneDiv( laneSet( 1.0 ), packet.rayY );
+	packet.inverseZ = laneDiv( laneSet( 1.0 ), packet.rayZ );
+
+	a = laneAdd( laneAdd( laneMul( packet.rayX, packet.rayX ), laneMul( packet.rayY, packet.rayY ) ),
+				 laneMul( packet.rayZ, packet.rayZ ) );
+	packet.twoA = laneMul( laneSet( 2.0 ), a );
+	packet.fourA = laneMul( laneSet( 4.0 ), a );
+
+	packet.closest = laneSet( LANE_MAX );
+	packet.closestId = laneIdSet( -1 );
+	packet.u = laneSet( 0.0 );
+	packet.v = laneSet( 0.0 );
+
+	if( bvh && bvh->nodeCount > 0 && laneMask( intersectNode( &bvh->nodes[0], eye, &packet, &entry ) ) )
+	{
+		for( ;; )
+		{
+			const BvhNode *node = &bvh->nodes[index];
+
+			if( node->count > 0 )
+			{
+				const BvhLeaf *leaf = &bvh->leaves[node->first];
+
+				nearestSpheres( &bvh->primitives->spheres, leaf->sphereFirst, leaf->sphereCount, eye, &packet );
+				nearestTriangles( &bvh->primitives->triangles, leaf->triangleFirst, leaf->triangleCount, eye, &packet );
+				nearestBoxes( &bvh->primitives->boxes, leaf->boxFirst, leaf->boxCount, eye, &packet );
+			}
+			else
+			{
+				int left = index + 1;
+				int right = node->first;
+				Lanes leftEntry, rightEntry;
+				Lanes leftMask = intersectNode( &bvh->nodes[left], eye, &packet, &leftEntry );
+				Lanes rightMask = intersectNode( &bvh->nodes[right], eye, &packet, &rightEntry );
+				int hitLeft = laneMask( leftMask );
+				int hitRight = laneMask( rightMask );
+
+				/* Um n  visitado se algum raio o atinge. Visita primeiro o filho
+				   em que algum raio entra mais cedo, empilhando o outro */
+				if( hitLeft && hitRight )
+				{
+					double nearestLeft = nearestOf( leftEntry, leftMask );
+					double nearestRight = nearestOf( rightEntry, rightMask );
+
+					if( nearestLeft <= nearestRight )
+					{
+						stackEntry[top] = nearestRight;
+						stack[top++] = right;
+						index = left;
+					}
+					else
+					{
+						stackEntry[top] = nearestLeft;
+						stack[top++] = left;
+						index = right;
+					}
+					continue;
+				}
+				else if( hitLeft )
+				{
+					index = left;
+					continue;
+				}
+				else if( hitRight )
+				{
+					index = right;
+					continue;
+				}
+			}
+
+			/* Descarta os ns em que nenhum raio pode melhorar sua interseo */
+			while( top > 0 && stackEntry[top - 1] > farthestOf( packet.closest ) )
+			{
+				--top;
+			}
+
+			if( top == 0 )
+			{
+				break;
+			}
+
+			index = stack[--top];
+		}
+	}
+
+	laneStore( distance, packet.closest );
+	laneStore( u, packet.u );
+	laneStore( v, packet.v );
+	laneIdStore( ids, packet.closestId );
+
+	for( k = 0; k < PACKET_SIZE; ++k )
+	{
+		hit->object[k] = ( ids[k] >= 0 ) ? bvh->objects[ids[k]] : NULL;
+		hit->distance[k] = ( ids[k] >= 0 ) ? distance[k] : DBL_MAX;
+		hit->u[k] = u[k];
+		hit->v[k] = v[k];
+
+#ifdef PACKET_SSE
+		/* Em float o pacote s escolhe o objeto: a distncia  recalculada em double,
+		   com a preciso que o sombreamento espera (veja objNormalAt() das caixas) */
+		if( hit->object[k] )
+		{
+			double refined = objInterceptBarycentric( hit->object[k], eye, rays[k], &refinedU, &refinedV );
+
+			if( refined > 0 )
+			{
+				hit->distance[k] = refined;
+				hit->u[k] = refinedU;
+				hit->v[k] = refinedV;
+			}
+		}
+#endif
+	}
+}
+
+const char *pktGetInstructionSet( void )
+{
+#ifdef PACKET_AVX
+	return "AVX";
+#else
+	return "SSE2";
+#endif
+}
+
+
+/************************************************************************/
+/* Definio das Funes Privadas                                       */
+/************************************************************************/
+static Lanes intersectNode( const BvhNode *node, Vector eye, const Packet *packet, Lanes *entry )
+{
+	double origin[3];
+	const Lanes *inverse[3];
+	Lanes tmin = laneSet( 0.0 );
+	Lanes tmax = packet->closest;
+	int axis;
+
+	origin[0] = eye.x;
+	origin[1] = eye.y;
+	origin[2] = eye.z;
+
+	inverse[0] = &packet->inverseX;
+	inverse[1] = &packet->inverseY;
+	inverse[2] = &packet->inverseZ;
+
+	for( axis = 0; axis < 3; ++axis )
+	{
+		Lanes t0 = laneMul( laneSet( node->min[axis] - origin[axis] ), *inverse[axis] );
+		Lanes t1 = laneMul( laneSet( node->max[axis] - origin[axis] ), *inverse[axis] );
+		Lanes swap = laneGt( t0, t1 );
+		Lanes entering = laneSelect( swap, t1, t0 );
+		Lanes leaving = laneSelect( swap, t0, t1 );
+
+		/* Comparaes com NaN so falsas, o que ignora o eixo degenerado */
+		tmin = laneSelect( laneGt( entering, tmin ), entering, tmin );
+		tmax = laneSelect( laneLt( leaving, tmax ), leaving, tmax );
+	}
+
+	*entry = tmin;
+
+	/* Negao de tmin > tmax, como no teste escalar */
+	return laneLe( tmin, tmax );
+}
+
+static double nearestOf( Lanes values, Lanes mask )
+{
+	LaneReal v[PACKET_SIZE];
+	double nearest = DBL_MAX;
+	int k;
+
+	laneStore( v, laneSelect( mask, values, laneSet( LANE_MAX ) ) );
+	for( k = 0; k < PACKET_SIZE; ++k )
+	{
+		if( v[k] < nearest )
+			nearest = v[k];
+	}
+
+	return nearest;
+}
+
+static double farthestOf( Lanes values )
+{
+	LaneReal v[PACKET_SIZE];
+	double farthest = -DBL_MAX;
+	int k;
+
+	laneStore( v, values );
+	for( k = 0; k < PACKET_SIZE; ++k )
+	{
+		if( v[k] > farthest )
+			farthest = v[k];
+	}
+
+	return farthest;
+}
+
+static Lanes updateClosest( Packet *packet, Lanes distance, int id )
+{
+	LaneIds ids = laneIdSet( id );
+	Lanes better = laneAnd( laneGt( distance, laneSet( 0.0 ) ),
+							laneOr( laneLt( distance, packet->closest ),
+									laneAnd( laneEq( distance, packet->closest ), laneIdLt( ids, packet->closestId ) ) ) );
+
+	packet->closest = laneSelect( better, distance, packet->closest );
+	packet->closestId = laneIdSelect( better, ids, packet->closestId );
+
+	return better;
+}
+
+static void nearestSpheres( const SphereArray *spheres, int first, int count, Vector eye, Packet *packet )
+{
+	Lanes epsilon = laneSet( EPSILON );
+	Lanes miss = laneSet( -1.0 );
+	int i;
+
+	for( i = first; i < first + count; ++i )
+	{
+		double fx = eye.x - spheres->centerX[i];
+		double fy = eye.y - spheres->centerY[i];
+		double fz = eye.z - spheres->centerZ[i];
+		double radius = spheres->radius[i];
+		double c = ( ( fx * fx + fy * fy + fz * fz ) - ( radius * radius ) );
+
+		Lanes b = laneMul( laneSet( 2.0 ), laneAdd( laneAdd( laneMul( packet->rayX, laneSet( fx ) ),
+															laneMul( packet->rayY, laneSet( fy ) ) ),
+												   laneMul( packet->rayZ, laneSet( fz ) ) ) );
+		Lanes delta = laneSub( laneMul( b, b ), laneMul( packet->fourA, laneSet( c ) ) );
+		Lanes minusB = laneNeg( b );
+		Lanes root = laneSqrt( delta );
+		Lanes tangent = laneDiv( minusB, packet->twoA );
+		Lanes r1 = laneDiv( laneAdd( minusB, root ), packet->twoA );
+		Lanes r2 = laneDiv( laneSub( minusB, root ), packet->twoA );
+		Lanes secant = laneSelect( laneLt( r1, r2 ), r1, r2 );
+
+		Lanes distance = laneSelect( laneLe( laneAbs( delta ), epsilon ), tangent,
+									 laneSelect( laneGt( delta, epsilon ), secant, miss ) );
+
+		updateClosest( packet, distance, spheres->ids[i] );
+	}
+}
+
+static void nearestTriangles( const TriangleArray *triangles, int first, int count, Vector eye, Packet *packet )
+{
+	Lanes zero = laneSet( 0.0 );
+	Lanes one = laneSet( 1.0 );
+	Lanes epsilon = laneSet( EPSILON );
+	int i;
+
+	for( i = first; i < first + count; ++i )
+	{
+		double e1x = triangles->edge1X[i], e1y = triangles->edge1Y[i], e1z = triangles->edge1Z[i];
+		double e2x = triangles->edge2X[i], e2y = triangles->edge2Y[i], e2z = triangles->edge2Z[i];
+		double sx = eye.x - triangles->v0X[i];
+		double sy = eye.y - triangles->v0Y[i];
+		double sz = eye.z - triangles->v0Z[i];
+
+		/* A origem  comum, ento q = s x edge1  o mesmo para todos os raios */
+		double qx = sy * e1z - sz * e1y;
+		double qy = sz * e1x - sx * e1z;
+		double qz = sx * e1y - sy * e1x;
+		double e2DotQ = e2x * qx + e2y * qy + e2z * qz;
+
+		Lanes px = laneSub( laneMul( packet->rayY, laneSet( e2z ) ), laneMul( packet->rayZ, laneSet( e2y ) ) );
+		Lanes py = laneSub( laneMul( packet->rayZ, laneSet( e2x ) ), laneMul( packet->rayX, laneSet( e2z ) ) );
+		Lanes pz = laneSub( laneMul( packet->rayX, laneSet( e2y ) ), laneMul( packet->rayY, laneSet( e2x ) ) );
+		Lanes det = laneAdd( laneAdd( laneMul( laneSet( e1x ), px ), laneMul( laneSet( e1y ), py ) ),
+							 laneMul( laneSet( e1z ), pz ) );
+		Lanes inverse = laneDiv( one, det );
+		Lanes a = laneMul( laneAdd( laneAdd( laneMul( laneSet( sx ), px ), laneMul( laneSet( sy ), py ) ),
+									laneMul( laneSet( sz ), pz ) ), inverse );
+		Lanes b = laneMul( laneAdd( laneAdd( laneMul( packet->rayX, laneSet( qx ) ), laneMul( packet->rayY, laneSet( qy ) ) ),
+									laneMul( packet->rayZ, laneSet( qz ) ) ), inverse );
+		Lanes miss = laneOr( laneOr( laneLt( det, epsilon ), laneOr( laneLt( a, zero ), laneGt( a, one ) ) ),
+							 laneOr( laneLt( b, zero ), laneGt( laneAdd( a, b ), one ) ) );
+		Lanes distance = laneSelect( miss, laneSet( -1.0 ), laneMul( laneSet( e2DotQ ), inverse ) );
+		Lanes better = updateClosest( packet, distance, triangles->ids[i] );
+
+		packet->u = laneSelect( better, a, packet->u );
+		packet->v = laneSelect( better, b, packet->v );
+	}
+}
+
+static void nearestBoxes( const BoxArray *boxes, int first, int count, Vector eye, Packet *packet )
+{
+	Lanes epsilon = laneSet( EPSILON );
+	Lanes minusEpsilon = laneSet( -EPSILON );
+	Lanes zero = laneSet( 0.0 );
+	Lanes okX = laneOr( laneGt( packet->rayX, epsilon ), laneLt( packet->rayX, minusEpsilon ) );
+	Lanes okY = laneOr( laneGt( packet->rayY, epsilon ), laneLt( packet->rayY, minusEpsilon ) );
+	Lanes okZ = laneOr( laneGt( packet->rayZ, epsilon ), laneLt( packet->rayZ, minusEpsilon ) );
+	Lanes positiveX = laneGt( packet->rayX, zero );
+	Lanes positiveY = laneGt( packet->rayY, zero );
+	Lanes positiveZ = laneGt( packet->rayZ, zero );
+	int i;
+
+	for( i = first; i < first + count; ++i )
+	{
+		Lanes xmin = laneSet( boxes->minX[i] ), xmax = laneSet( boxes->maxX[i] );
+		Lanes ymin = laneSet( boxes->minY[i] ), ymax = laneSet( boxes->maxY[i] );
+		Lanes zmin = laneSet( boxes->minZ[i] ), zmax = laneSet( boxes->maxZ[i] );
+		Lanes dx, dy, dz;
+		Lanes x, y, z;
+		Lanes hitX, hitY, hitZ;
+
+		/* Face perpendicular a x voltada para o raio */
+		dx = laneDiv( laneSelect( positiveX, laneSet( boxes->minX[i] - eye.x ), laneSet( boxes->maxX[i] - eye.x ) ),
+					  packet->rayX );
+		y = laneAdd( laneSet( eye.y ), laneMul( dx, packet->rayY ) );
+		z = laneAdd( laneSet( eye.z ), laneMul( dx, packet->rayZ ) );
+		hitX = laneAnd( laneAnd( okX, laneGt( dx, epsilon ) ),
+						laneAnd( laneAnd( laneGe( y, ymin ), laneLe( y, ymax ) ), laneAnd( laneGe( z, zmin ), laneLe( z, zmax ) ) ) );
+
+		/* Face perpendicular a y */
+		dy = laneDiv( laneSelect( positiveY, laneSet( boxes->minY[i] - eye.y ), laneSet( boxes->maxY[i] - eye.y ) ),
+					  packet->rayY );
+		x = laneAdd( laneSet( eye.x ), laneMul( dy, packet->rayX ) );
+		z = laneAdd( laneSet( eye.z ), laneMul( dy, packet->rayZ ) );
+		hitY = laneAnd( laneAnd( okY, laneGt( dy, epsilon ) ),
+						laneAnd( laneAnd( laneGe( x, xmin ), laneLe( x, xmax ) ), laneAnd( laneGe( z, zmin ), laneLe( z, zmax ) ) ) );
+
+		/* Face perpendicular a z */
+		dz = laneDiv( laneSelect( positiveZ, laneSet( boxes->minZ[i] - eye.z ), laneSet( boxes->maxZ[i] - eye.z ) ),
+					  packet->rayZ );
+		x = laneAdd( laneSet( eye.x ), laneMul( dz, packet->rayX ) );
+		y = laneAdd( laneSet( eye.y ), laneMul( dz, packet->rayY ) );
+		hitZ = laneAnd( laneAnd( okZ, laneGt( dz, epsilon ) ),
+						laneAnd( laneAnd( laneGe( x, xmin ), laneLe( x, xmax ) ), laneAnd( laneGe( y, ymin ), laneLe( y, ymax ) ) ) );
+
+		/* As faces so consultadas na mesma ordem do teste escalar */
+		updateClosest( packet, laneSelect( hitX, dx, laneSelect( hitY, dy, laneSelect( hitZ, dz, laneSet( -1.0 ) ) ) ),
+					   boxes->ids[i] );
+	}
+}
+
+#else
+
+/************************************************************************/
+/* Definio das Funes Exportadas (sem SIMD)                          */
+/************************************************************************/
+void pktGetNearestObjects( Bvh bvh, Vector eye, const Vector rays[PACKET_SIZE], PacketHit *hit )
+{
+	int k;
+
+	for( k = 0; k < PACKET_SIZE; ++k )
+	{
+		hit->object[k] = NULL;
+		hit->distance[k] = bvhGetNearestObject( bvh, eye, rays[k], &hit->object[k], &hit->u[k], &hit->v[k] );
+	}
+}
+
+const char *pktGetInstructionSet( void )
+{
+	return "escalar";
+}
+
+#endif
@@ -0,0 +1,75 @@
+/**
+ *	@file packet.h Packet: traado de pacotes de raios coerentes (raios primrios de
+ *		pixels vizinhos) com instrues SIMD. Os raios de um pacote percorrem a
+ *		hierarquia juntos e cada primitiva  testada contra todos de uma vez.
+ *		Usa AVX ou SSE2 quando o compilador os oferece; caso contrrio cada raio
+ *		 traado individualmente por bvhGetNearestObject().
+ *
+ *	@date
+ *			Criado em:			17 de Outubro de 2026
+ *
+ *	@version 2.0
+ */
+
+#ifndef _PACKET_H_
+#define _PACKET_H_
+
+#include "algebra.h"
+#include "object.h"
+#include "bvh.h"
+
+
+/************************************************************************/
+/* Constantes Exportadas                                                */
+/************************************************************************/
+/** Nmero de raios em um pacote */
+#define PACKET_SIZE	4
+
+
+/************************************************************************/
+/* Tipos Exportados                                                     */
+/************************************************************************/
+/**
+ *   Resultado do traado de um pacote: para cada raio, os mesmos valores que
+ *   bvhGetNearestObject() retornaria para ele.
+ */
+typedef struct
+{
+	/**
+	 *  Distncia at o objeto mais prximo. DBL_MAX se o raio no atinge nada.
+	 */
+	double distance[PACKET_SIZE];
+	/**
+	 *  Objeto atingido (indefinido se distance for DBL_MAX).
+	 */
+	Object object[PACKET_SIZE];
+	/**
+	 *  Coordenadas baricntricas, se o objeto atingido for um tringulo.
+	 */
+	double u[PACKET_SIZE];
+	double v[PACKET_SIZE];
+}
+PacketHit;
+
+
+/************************************************************************/
+/* Funes Exportadas                                                   */
+/************************************************************************/
+/**
+ *	Encontra o objeto mais prximo atingido por cada raio de um pacote com origem comum.
+ *
+ *	@param bvh Handle para a hierarquia da cena.
+ *	@param eye Origem comum dos raios.
+ *	@param rays Direes dos PACKET_SIZE raios.
+ *	@param hit [out]Resultado de cada raio.
+ */
+void pktGetNearestObjects( Bvh bvh, Vector eye, const Vector rays[PACKET_SIZE], PacketHit *hit );
+
+/**
+ *	Informa qual conjunto de instrues  usado pelos pacotes nesta compilao.
+ *
+ *	@return "AVX", "SSE2" ou "escalar".
+ */
+const char *pktGetInstructionSet( void );
+
+#endif
@@ -0,0 +1,471 @@
+/**
+ *	@file primitive.c Primitive: armazenamento das primitivas em estrutura de vetores
+ *		(SoA). Cada tipo de primitiva tem seus prprios vetores contguos, um por
+ *		componente, e os testes de interseo percorrem um tipo de cada vez, sem
+ *		passar pelos ponteiros de Object.
+ *
+ *	@date
+ *			Criado em:			17 de Outubro de 2026
+ *
+ *	@version 2.0
+ */
+
+#include "scene.h"
+#include "primitive.h"
+#include <math.h>
+#include <stdlib.h>
+
+
+/************************************************************************/
+/* Constantes Privadas                                                  */
+/************************************************************************/
+#define MIN( a, b ) ( ( a < b ) ? a : b )
+
+
+/************************************************************************/
+/* Funes Privadas                                                     */
+/************************************************************************/
+/**
+ *	Calculam a distncia at a primitiva i de cada tipo, exatamente como objIntercept().
+ *
+ *	@return Distncia ao longo do raio. Menor ou igual a zero se no houver interseo.
+ */
+static double sphereIntercept( const SphereArray *spheres, int i, Vector eye, Vector ray );
+static double triangleIntercept( const TriangleArray *triangles, int i, Vector eye, Vector ray,
+								 double *u, double *v );
+static double boxIntercept( const BoxArray *boxes, int i, Vector eye, Vector ray );
+
+/**
+ *	Aloca um bloco nico para 'arrays' vetores de 'count' componentes e um vetor de ids.
+ *
+ *	@return Incio do bloco de componentes (NULL se no houver memria ou count for zero).
+ */
+static VectorReal *allocateArrays( int count, int arrays, int **ids );
+
+
+/************************************************************************/
+/* Definio das Funes Exportadas                                     */
+/************************************************************************/
+PrimitiveStore primCreate( Object *objects, int count )
+{
+	PrimitiveStore store;
+	int sphereCount = 0;
+	int triangleCount = 0;
+	int boxCount = 0;
+	VectorReal *block;
+	int i;
+
+	store = (struct _PrimitiveStore *)calloc( 1, sizeof(struct _PrimitiveStore) );
+	if( !store )
+	{
+		return NULL;
+	}
+
+	for( i = 0; i < count; ++i )
+	{
+		switch( objects[i]->type )
+		{
+		case TYPE_SPHERE:	++sphereCount;	 break;
+		case TYPE_TRIANGLE: ++triangleCount; break;
+		case TYPE_BOX:		++boxCount;		 break;
+		}
+	}
+
+	/* Os vetores de cada tipo so fatias consecutivas de um mesmo bloco */
+	if( sphereCount > 0 )
+	{
+		block = allocateArrays( sphereCount, PRIM_SPHERE_ARRAYS, &store->spheres.ids );
+		if( !block )
+		{
+			primDestroy( store );
+			return NULL;
+		}
+
+		store->spheres.centerX = block;
+		store->spheres.centerY = block + sphereCount;
+		store->spheres.centerZ = block + 2 * sphereCount;
+		store->spheres.radius  = block + 3 * sphereCount;
+	}
+
+	if( triangleCount > 0 )
+	{
+		block = allocateArrays( triangleCount, PRIM_TRIANGLE_ARRAYS, &store->triangles.ids );
+		if( !block )
+		{
+			primDestroy( store );
+			return NULL;
+		}
+
+		store->triangles.v0X = block;
+		store->triangles.v0Y = block + triangleCount;
+		store->triangles.v0Z = block + 2 * triangleCount;
+		store->triangles.edge1X = block + 3 * triangleCount;
+		store->triangles.edge1Y = block + 4 * triangleCount;
+		store->triangles.edge1Z = block + 5 * triangleCount;
+		store->triangles.edge2X = block + 6 * triangleCount;
+		store->triangles.edge2Y = block + 7 * triangleCount;
+		store->triangles.edge2Z = block + 8 * triangleCount;
+	}
+
+	if( boxCount > 0 )
+	{
+		block = allocateArrays( boxCount, PRIM_BOX_ARRAYS, &store->boxes.ids );
+		if( !block )
+		{
+			primDestroy( store );
+			return NULL;
+		}
+
+		store->boxes.minX = block;
+		store->boxes.minY = block + boxCount;
+		store->boxes.minZ = block + 2 * boxCount;
+		store->boxes.maxX = block + 3 * boxCount;
+		store->boxes.maxY = block + 4 * boxCount;
+		store->boxes.maxZ = block + 5 * boxCount;
+	}
+
+	return store;
+}
+
+int primAdd( PrimitiveStore store, Object object, int id )
+{
+	int i;
+
+	switch( object->type )
+	{
+	case TYPE_SPHERE:
+		{
+			Sphere *s = (Sphere *)object->data;
+			SphereArray *spheres = &store->spheres;
+
+			i = spheres->count++;
+			spheres->centerX[i] = s->center.x;
+			spheres->centerY[i] = s->center.y;
+			spheres->centerZ[i] = s->center.z;
+			spheres->radius[i]  = s->radius;
+			spheres->ids[i] = id;
+			return i;
+		}
+
+	case TYPE_TRIANGLE:
+		{
+			Triangle *t = (Triangle *)object->data;
+			TriangleArray *triangles = &store->triangles;
+
+			i = triangles->count++;
+			triangles->v0X[i] = t->v0.x;
+			triangles->v0Y[i] = t->v0.y;
+			triangles->v0Z[i] = t->v0.z;
+			triangles->edge1X[i] = t->edge1.x;
+			triangles->edge1Y[i] = t->edge1.y;
+			triangles->edge1Z[i] = t->edge1.z;
+			triangles->edge2X[i] = t->edge2.x;
+			triangles->edge2Y[i] = t->edge2.y;
+			triangles->edge2Z[i] = t->edge2.z;
+			triangles->ids[i] = id;
+			return i;
+		}
+
+	case TYPE_BOX:
+		{
+			Box *box = (Box *)object->data;
+			BoxArray *boxes = &store->boxes;
+
+			i = boxes->count++;
+			boxes->minX[i] = box->bottomLeft.x;
+			boxes->minY[i] = box->bottomLeft.y;
+			boxes->minZ[i] = box->bottomLeft.z;
+			boxes->maxX[i] = box->topRight.x;
+			boxes->maxY[i] = box->topRight.y;
+			boxes->maxZ[i] = box->topRight.z;
+			boxes->ids[i] = id;
+			return i;
+		}
+
+	default:
+		/* Tipo de Objeto Invlido: nunca deve acontecer */
+		return -1;
+	}
+}
+
+void primNearestSphere( PrimitiveStore store, int first, int count, Vector eye, Vector ray,
+						double *closest, int *closestId )
+{
+	const SphereArray *spheres = &store->spheres;
+	int i;
+
+	for( i = first; i < first + count; ++i )
+	{
+		double distance = sphereIntercept( spheres, i, eye, ray );
+
+		if( distance > 0.0 && ( distance < *closest ||
+			( distance == *closest && spheres->ids[i] < *closestId ) ) )
+		{
+			*closest = distance;
+			*closestId = spheres->ids[i];
+		}
+	}
+}
+
+void primNearestTriangle( PrimitiveStore store, int first, int count, Vector eye, Vector ray,
+						double *closest, int *closestId, double *u, double *v )
+{
+	const TriangleArray *triangles = &store->triangles;
+	double a, b;
+	int i;
+
+	for( i = first; i < first + count; ++i )
+	{
+		double distance = triangleIntercept( triangles, i, eye, ray, &a, &b );
+
+		if( distance > 0.0 && ( distance < *closest ||
+			( distance == *closest && triangles->ids[i] < *closestId ) ) )
+		{
+			*closest = distance;
+			*closestId = triangles->ids[i];
+			*u = a;
+			*v = b;
+		}
+	}
+}
+
+void primNearestBox( PrimitiveStore store, int first, int count, Vector eye, Vector ray,
+						double *closest, int *closestId )
+{
+	const BoxArray *boxes = &store->boxes;
+	int i;
+
+	for( i = first; i < first + count; ++i )
+	{
+		double distance = boxIntercept( boxes, i, eye, ray );
+
+		if( distance > 0.0 && ( distance < *closest ||
+			( distance == *closest && boxes->ids[i] < *closestId ) ) )
+		{
+			*closest = distance;
+			*closestId = boxes->ids[i];
+		}
+	}
+}
+
+int primAnySphere( PrimitiveStore store, int first, int count, Vector eye, Vector ray,
+					double minDistance, double maxDistance, int *id )
+{
+	int i;
+
+	for( i = first; i < first + count; ++i )
+	{
+		double distance = sphereIntercept( &store->spheres, i, eye, ray );
+
+		if( distance > minDistance && distance < maxDistance )
+		{
+			*id = store->spheres.ids[i];
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+int primAnyTriangle( PrimitiveStore store, int first, int count, Vector eye, Vector ray,
+					double minDistance, double maxDistance, int *id )
+{
+	double u, v;
+	int i;
+
+	for( i = first; i < first + count; ++i )
+	{
+		double distance = triangleIntercept( &store->triangles, i, eye, ray, &u, &v );
+
+		if( distance > minDistance && distance < maxDistance )
+		{
+			*id = store->triangles.ids[i];
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+int primAnyBox( PrimitiveStore store, int first, int count, Vector eye, Vector ray,
+					double minDistance, double maxDistance, int *id )
+{
+	int i;
+
+	for( i = first; i < first + count; ++i )
+	{
+		double distance = boxIntercept( &store->boxes, i, eye, ray );
+
+		if( distance > minDistance && distance < maxDistance )
+		{
+			*id = store->boxes.ids[i];
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+void primDestroy( PrimitiveStore store )
+{
+	if( !store )
+	{
+		return;
+	}
+
+	/* O primeiro vetor de cada tipo  o incio do seu bloco */
+	free( store->spheres.centerX );
+	free( store->spheres.ids );
+	free( store->triangles.v0X );
+	free( store->triangles.ids );
+	free( store->boxes.minX );
+	free( store->boxes.ids );
+	free( store );
+}
+
+
+/************************************************************************/
+/* Definio das Funes Privadas                                       */
+/************************************************************************/
+static double sphereIntercept( const SphereArray *spheres, int i, Vector eye, Vector ray )
+{
+	double fx = eye.x - spheres->centerX[i];
+	double fy = eye.y - spheres->centerY[i];
+	double fz = eye.z - spheres->centerZ[i];
+	double radius = spheres->radius[i];
+
+	double a = ray.x * ray.x + ray.y * ray.y + ray.z * ray.z;
+	double b = ( 2.0 * ( ray.x * fx + ray.y * fy + ray.z * fz ) );
+	double c = ( ( fx * fx + fy * fy + fz * fz ) - ( radius * radius ) );
+	double delta = ( ( b * b ) - ( 4 * a * c ) );
+
+	if( fabs( delta ) <= EPSILON )
+	{
+		return ( -b / ( 2 * a ) );
+	}
+	else if( delta > EPSILON )
+	{
+		double root = sqrt( delta );
+		return MIN( ( ( -b + root ) / ( 2 * a ) ), ( ( -b - root ) / ( 2.0 * a ) ) );
+	}
+
+	return -1.0;
+}
+
+static double triangleIntercept( const TriangleArray *triangles, int i, Vector eye, Vector ray,
+								 double *u, double *v )
+{
+	double e1x = triangles->edge1X[i], e1y = triangles->edge1Y[i], e1z = triangles->edge1Z[i];
+	double e2x = triangles->edge2X[i], e2y = triangles->edge2Y[i], e2z = triangles->edge2Z[i];
+
+	/* p = ray x edge2 */
+	double px = ray.y * e2z - ray.z * e2y;
+	double py = ray.z * e2x - ray.x * e2z;
+	double pz = ray.x * e2y - ray.y * e2x;
+	double det = e1x * px + e1y * py + e1z * pz;
+
+	double sx, sy, sz;
+	double qx, qy, qz;
+	double inverse, a, b;
+
+	/* Mesmo critrio de face de objInterceptBarycentric() */
+	if( det < EPSILON )
+	{
+		return -1.0;
+	}
+
+	inverse = 1.0 / det;
+	sx = eye.x - triangles->v0X[i];
+	sy = eye.y - triangles->v0Y[i];
+	sz = eye.z - triangles->v0Z[i];
+	a = ( sx * px + sy * py + sz * pz ) * inverse;
+	if( a < 0.0 || a > 1.0 )
+	{
+		return -1.0;
+	}
+
+	/* q = s x edge1 */
+	qx = sy * e1z - sz * e1y;
+	qy = sz * e1x - sx * e1z;
+	qz = sx * e1y - sy * e1x;
+	b = ( ray.x * qx + ray.y * qy + ray.z * qz ) * inverse;
+	if( b < 0.0 || a + b > 1.0 )
+	{
+		return -1.0;
+	}
+
+	*u = a;
+	*v = b;
+
+	return ( e2x * qx + e2y * qy + e2z * qz ) * inverse;
+}
+
+static double boxIntercept( const BoxArray *boxes, int i, Vector eye, Vector ray )
+{
+	double xmin = boxes->minX[i];
+	double ymin = boxes->minY[i];
+	double zmin = boxes->minZ[i];
+	double xmax = boxes->maxX[i];
+	double ymax = boxes->maxY[i];
+	double zmax = boxes->maxZ[i];
+
+	double x, y, z;
+	double distance;
+
+	if( ray.x > EPSILON || -ray.x > EPSILON )
+	{
+		distance = ( ( ( ray.x > 0 ) ? xmin : xmax ) - eye.x ) / ray.x;
+
+		if( distance > EPSILON )
+		{
+			y = ( eye.y + ( distance * ray.y ) );
+			z = ( eye.z + ( distance * ray.z ) );
+			if( ( y >= ymin ) && ( y <= ymax ) && ( z >= zmin ) && ( z <= zmax ) )
+				return distance;
+		}
+	}
+
+	if( ray.y > EPSILON || -ray.y > EPSILON )
+	{
+		distance = ( ( ( ray.y > 0 ) ? ymin : ymax ) - eye.y ) / ray.y;
+
+		if( distance > EPSILON )
+		{
+			x = ( eye.x + ( distance * ray.x ) );
+			z = ( eye.z + ( distance * ray.z ) );
+			if( ( x >= xmin ) && ( x <= xmax ) && ( z >= zmin ) && ( z <= zmax ) )
+				return distance;
+		}
+	}
+
+	if( ray.z > EPSILON || -ray.z > EPSILON )
+	{
+		distance = ( ( ( ray.z > 0 ) ? zmin : zmax ) - eye.z ) / ray.z;
+
+		if( distance > EPSILON )
+		{
+			x = ( eye.x + ( distance * ray.x ) );
+			y = ( eye.y + ( distance * ray.y ) );
+			if( ( x >= xmin ) && ( x <= xmax ) && ( y >= ymin ) && ( y <= ymax ) )
+				return distance;
+		}
+	}
+
+	return -1.0;
+}
+
+static VectorReal *allocateArrays( int count, int arrays, int **ids )
+{
+	VectorReal *block = (VectorReal *)malloc( count * arrays * sizeof(VectorReal) );
+
+	*ids = (int *)malloc( count * sizeof(int) );
+	if( !block || !*ids )
+	{
+		free( block );
+		free( *ids );
+		*ids = NULL;
+		return NULL;
+	}
+
+	return block;
+}
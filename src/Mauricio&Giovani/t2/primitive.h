@@ -0,0 +1,166 @@
+/**
+ *	@file primitive.h Primitive: armazenamento das primitivas em estrutura de vetores
+ *		(SoA). Cada tipo de primitiva tem seus prprios vetores contguos, um por
+ *		componente, e os testes de interseo percorrem um tipo de cada vez, sem
+ *		passar pelos ponteiros de Object. As componentes tm a mesma preciso de
+ *		Vector (VectorReal), mas os testes de interseo calculam em double.
+ *
+ *	@date
+ *			Criado em:			17 de Outubro de 2026
+ *
+ *	@version 2.0
+ */
+
+#ifndef _PRIMITIVE_H_
+#define _PRIMITIVE_H_
+
+#include "algebra.h"
+#include "object.h"
+
+
+/************************************************************************/
+/* Constantes Exportadas                                                */
+/************************************************************************/
+/** Nmero de vetores de componentes guardados por primitiva de cada tipo */
+#define PRIM_SPHERE_ARRAYS		4
+#define PRIM_TRIANGLE_ARRAYS	9
+#define PRIM_BOX_ARRAYS			6
+
+
+/************************************************************************/
+/* Tipos Exportados                                                     */
+/************************************************************************/
+/**
+ *   Esferas: centro e raio.
+ */
+typedef struct
+{
+	int count;
+	VectorReal *centerX;
+	VectorReal *centerY;
+	VectorReal *centerZ;
+	VectorReal *radius;
+	/** Identificador de cada esfera, repassado a primAdd() */
+	int *ids;
+}
+SphereArray;
+
+/**
+ *   Tringulos: o vrtice v0 e as arestas edge1 e edge2 pr-calculadas em
+ *   objCreateTriangle(), que  o que o teste de Mller-Trumbore usa.
+ */
+typedef struct
+{
+	int count;
+	VectorReal *v0X;
+	VectorReal *v0Y;
+	VectorReal *v0Z;
+	VectorReal *edge1X;
+	VectorReal *edge1Y;
+	VectorReal *edge1Z;
+	VectorReal *edge2X;
+	VectorReal *edge2Y;
+	VectorReal *edge2Z;
+	int *ids;
+}
+TriangleArray;
+
+/**
+ *   Paraleleppedos: cantos mnimo e mximo.
+ */
+typedef struct
+{
+	int count;
+	VectorReal *minX;
+	VectorReal *minY;
+	VectorReal *minZ;
+	VectorReal *maxX;
+	VectorReal *maxY;
+	VectorReal *maxZ;
+	int *ids;
+}
+BoxArray;
+
+/**
+ *   Conjunto de primitivas, separadas por tipo.
+ */
+struct _PrimitiveStore
+{
+	SphereArray spheres;
+	TriangleArray triangles;
+	BoxArray boxes;
+};
+
+typedef struct _PrimitiveStore * PrimitiveStore;
+
+
+/************************************************************************/
+/* Funes Exportadas                                                   */
+/************************************************************************/
+/**
+ *	Cria um conjunto de primitivas vazio.
+ *
+ *	@param objects Objetos que sero adicionados (usados apenas para contar
+ *					quantas primitivas de cada tipo devem ser alocadas).
+ *	@param count Nmero de objetos no vetor.
+ *
+ *	@return Handle para o conjunto criado (NULL se no houver memria).
+ */
+PrimitiveStore primCreate( Object *objects, int count );
+
+/**
+ *	Copia a geometria de um objeto para o final do vetor do seu tipo. As primitivas
+ *	de um mesmo tipo ficam na ordem em que foram adicionadas.
+ *
+ *	@param store Handle para o conjunto.
+ *	@param object Objeto a ser adicionado.
+ *	@param id Identificador devolvido pelas consultas quando este objeto  atingido.
+ *
+ *	@return Posio da primitiva no vetor do seu tipo (-1 se o tipo  desconhecido).
+ */
+int primAdd( PrimitiveStore store, Object object, int id );
+
+/**
+ *	Procura, entre as primitivas [first, first + count) de um tipo, uma interseo
+ *	mais prxima que a atual. A distncia calculada  a mesma de objIntercept().
+ *	Intersees  mesma distncia so desempatadas pelo menor identificador.
+ *
+ *	@param store Handle para o conjunto.
+ *	@param first Primeira primitiva testada.
+ *	@param count Nmero de primitivas testadas.
+ *	@param eye Origem do raio.
+ *	@param ray Direo do raio.
+ *	@param closest [in/out]Distncia da interseo mais prxima encontrada at agora.
+ *	@param closestId [in/out]Identificador da primitiva correspondente.
+ *	@param u [out]Tringulos: peso de v1 na nova interseo mais prxima.
+ *	@param v [out]Tringulos: peso de v2 na nova interseo mais prxima.
+ */
+void primNearestSphere( PrimitiveStore store, int first, int count, Vector eye, Vector ray,
+						double *closest, int *closestId );
+void primNearestTriangle( PrimitiveStore store, int first, int count, Vector eye, Vector ray,
+						double *closest, int *closestId, double *u, double *v );
+void primNearestBox( PrimitiveStore store, int first, int count, Vector eye, Vector ray,
+						double *closest, int *closestId );
+
+/**
+ *	Verifica se alguma das primitivas [first, first + count) de um tipo intercepta
+ *	o raio estritamente entre minDistance e maxDistance.
+ *
+ *	@param id [out]Identificador da primeira primitiva encontrada (s  alterado
+ *					se alguma bloqueia o raio).
+ *
+ *	@return No-zero se alguma primitiva bloqueia o raio e zero caso contrrio.
+ */
+int primAnySphere( PrimitiveStore store, int first, int count, Vector eye, Vector ray,
+					double minDistance, double maxDistance, int *id );
+int primAnyTriangle( PrimitiveStore store, int first, int count, Vector eye, Vector ray,
+					double minDistance, double maxDistance, int *id );
+int primAnyBox( PrimitiveStore store, int first, int count, Vector eye, Vector ray,
+					double minDistance, double maxDistance, int *id );
+
+/**
+ *	Destri um conjunto criado com primCreate(). Os objetos no so destrudos.
+ */
+void primDestroy( PrimitiveStore store );
+
+#endif
@@ -13,6 +13,8 @@
 #include "raytracing.h"
 #include "color.h"
 #include "algebra.h"
+#include "thread.h"
+#include "packet.h"
 
 
    /************************************************************************/
@@ -20,32 +22,310 @@
    /************************************************************************/
    #define MAX( a, b ) ( ( a > b ) ? a : b )
 
-   /** Nmero mximo de recurses permitidas */
+   /** Valor inicial de maxDepth */
    #define MAX_DEPTH	6
 
+   /** Valor inicial de minRayWeight: abaixo de meio tom em 8 bits por componente */
+   #define MIN_RAY_WEIGHT	( 0.5 / 255 )
+
+   /** Lado, em pixels, dos blocos em que a imagem  dividida por rayTraceScene() */
+   #define TILE_SIZE	16
+
+   /** Com sShadow, as luzes pontuais so tratadas como esferas deste raio... */
+   #define SOFT_SHADOW_RADIUS	7.5
+
+   /** ...amostradas com este nmero de pontos */
+   #define SOFT_SHADOW_SAMPLES	16
+
+   /** Amostras iniciais de uma luz de rea com sombra adaptativa (veja adaptiveShadows) */
+   #define SHADOW_FIRST_SAMPLES	4
+
+   /** Luzes com ltimo bloqueador guardado por thread; as demais no usam o cache */
+   #define SHADOW_CACHE_LIGHTS	16
+
+   /** Raios pendentes que cabem na pilha de raios sem alocao (veja RayStack) */
+   #define RAY_STACK_SIZE	32
+
+   /** Bits por eixo do cdigo de Morton da origem dos raios de uma onda (veja wavefront) */
+   #define MORTON_BITS	9
+
 
       int bump=0;
       int sShadow=0;
       int refr=0;
 
+      /* Raios secundrios (reflexo e refrao): profundidade mxima e peso mnimo na
+         cor do pixel. Com roleta russa, os raios abaixo do peso mnimo sobrevivem com
+         probabilidade peso/minRayWeight e tm a cor ampliada na mesma proporo, o que
+         mantm a mdia; sem ela, so descartados */
+      int maxDepth=MAX_DEPTH;
+      double minRayWeight=MIN_RAY_WEIGHT;
+      int russianRoulette=0;
+
+      /* Threads usadas por rayTraceScene(); zero usa uma por processador */
+      int renderThreads=0;
+
+      /* Raios primrios traados em pacotes de 2x2 pixels (veja packet.h) */
+      int packets=0;
+
+      /* Blocos traados em ondas: primeiro todos os raios primrios, depois os raios
+         secundrios gerados por eles, e assim por diante. Antes de cada onda, os raios
+         so ordenados pelo octante da direo e pela origem, para que raios vizinhos
+         percorram os mesmos ns da hierarquia. Com ondas no h pacotes */
+      int wavefront=0;
+
+      /* Amostras por luz de rea; zero usa as de cada luz (e SOFT_SHADOW_SAMPLES com sShadow) */
+      int lightSamples=0;
+
+      /* Luzes de rea testadas primeiro com SHADOW_FIRST_SAMPLES raios de sombra; as
+         demais amostras s so traadas se eles discordarem (penumbra) */
+      int adaptiveShadows=1;
+
+      /* Antialiasing de rayTraceScene() (veja rayTracePixel()); com antialiasing no h pacotes */
+      int antialias=AA_NONE;
+      double antialiasThreshold=AA_THRESHOLD;
+
+
+   /************************************************************************/
+   /* Tipos Privados                                                       */
+   /************************************************************************/
+   /**
+    *   Fila de blocos de uma thread: um intervalo [next, end) de ndices de blocos.
+    *   A dona consome pela frente; as demais roubam metade pelo final.
+    */
+   typedef struct
+   {
+      Mutex lock;
+      int next;
+      int end;
+   }
+   TileQueue;
+
+   /**
+    *   Estado compartilhado por todas as threads de uma renderizao.
+    */
+   typedef struct
+   {
+      Scene scene;
+      Camera camera;
+      Vector eye;
+      Image image;
+
+      int width;
+      int height;
+      int tilesX;
+      int tileCount;
+
+      int queueCount;
+      TileQueue *queues;
+
+      /* Progresso: blocos concludos e ltimo percentual reportado */
+      volatile long tilesDone;
+      int percentage;
+      Mutex progressLock;
+      void (*progress)( int percentage );
+   }
+   RenderJob;
+
+   /**
+    *   Parmetro de cada thread: a renderizao e o ndice da sua fila.
+    */
+   typedef struct
+   {
+      RenderJob *job;
+      int queue;
+   }
+   RenderWorker;
+
+   /**
+    *   Raio pendente: ainda no traado, com a sua contribuio para a cor de um pixel.
+    */
+   typedef struct
+   {
+      Vector origin;
+      Vector direction;
+
+      /* Profundidade (zero nos raios primrios) e peso usado por continueRay() */
+      int depth;
+      double weight;
+
+      /* Comprimento do caminho desde o observador at a origem do raio (zero nos
+         raios primrios), para o nvel de detalhe das texturas vistas em reflexos */
+      double travelled;
+
+      /* Fator aplicado  cor do raio antes de som-la ao pixel: o produto dos fatores
+         de reflexo e transparncia ao longo do caminho, compensado pela roleta russa */
+      double throughput;
+
+      /* ndice do pixel, no vetor de cores passado a traceRays() */
+      int pixel;
+   }
+   PendingRay;
+
+   /**
+    *   Pilha de raios pendentes de uma thread. Os primeiros RAY_STACK_SIZE raios ficam
+    *   no prprio objeto (declarado na pilha de quem traa); a partir da, no heap.
+    */
+   typedef struct
+   {
+      PendingRay *rays;
+      int count;
+      int capacity;
+      PendingRay local[RAY_STACK_SIZE];
+   }
+   RayStack;
+
+   /**
+    *   Chave de ordenao de um raio de uma onda: octante da direo e cdigo de Morton
+    *   da origem.
+    */
+   typedef struct
+   {
+      unsigned long key;
+      int index;
+   }
+   RayKey;
+
+
+   /************************************************************************/
+   /* Variveis Privadas                                                   */
+   /************************************************************************/
+   /* Raios de sombra da thread corrente */
+   static THREAD_LOCAL ShadowStats threadShadowStats;
+
+   /* Objeto que bloqueou o ltimo raio de sombra de cada luz na thread corrente
+      (ndice + 1; zero se o raio no foi bloqueado) */
+   static THREAD_LOCAL int threadLastBlocker[SHADOW_CACHE_LIGHTS];
+
+   /* Estado do gerador da roleta russa, reiniciado a cada bloco de rayTraceScene()
+      para que a imagem no dependa da diviso dos blocos entre as threads */
+   static THREAD_LOCAL unsigned long threadRandom = 1;
+
+   /* Totais da ltima chamada de rayTraceScene() */
+   static ShadowStats shadowStats;
+
 
    /************************************************************************/
    /* Funes Privadas                                                     */
    /************************************************************************/
    /**
-    *	Obtm uma cor atravs do traado de um raio dentro de uma cena.
+    *	Obtm a cor de um ponto atingido por um raio, iluminado diretamente pelas luzes
+    *	da cena. Os raios refletido e refratado no so traados aqui: so empilhados,
+    *	e a sua cor  somada ao pixel por traceRays().
     *
     *	@param scene Handle para a cena sendo renderizada.
     *	@param eye Posio do observador, origem do raio.
     *	@param ray Direo do raio.
-    *	@param depth Para controle do nmero mximo de recurses. Funes clientes devem
-    *					passar 0 (zero). A cada recurso depth  incrementado at, no mximo,
-    *					MAX_DEPTH. Quando MAX_DEPTH  atingido, recurses so ignoradas.
+    *	@param textureCoordinate Coordenada de textura do objeto no ponto atingido.
+    *	@param path Raio atingido (profundidade, peso e pixel dos raios secundrios).
+    *					Um raio de profundidade maxDepth no gera raios secundrios.
+    *	@param stack Pilha que recebe os raios secundrios.
     *
-    *	@return Cor resultante do traado do raio.
+    *	@return Cor do ponto, sem a contribuio dos raios secundrios.
     */
    static Color shade( Scene scene, Vector eye, Vector ray, Object object, Vector point,
-					   Vector normal, int depth );
+					   Vector normal, Vector textureCoordinate, const PendingRay *path,
+					   RayStack *stack );
+
+   /**
+    *	Traa todos os raios de uma pilha, incluindo os raios secundrios gerados por
+    *	eles, e soma a contribuio de cada um  cor do seu pixel.
+    *
+    *	@param pixels [in/out]Cores dos pixels, indexadas por PendingRay::pixel.
+    */
+   static void traceRays( Scene scene, RayStack *stack, Color *pixels );
+
+   /**
+    *	Traa um raio pendente, empilha os raios secundrios gerados por ele e soma a
+    *	sua contribuio  cor do seu pixel (veja traceRays()).
+    */
+   static void traceRay( Scene scene, const PendingRay *path, RayStack *stack, Color *pixels );
+
+   /**
+    *	Prepara uma pilha de raios vazia.
+    */
+   static void rayStackInit( RayStack *stack );
+
+   /**
+    *	Libera a memria alocada por uma pilha de raios.
+    */
+   static void rayStackDestroy( RayStack *stack );
+
+   /**
+    *	Empilha um raio pendente. Se no houver memria para aumentar a pilha, o raio
+    *	 descartado.
+    */
+   static void rayStackPush( RayStack *stack, Vector origin, Vector direction, int depth,
+							 double travelled, double weight, double throughput, int pixel );
+
+   /**
+    *	Decide se um raio secundrio  traado, pelo peso que ele teria na cor do pixel
+    *	(veja minRayWeight e russianRoulette).
+    *
+    *	@param depth Profundidade do raio secundrio.
+    *	@param weight [in/out]Peso do raio. Se ele sobrevive  roleta russa, passa a
+    *					valer minRayWeight.
+    *	@param scale [out]Fator pelo qual a cor do raio deve ser multiplicada para
+    *					compensar os raios descartados pela roleta (1 sem roleta).
+    *
+    *	@return No-zero se o raio deve ser traado.
+    */
+   static int continueRay( int depth, double *weight, double *scale );
+
+   /**
+    *	Sorteia um nmero entre 0 (inclusive) e 1 (exclusive) com o gerador da thread.
+    */
+   static double nextRandom( void );
+
+   /**
+    *	ndice, entre as count amostras de uma luz de rea, da amostra inicial probe
+    *	da sombra adaptativa. Cada amostra inicial fica em uma faixa diferente do
+    *	conjunto de Hammersley (veja lightSample()), deslocada em diagonal para que
+    *	tambm caiam em faixas diferentes da outra direo. Os ndices so crescentes.
+    */
+   static int shadowProbe( int probe, int count );
+
+   /**
+    *	Acumula uma amostra de rayTracePixel(), sem limitar as componentes: a mdia
+    *	vai para o buffer linear da imagem, e a saturao fica com o mapeamento de tons.
+    */
+   static void addSample( double sum[3], Color color );
+
+   /**
+    *	Limita as componentes de uma cor a [0,1], como sero exibidas com o mapeamento
+    *	padro. Usada apenas no teste de contraste da amostragem adaptativa, para que
+    *	duas amostras igualmente saturadas no sejam consideradas diferentes.
+    */
+   static Color clampSample( Color color );
+
+   /**
+    *	Estima a largura, em unidades de coordenada de textura, da regio da superfcie
+    *	vista por um raio (para a escolha do nvel de detalhe da textura). A largura
+    *	cresce com a distncia percorrida, na proporo do ngulo entre pixels, e com
+    *	a inclinao da superfcie em relao ao raio.
+    *
+    *	@param travelled Comprimento do caminho desde o observador, somando os segmentos
+    *					 anteriores: refletores planos no mudam o ngulo do feixe.
+    *
+    *	@return Largura estimada (zero se o material no tem textura).
+    */
+   static double textureFootprint( Scene scene, Material material, Object object, double travelled,
+								   Vector ray, Vector point, Vector normal );
+
+   /**
+    *	Obtm a cor de um raio cuja interseo mais prxima j foi calculada (veja
+    *	shade()).
+    *
+    *	@param path Raio traado.
+    *	@param object Objeto atingido.
+    *	@param distance Distncia at o objeto (DBL_MAX se nada foi atingido).
+    *	@param u Peso de v1 no ponto atingido, se o objeto for um tringulo.
+    *	@param v Peso de v2 no ponto atingido, se o objeto for um tringulo.
+    *
+    *	@return Cor resultante do traado do raio.
+    */
+   static Color traceHit( Scene scene, const PendingRay *path, Object object, double distance,
+						  double u, double v, RayStack *stack );
 
    /**
     *	Encontra o primeiro objeto interceptado pelo raio originado na posio especificada.
@@ -54,22 +334,90 @@
     *	@param eye Posio do Observador (origem).
     *	@param ray Raio sendo traado (direo).
     *	@param object Onde  retornado o objeto resultante. No pode ser NULL.
+    *	@param u Onde  retornado o peso de v1 no ponto atingido, se o objeto for um tringulo.
+    *	@param v Onde  retornado o peso de v2 no ponto atingido, se o objeto for um tringulo.
     *	@return Distncia entre 'eye' e a superfcie do objeto interceptado pelo raio.
     *			DBL_MAX se nenhum objeto  interceptado pelo raio, neste caso
     *				'object' no  modificado.
     */
-   static double getNearestObject( Scene scene, Vector eye, Vector ray, Object *object );
+   static double getNearestObject( Scene scene, Vector eye, Vector ray, Object *object,
+								   double *u, double *v );
 
    /**
-    *	Checa se objetos em uma cena impedem a luz de alcanar um ponto.
+    *	Checa se objetos em uma cena impedem a luz de alcanar um ponto. O objeto que
+    *	bloqueou a mesma luz por ltimo nesta thread  testado antes da hierarquia.
     *
     *	@param scene Cena.
+    *	@param light ndice da luz na cena.
     *	@param point Ponto sendo testado.
     *	@param rayToLight Um raio (direo) indo de 'point' at 'lightLocation'.
     *	@param lightLocation Localizao da fonte de luz.
     *	@return Zero se nenhum objeto bloqueia a luz e no-zero caso contrrio.
     */
-   static int isInShadow( Scene scene, Vector point, Vector rayToLight, Vector lightLocation );
+   static int isInShadow( Scene scene, int light, Vector point, Vector rayToLight, Vector lightLocation );
+
+   /**
+    *	Corpo das threads de rayTraceScene(): renderiza os blocos da prpria fila e,
+    *	quando ela se esgota, rouba blocos das demais at no restar nenhum.
+    *
+    *	@param data RenderWorker da thread.
+    */
+   static void renderWorker( void *data );
+
+   /**
+    *	Retira o prximo bloco de uma fila.
+    *
+    *	@return ndice do bloco ou -1 se a fila est vazia.
+    */
+   static int popTile( TileQueue *queue );
+
+   /**
+    *	Transfere para a fila 'thief' a metade final da primeira fila no vazia encontrada.
+    *
+    *	@return No-zero se algum bloco foi roubado e zero se todas as filas esto vazias.
+    */
+   static int stealTiles( RenderJob *job, int thief );
+
+   /**
+    *	Traa os raios primrios de um bloco e escreve os pixels na imagem. Blocos
+    *	diferentes no compartilham pixels, por isso a escrita dispensa sincronizao.
+    */
+   static void renderTile( RenderJob *job, int tile );
+
+   /**
+    *	Traa os pixels [x0, x1) x [y0, y1), com antialiasing, ondas, pacotes ou raio a
+    *	raio, conforme as variveis globais. A regio no pode ser maior que um bloco.
+    */
+   static void renderRegion( RenderJob *job, int x0, int y0, int x1, int y1 );
+
+   /**
+    *	Traa os pixels [x, x + 1] x [y, y + 1] como um pacote, limitados a xEnd e yEnd.
+    *	Os raios que sobram nas bordas repetem pixels do pacote e so descartados.
+    */
+   static void renderPacket( RenderJob *job, int x, int y, int xEnd, int yEnd );
+
+   /**
+    *	Traa os pixels [x0, x1) x [y0, y1) de um bloco em ondas (veja wavefront).
+    */
+   static void renderWavefront( RenderJob *job, int x0, int y0, int x1, int y1 );
+
+   /**
+    *	Move os raios de 'source' para 'target', ordenados pelo octante da direo e,
+    *	dentro de cada octante, pelo cdigo de Morton da origem. Se no houver memria
+    *	para as chaves, os raios so movidos na ordem original.
+    */
+   static void sortRays( RayStack *source, RayStack *target );
+
+   /**
+    *	Compara duas RayKey (para qsort()).
+    */
+   static int compareRayKeys( const void *a, const void *b );
+
+   /**
+    *	Intercala zeros entre os MORTON_BITS bits menos significativos de um valor
+    *	(bit i vai para a posio 3i), para compor cdigos de Morton.
+    */
+   static unsigned long spreadBits( unsigned long value );
 
 
    /************************************************************************/
@@ -78,15 +426,238 @@
 
    Color rayTrace( Scene scene, Vector eye, Vector ray, int depth )
    {
-	   Object object;
+	   RayStack stack;
+	   Color color = { 0, 0, 0 };
+
+	   rayStackInit( &stack );
+	   rayStackPush( &stack, eye, ray, depth, 0.0, 1.0, 1.0, 0 );
+	   traceRays( scene, &stack, &color );
+	   rayStackDestroy( &stack );
+
+	   return color;
+   }
+
+   Color rayTracePixel( Scene scene, int x, int y, AntialiasMode mode, double threshold, int *samples )
+   {
+      /* Coluna da amostra inicial de cada linha da grade: uma por linha e por coluna */
+      static const int firstColumn[AA_GRID] = { 1, 3, 0, 2 };
+
+      Camera camera = sceGetCamera( scene );
+      Vector eye = camGetEye( camera );
+      Color color, minimum, maximum;
+      double sum[3] = { 0, 0, 0 };
+      int count = 0;
+      int row, column;
+
+      if( mode == AA_NONE )
+      {
+         if( samples )
+            *samples = 1;
+         return rayTrace( scene, eye, camGetRay( camera, x, y ), 0 );
+      }
+
+      for( row = 0; row < AA_GRID; ++row )
+      {
+         color = rayTrace( scene, eye, camGetRay( camera, x + ( firstColumn[row] + 0.5 ) / AA_GRID,
+                                                                y + ( row + 0.5 ) / AA_GRID ), 0 );
+         addSample( sum, color );
+
+         color = clampSample( color );
+         if( row == 0 )
+            minimum = maximum = color;
+
+         minimum.red   = ( color.red   < minimum.red   ) ? color.red   : minimum.red;
+         minimum.green = ( color.green < minimum.green ) ? color.green : minimum.green;
+         minimum.blue  = ( color.blue  < minimum.blue  ) ? color.blue  : minimum.blue;
+         maximum.red   = ( color.red   > maximum.red   ) ? color.red   : maximum.red;
+         maximum.green = ( color.green > maximum.green ) ? color.green : maximum.green;
+         maximum.blue  = ( color.blue  > maximum.blue  ) ? color.blue  : maximum.blue;
+
+         ++count;
+      }
+
+      /* S completa a grade onde as amostras iniciais discordam (bordas, sombras, texturas) */
+      if( mode == AA_FULL || maximum.red - minimum.red > threshold ||
+          maximum.green - minimum.green > threshold || maximum.blue - minimum.blue > threshold )
+      {
+         for( row = 0; row < AA_GRID; ++row )
+         {
+            for( column = 0; column < AA_GRID; ++column )
+            {
+               if( column == firstColumn[row] )
+                  continue;
+
+               addSample( sum, rayTrace( scene, eye, camGetRay( camera, x + ( column + 0.5 ) / AA_GRID,
+                                                                    y + ( row + 0.5 ) / AA_GRID ), 0 ) );
+               ++count;
+            }
+         }
+      }
+
+      if( samples )
+         *samples = count;
+
+      color.red = (VectorReal)( sum[0] / count );
+      color.green = (VectorReal)( sum[1] / count );
+      color.blue = (VectorReal)( sum[2] / count );
+
+      return color;
+   }
+
+   Image rayTraceScene( Scene scene, void (*progress)( int percentage ) )
+   {
+      RenderJob job;
+      RenderWorker *workers;
+      Thread *threads;
+      int threadCount;
+      int tilesY;
+      int i;
+
+      job.scene = scene;
+      job.camera = sceGetCamera( scene );
+      job.eye = camGetEye( job.camera );
+      job.width = camGetScreenWidth( job.camera );
+      job.height = camGetScreenHeight( job.camera );
+      job.tilesX = ( job.width + TILE_SIZE - 1 ) / TILE_SIZE;
+      tilesY = ( job.height + TILE_SIZE - 1 ) / TILE_SIZE;
+      job.tileCount = job.tilesX * tilesY;
+      job.tilesDone = 0;
+      job.percentage = 0;
+      job.progress = progress;
+      memset( &shadowStats, 0, sizeof(shadowStats) );
+
+      job.image = imageCreate( job.width, job.height );
+      if( !job.image )
+         return NULL;
+
+      threadCount = ( renderThreads > 0 ) ? renderThreads : thrGetProcessorCount();
+      if( threadCount > job.tileCount )
+         threadCount = job.tileCount;
+      if( threadCount < 1 )
+         threadCount = 1;
+
+      job.queueCount = threadCount;
+      job.queues = (TileQueue *)malloc( threadCount * sizeof(TileQueue) );
+      workers = (RenderWorker *)malloc( threadCount * sizeof(RenderWorker) );
+      threads = (Thread *)malloc( threadCount * sizeof(Thread) );
+      job.progressLock = thrCreateMutex();
+      if( !job.queues || !workers || !threads || !job.progressLock )
+      {
+         free( job.queues );
+         free( workers );
+         free( threads );
+         if( job.progressLock )
+            thrDestroyMutex( job.progressLock );
+         imageDestroy( job.image );
+         return NULL;
+      }
+
+      /* Cada fila comea com uma faixa contgua de blocos, para manter a coerncia */
+      for( i = 0; i < threadCount; ++i )
+      {
+         job.queues[i].lock = thrCreateMutex();
+         job.queues[i].next = (int)( (long)job.tileCount * i / threadCount );
+         job.queues[i].end = (int)( (long)job.tileCount * ( i + 1 ) / threadCount );
+         workers[i].job = &job;
+         workers[i].queue = i;
+      }
+
+      /* A thread corrente  a de ndice zero. Se alguma thread no puder ser criada,
+         sua fila  esvaziada pelas demais atravs do roubo de blocos. */
+      for( i = 1; i < threadCount; ++i )
+         threads[i] = thrCreate( renderWorker, &workers[i] );
+
+      renderWorker( &workers[0] );
+
+      for( i = 1; i < threadCount; ++i )
+      {
+         if( threads[i] )
+            thrJoin( threads[i] );
+      }
+
+      for( i = 0; i < threadCount; ++i )
+         thrDestroyMutex( job.queues[i].lock );
+
+      thrDestroyMutex( job.progressLock );
+      free( job.queues );
+      free( workers );
+      free( threads );
+
+      return job.image;
+   }
+
+   void rayTraceRegion( Scene scene, Image image, int x0, int y0, int x1, int y1 )
+   {
+      RenderJob job;
+      int x, y;
+
+      memset( &job, 0, sizeof(job) );
+      job.scene = scene;
+      job.camera = sceGetCamera( scene );
+      job.eye = camGetEye( job.camera );
+      job.image = image;
+      imageGetDimensions( image, &job.width, &job.height );
+
+      /* Como em renderTile(), o sorteio depende s da regio */
+      threadRandom = ( (unsigned long)( y0 * job.width + x0 ) * 2654435761UL + 1 ) & 0xffffffffUL;
+      if( threadRandom == 0 )
+         threadRandom = 1;
+
+      /* Em pedaos do tamanho de um bloco, o limite de renderRegion() */
+      for( y = y0; y < y1; y += TILE_SIZE )
+      {
+         for( x = x0; x < x1; x += TILE_SIZE )
+            renderRegion( &job, x, y, ( x + TILE_SIZE < x1 ) ? x + TILE_SIZE : x1,
+                                      ( y + TILE_SIZE < y1 ) ? y + TILE_SIZE : y1 );
+      }
+   }
+
+   void rayTraceGetShadowStats( ShadowStats *stats )
+   {
+      *stats = shadowStats;
+   }
+
+   /************************************************************************/
+   /* Definio das Funes Privadas                                       */
+   /************************************************************************/
+
+   static void traceRays( Scene scene, RayStack *stack, Color *pixels )
+   {
+	   PendingRay path;
+
+	   while( stack->count > 0 )
+	   {
+		   /* Cpia: o raio pode gerar outros, que ocupam a sua posio na pilha */
+		   path = stack->rays[--stack->count];
+		   traceRay( scene, &path, stack, pixels );
+	   }
+   }
+
+   static void traceRay( Scene scene, const PendingRay *path, RayStack *stack, Color *pixels )
+   {
+	   Object object = NULL;
 	   double distance;
+	   double u, v;
+	   Color color;
+
+	   /* Calcula o primeiro objeto a ser atingido pelo raio */
+	   distance = getNearestObject( scene, path->origin, path->direction, &object, &u, &v );
+
+	   color = traceHit( scene, path, object, distance, u, v, stack );
+
+	   pixels[path->pixel].red   += color.red   * path->throughput;
+	   pixels[path->pixel].green += color.green * path->throughput;
+	   pixels[path->pixel].blue  += color.blue  * path->throughput;
+   }
 
+   static Color traceHit( Scene scene, const PendingRay *path, Object object, double distance,
+						  double u, double v, RayStack *stack )
+   {
+	   Vector eye = path->origin;
+	   Vector ray = path->direction;
 	   Vector point;
 	   Vector normal;
 
-	   /* Calcula o primeiro objeto a ser atingido pelo raio */
-	   distance = getNearestObject( scene, eye, ray, &object );
-
 	   /* Se o raio no interceptou nenhum objeto... */
 	   if( distance == DBL_MAX )
 	   {
@@ -99,15 +670,86 @@
 	   /* Obtm o vetor normal ao objeto no ponto de interseo */
 	   normal =  objNormalAt( object, point );
 
-	   return shade( scene, eye, ray, object, point, normal, depth );
+	   /* Tringulos reaproveitam as coordenadas baricntricas da interseo */
+	   return shade( scene, eye, ray, object, point, normal,
+					 objTextureCoordinateAtBarycentric( object, point, u, v ), path, stack );
    }
 
-   /************************************************************************/
-   /* Definio das Funes Privadas                                       */
-   /************************************************************************/
+   static void rayStackInit( RayStack *stack )
+   {
+      stack->rays = stack->local;
+      stack->count = 0;
+      stack->capacity = RAY_STACK_SIZE;
+   }
+
+   static void rayStackDestroy( RayStack *stack )
+   {
+      if( stack->rays != stack->local )
+         free( stack->rays );
+   }
+
+   static void rayStackPush( RayStack *stack, Vector origin, Vector direction, int depth,
+							 double travelled, double weight, double throughput, int pixel )
+   {
+      PendingRay *ray;
+
+      if( stack->count == stack->capacity )
+      {
+         PendingRay *rays = (PendingRay *)malloc( 2 * stack->capacity * sizeof(PendingRay) );
+         if( rays == NULL )
+            return;
+
+         memcpy( rays, stack->rays, stack->count * sizeof(PendingRay) );
+         rayStackDestroy( stack );
+         stack->rays = rays;
+         stack->capacity *= 2;
+      }
+
+      ray = &stack->rays[stack->count++];
+      ray->origin = origin;
+      ray->direction = direction;
+      ray->depth = depth;
+      ray->travelled = travelled;
+      ray->weight = weight;
+      ray->throughput = throughput;
+      ray->pixel = pixel;
+   }
+
+   static void addSample( double sum[3], Color color )
+   {
+      sum[0] += color.red;
+      sum[1] += color.green;
+      sum[2] += color.blue;
+   }
+
+   static Color clampSample( Color color )
+   {
+      color.red   = ( color.red   < 0 ) ? 0 : ( color.red   > 1 ) ? 1 : color.red;
+      color.green = ( color.green < 0 ) ? 0 : ( color.green > 1 ) ? 1 : color.green;
+      color.blue  = ( color.blue  < 0 ) ? 0 : ( color.blue  > 1 ) ? 1 : color.blue;
+      return color;
+   }
+
+   static double textureFootprint( Scene scene, Material material, Object object, double travelled,
+								   Vector ray, Vector point, Vector normal )
+   {
+	   double cosine;
+
+	   if( material->texture == NULL || sceGetCamera( scene ) == NULL )
+		   return 0;
+
+	   /* Superfcies quase paralelas ao raio so limitadas ao nvel mais grosso da textura */
+	   cosine = fabs( algDot( algUnit( ray ), algUnit( normal ) ) );
+	   if( cosine < 1.0e-3 )
+		   cosine = 1.0e-3;
+
+	   return travelled * camGetPixelAngle( sceGetCamera( scene ) ) / cosine *
+			  objGetTextureScale( object, point );
+   }
 
    static Color shade( Scene scene, Vector eye, Vector ray, Object object, Vector point,
-					   Vector normal, int depth )
+					   Vector normal, Vector textureCoordinate, const PendingRay *path,
+					   RayStack *stack )
    {
       int i;
       double prod,cos_alfa,cos_beta;
@@ -125,14 +767,33 @@
       
       int j;
       int fontes_aux = 8;
-      double L_raio;
       double shadow_factor, light_factor;
-      Vector L_aux[7];
-
-      /*SShadow*/
-      int lamps = 1;
-      double lamppower = 1.0;
+      int blocked;
+
+      /* Amostras de cada luz (uma nas luzes pontuais) */
+      int lamps;
+      double lamppower;
+      int bumped;
+      int firstIndex[SHADOW_FIRST_SAMPLES];
+      int firstBlocked[SHADOW_FIRST_SAMPLES];
+      int probes;
+      int next;
+      int agreed;
+      int k;
+
+      /* Deslocamento das amostras das luzes de rea, o mesmo para todas as luzes */
+      unsigned long seed = lightGetSeed( point );
+
+      /* Comprimento do caminho desde o observador at o ponto */
+      double travelled = path->travelled + algNorm( algSub( point, eye ) );
+
+      /* Peso na cor do pixel dos raios refletido e refratado */
+      double childWeight;
+      double childScale;
       Vector Lpos;
+      Light light;
+      struct _Light softLight;
+      Color lightColor;
  
 
 
@@ -141,7 +802,8 @@
       /* Pegando parametros */
 
 	   Color ambient  = sceGetAmbientLight( scene );
-	   Color diffuse  = matGetDiffuse( material, objTextureCoordinateAt( object, point ) );	
+	   Color diffuse  = matGetDiffuse( material, textureCoordinate,
+									   textureFootprint( scene, material, object, travelled, ray, point, normal ) );
 	   Color specular = matGetSpecular( material );
 	  
 
@@ -157,48 +819,70 @@
 
       for( i=0 ; i < sceGetLightCount( scene ); i++ )
       {
-         Lpos  = lightGetPosition(sceGetLight(scene, i ));
-         L     = algSub (Lpos, point) ;
-         Lnorm = algUnit(L);
-         Nnorm = algUnit(N);
+         light = sceGetLight( scene, i );
 
-         prod  = algDot (Lnorm, Nnorm);
+      /* Soft Shadow: a luz pontual vira uma pequena esfera */
 
+         if( sShadow == 1 && lightGetType( light ) == LIGHT_POINT )
+         {
+            softLight = *light;
+            softLight.type    = LIGHT_SPHERE;
+            softLight.radius  = SOFT_SHADOW_RADIUS;
+            softLight.samples = SOFT_SHADOW_SAMPLES;
+            light = &softLight;
+         }
 
-      /* Soft Shadow */
+         lamps = lightGetSamples( light );
+         if( lightSamples > 0 && lightGetType( light ) != LIGHT_POINT )
+            lamps = lightSamples;
 
-         if(sShadow == 1)
-         {
+      /* Sombra adaptativa: algumas das amostras da luz so testadas primeiro. Se
+         concordam, o ponto est todo iluminado ou todo na sombra e as demais
+         amostras usam o mesmo resultado; seno, est na penumbra e s as demais
+         so testadas. A iluminao usa sempre todas as amostras */
 
-            L_raio = 7.5;
-            L_aux[0] = L;
+         probes = 0;
+         agreed = 0;
+         if( adaptiveShadows && lamps > SHADOW_FIRST_SAMPLES )
+         {
+            int lit = 0;
 
-            /* Colocando fontes auxiliares no centro da esfera*/
-            for(j=0;j<7;j++)
+            Nnorm = algUnit(N);
+            for(k=0;k<SHADOW_FIRST_SAMPLES;k++)
             {
-               L_aux[j] = L;
-            }
+               firstIndex[k] = shadowProbe( k, lamps );
+               Lpos  = lightSampleSeeded( light, point, seed, firstIndex[k], lamps );
+               Lnorm = algUnit( algSub( Lpos, point ) );
 
-            L_aux[1].x = L.x + L_raio;
-            L_aux[2].x = L.x - L_raio;
-            L_aux[3].y = L.y + L_raio;
-            L_aux[4].y = L.y - L_raio;
-            L_aux[5].z = L.z + L_raio;
-            L_aux[6].z = L.z - L_raio;
+               /* Amostras atrs da superfcie no iluminam: contam como sombra */
+               firstBlocked[k] = ( algDot( Lnorm, Nnorm ) <= 0 ) || isInShadow( scene, i, point, Lnorm, Lpos );
+               lit += !firstBlocked[k];
+            }
 
-            lamps=7;
-            lamppower=0.25;
-    
+            probes = SHADOW_FIRST_SAMPLES;
+            agreed = ( lit == 0 || lit == SHADOW_FIRST_SAMPLES );
+            if( agreed )
+               threadShadowStats.saved += lamps - SHADOW_FIRST_SAMPLES;
          }
 
-         /* Lampadas dividas pelo Soft Shadow*/
+         /* Cada amostra leva uma frao igual da luz */
+         lamppower  = 1.0 / lamps;
+         lightColor = lightGetColor( light );
+         bumped     = 0;
+         next       = 0;
+
+         /* Amostras estratificadas sobre a luz */
          for(j=0;j<lamps;j++) 
          {
-            if(sShadow == 1)
-            {
-               Lnorm = algUnit(L_aux[j]);
-               Lpos = L_aux[j];
-            }
+            /* Amostra inicial da sombra adaptativa: o teste j foi feito */
+            k = ( next < probes && j == firstIndex[next] ) ? next++ : -1;
+
+            Lpos  = lightSampleSeeded( light, point, seed, j, lamps );
+            L     = algSub (Lpos, point) ;
+            Lnorm = algUnit(L);
+            Nnorm = algUnit(N);
+
+            prod  = algDot (Lnorm, Nnorm);
 
 
        /* Se o objeto estiver numa regiao obscura */
@@ -216,7 +900,15 @@
           illumination value = shadowfactor * normal illumination 
 
       */
-      if (isInShadow (scene, point, Lnorm, Lpos))
+      /* Uma unica consulta de oclusao, reaproveitada pelos dois casos abaixo */
+      if( k >= 0 )
+         blocked = firstBlocked[k];
+      else if( agreed )
+         blocked = firstBlocked[0];
+      else
+         blocked = isInShadow (scene, i, point, Lnorm, Lpos);
+
+      if (blocked)
       {
          if(opacityFactor < 1.0)
          {
@@ -224,11 +916,9 @@
             shadow_factor = pow(2.55, opacityFactor);
             light_factor  = (2.55/fontes_aux);
 
-            cos_alfa = prod / algNorm(Lnorm) * algNorm(N);
-
-				color.red   += scene->lights[i]->color.red   * diffuse.red    - opacityFactor * (light_factor * shadow_factor) ;
-				color.green += scene->lights[i]->color.green * diffuse.green  - opacityFactor * (light_factor * shadow_factor) ;
-				color.blue  += scene->lights[i]->color.blue  * diffuse.blue   - opacityFactor * (light_factor * shadow_factor) ;
+				color.red   += lamppower * ( lightColor.red   * diffuse.red    - opacityFactor * (light_factor * shadow_factor) );
+				color.green += lamppower * ( lightColor.green * diffuse.green  - opacityFactor * (light_factor * shadow_factor) );
+				color.blue  += lamppower * ( lightColor.blue  * diffuse.blue   - opacityFactor * (light_factor * shadow_factor) );
          }
          
 
@@ -236,19 +926,15 @@
 
             /* Se a luz nao for bloqueada no ponto */
 
-            if (! (isInShadow (scene, point, Lnorm, Lpos)))
+            if (! blocked)
             {
   
-               if (j==0)
-                  light_factor = lamppower;
-               
-               else
-                  light_factor = (1.0/fontes_aux);
+               light_factor = lamppower;
 
 
           /* Bump Mapping */
                
-               if(bump == 1)
+               if(bump == 1 && !bumped)
                {
                
                   /*confere se h textura*/
@@ -281,6 +967,9 @@
                      Nnorm = algUnit(N) ;
                      prod = algDot (Lnorm, Nnorm) ;
                   }
+
+                  /* A normal perturbada vale para as demais amostras desta luz */
+                  bumped = 1;
                }
    
 
@@ -290,9 +979,9 @@
                cos_alfa = prod / algNorm(Lnorm) * algNorm(Nnorm);
 
 
-				   color.red   += scene->lights[i]->color.red   * diffuse.red   * cos_alfa * light_factor ;
-				   color.green += scene->lights[i]->color.green * diffuse.green * cos_alfa * light_factor;
-				   color.blue  += scene->lights[i]->color.blue  * diffuse.blue  * cos_alfa * light_factor;
+				   color.red   += lightColor.red   * diffuse.red   * cos_alfa * light_factor ;
+				   color.green += lightColor.green * diffuse.green * cos_alfa * light_factor;
+				   color.blue  += lightColor.blue  * diffuse.blue  * cos_alfa * light_factor;
             
 				 
                /* Componente Especular */
@@ -302,9 +991,9 @@
 			      prod     = algDot (V, Rnorm);
 			      cos_beta = prod / algNorm(V) * algNorm(Rnorm);
 			   
-				   color.red   += scene->lights[i]->color.red   * specular.red   * (pow(cos_beta,specularExponent)) * light_factor ;
-				   color.green += scene->lights[i]->color.green * specular.green * (pow(cos_beta,specularExponent)) * light_factor ;
-				   color.blue  += scene->lights[i]->color.blue  * specular.blue  * (pow(cos_beta,specularExponent)) * light_factor ;
+				   color.red   += lightColor.red   * specular.red   * (pow(cos_beta,specularExponent)) * light_factor ;
+				   color.green += lightColor.green * specular.green * (pow(cos_beta,specularExponent)) * light_factor ;
+				   color.blue  += lightColor.blue  * specular.blue  * (pow(cos_beta,specularExponent)) * light_factor ;
          
             }
 
@@ -318,20 +1007,17 @@
 
      /* Reflexo */
 
-	  if (reflectionFactor > 0 && depth < MAX_DEPTH)
+	  childWeight = path->weight * reflectionFactor;
+	  if (reflectionFactor > 0 && continueRay(path->depth + 1, &childWeight, &childScale))
 	  {
 		  Vector ReflectedRay;
-		  Color ReflectedColor ;
 		  
 		  ReflectedRay = algReflect(V, N);
 		  
 		  
 		  /* Lana um raio a partir do ponto sendo analisado com direo refletida em torno da normal) */
-		  ReflectedColor = rayTrace (scene, point, ReflectedRay, depth + 1) ;
-		  
-		  color.red   += ReflectedColor.red   * reflectionFactor ;
-		  color.blue  += ReflectedColor.blue  * reflectionFactor ;
-		  color.green += ReflectedColor.green * reflectionFactor ;
+		  rayStackPush (stack, point, ReflectedRay, path->depth + 1, travelled, childWeight,
+						path->throughput * reflectionFactor * childScale, path->pixel) ;
 	  }
 
 
@@ -341,13 +1027,13 @@
 if (refr==1)
 {
 
-     if(opacityFactor < 1 && depth < MAX_DEPTH)
+     childWeight = path->weight * (1 - opacityFactor);
+     if(opacityFactor < 1 && continueRay(path->depth + 1, &childWeight, &childScale))
      {
 //        Vector Vt;
         Vector RefractedRay;
         //Vector t;
         Vector v,n,v_linha,n_linha;
-        Color RefractedColor ;
         //double sin_teta1, sin_teta2, cos_teta1, cos_teta2, cos_teta1temp;
         
         //3
@@ -427,12 +1113,9 @@ if (refr==1)
      
 
         /* Lana um raio */
-		  RefractedColor = rayTrace (scene, point, RefractedRay, depth+1);
+		  rayStackPush (stack, point, RefractedRay, path->depth + 1, travelled, childWeight,
+						path->throughput * (1 - opacityFactor) * childScale, path->pixel);
         //opacityFactor = 0;
-		  
-        color.red   += RefractedColor.red   * (1 - opacityFactor) ;
-		  color.blue  += RefractedColor.blue  * (1 - opacityFactor) ;
-		  color.green += RefractedColor.green * (1 - opacityFactor) ;
      }
 }
 
@@ -441,52 +1124,443 @@ if (refr==1)
 
 
 
-   static double getNearestObject( Scene scene, Vector eye, Vector ray, Object *object )
+   static double getNearestObject( Scene scene, Vector eye, Vector ray, Object *object,
+								   double *u, double *v )
+   {
+	   /* Percorre a hierarquia de volumes envolventes da cena */
+	   return bvhGetNearestObject( sceGetBvh( scene ), eye, ray, object, u, v );
+   }
+
+
+   /* Sombra Comum */
+
+   static int isInShadow( Scene scene, int light, Vector point, Vector rayToLight, Vector lightLocation )
    {
-	   int i;
-	   int objectCount = sceGetObjectCount( scene );
+	   /* maxDistance = distncia de point at lightLocation */
+	   double maxDistance = algNorm( algSub( lightLocation, point ) );
+	   int blocker;
 
-	   double closest = DBL_MAX;
+	   ++threadShadowStats.traced;
 
-	   /* Para cada objeto na cena */
-	   for( i = 0; i < objectCount; ++i )
+	   /* Pontos vizinhos costumam ter o mesmo bloqueador: um nico teste o confirma.
+	      O ndice  conferido, pois pode ter sido guardado em outra cena */
+	   if( light < SHADOW_CACHE_LIGHTS )
 	   {
-		   Object currentObject = sceGetObject( scene, i );
-		   double distance = objIntercept( currentObject, eye, ray );
-		   
-		   if( distance > 0.0 && distance < closest )
+		   Object object = sceGetObject( scene, threadLastBlocker[light] - 1 );
+
+		   if( object )
 		   {
-			   closest = distance;
-			   *object = currentObject;
+			   double distance = objIntercept( object, point, rayToLight );
+
+			   if( distance > 0.1 && distance < maxDistance )
+			   {
+				   ++threadShadowStats.blocked;
+				   ++threadShadowStats.cacheHits;
+				   return 1;
+			   }
 		   }
 	   }
 
-	   return closest;
+	   /* Qualquer objeto entre point e a luz basta: a busca para no primeiro encontrado.
+	      Um ponto iluminado esvazia o cache, para que os vizinhos tambm iluminados
+	      no paguem o teste extra */
+	   if( !bvhIsOccluded( sceGetBvh( scene ), point, rayToLight, 0.1, maxDistance, &blocker ) )
+		   blocker = -1;
+
+	   if( light < SHADOW_CACHE_LIGHTS )
+		   threadLastBlocker[light] = blocker + 1;
+
+	   if( blocker < 0 )
+		   return 0;
+
+	   ++threadShadowStats.blocked;
+	   return 1;
    }
 
+   static int continueRay( int depth, double *weight, double *scale )
+   {
+      double probability;
 
-   /* Sombra Comum */
+      *scale = 1.0;
 
-   static int isInShadow( Scene scene, Vector point, Vector rayToLight, Vector lightLocation )
+      if( depth > maxDepth || *weight <= 0 )
+         return 0;
+
+      if( *weight >= minRayWeight )
+         return 1;
+
+      if( !russianRoulette )
+         return 0;
+
+      probability = *weight / minRayWeight;
+      if( nextRandom() >= probability )
+         return 0;
+
+      *scale = 1.0 / probability;
+      *weight = minRayWeight;
+      return 1;
+   }
+
+   static int shadowProbe( int probe, int count )
    {
-	   int i;
-	   int objectCount = sceGetObjectCount( scene );
+      int index = probe * count / SHADOW_FIRST_SAMPLES + probe;
+      int last = ( probe + 1 ) * count / SHADOW_FIRST_SAMPLES - 1;
 
-	   /* maxDistance = distncia de point at lightLocation */
-	   double maxDistance = algNorm( algSub( lightLocation, point ) );
+      return ( index < last ) ? index : last;
+   }
 
-	   /* Para cada objeto na cena */
-	   for( i = 0; i < objectCount; ++i )
-	   {
-		   double distance = objIntercept( sceGetObject( scene, i ), point, rayToLight );
-		   
-		   if( distance > 0.1 && distance < maxDistance )
-		   {
-			   return 1;
-		   }
-	   }
+   static double nextRandom( void )
+   {
+      /* xorshift de 32 bits */
+      unsigned long x = threadRandom;
+
+      x ^= ( x << 13 ) & 0xffffffffUL;
+      x ^= x >> 17;
+      x ^= ( x << 5 ) & 0xffffffffUL;
+      threadRandom = x;
+
+      return ( x & 0xffffffffUL ) / 4294967296.0;
+   }
+
+   static void renderWorker( void *data )
+   {
+      RenderWorker *worker = (RenderWorker *)data;
+      RenderJob *job = worker->job;
+      TileQueue *queue = &job->queues[worker->queue];
+      int tile;
+      int percentage;
+
+      memset( &threadShadowStats, 0, sizeof(threadShadowStats) );
+
+      for( ;; )
+      {
+         tile = popTile( queue );
+         if( tile < 0 )
+         {
+            if( !stealTiles( job, worker->queue ) )
+               break;
+            continue;
+         }
+
+         renderTile( job, tile );
+
+         /* O relatrio  serializado e nunca retrocede */
+         percentage = (int)( ( 100L * thrAtomicIncrement( &job->tilesDone ) ) / job->tileCount );
+         if( job->progress )
+         {
+            thrLock( job->progressLock );
+            if( percentage > job->percentage )
+            {
+               job->percentage = percentage;
+               job->progress( percentage );
+            }
+            thrUnlock( job->progressLock );
+         }
+      }
+
+      thrAtomicAdd( &shadowStats.traced, threadShadowStats.traced );
+      thrAtomicAdd( &shadowStats.blocked, threadShadowStats.blocked );
+      thrAtomicAdd( &shadowStats.cacheHits, threadShadowStats.cacheHits );
+      thrAtomicAdd( &shadowStats.saved, threadShadowStats.saved );
+   }
+
+   static int popTile( TileQueue *queue )
+   {
+      int tile = -1;
+
+      thrLock( queue->lock );
+      if( queue->next < queue->end )
+         tile = queue->next++;
+      thrUnlock( queue->lock );
+
+      return tile;
+   }
+
+   static int stealTiles( RenderJob *job, int thief )
+   {
+      int i;
+
+      for( i = 1; i < job->queueCount; ++i )
+      {
+         TileQueue *victim = &job->queues[( thief + i ) % job->queueCount];
+         int begin;
+         int end;
+
+         thrLock( victim->lock );
+         end = victim->end;
+         begin = end - ( end - victim->next + 1 ) / 2;
+         if( begin < end )
+            victim->end = begin;
+         thrUnlock( victim->lock );
+
+         if( begin < end )
+         {
+            TileQueue *queue = &job->queues[thief];
+
+            thrLock( queue->lock );
+            queue->next = begin;
+            queue->end = end;
+            thrUnlock( queue->lock );
+
+            return 1;
+         }
+      }
+
+      return 0;
+   }
+
+   static void renderTile( RenderJob *job, int tile )
+   {
+      int x0 = ( tile % job->tilesX ) * TILE_SIZE;
+      int y0 = ( tile / job->tilesX ) * TILE_SIZE;
+      int x1 = ( x0 + TILE_SIZE < job->width ) ? x0 + TILE_SIZE : job->width;
+      int y1 = ( y0 + TILE_SIZE < job->height ) ? y0 + TILE_SIZE : job->height;
+
+      /* O sorteio depende s do bloco (nunca zero, que o xorshift no deixaria) */
+      threadRandom = ( (unsigned long)tile * 2654435761UL + 1 ) & 0xffffffffUL;
+      if( threadRandom == 0 )
+         threadRandom = 1;
+
+      renderRegion( job, x0, y0, x1, y1 );
+   }
+
+   static void renderRegion( RenderJob *job, int x0, int y0, int x1, int y1 )
+   {
+      int x;
+      int y;
+
+      if( antialias != AA_NONE )
+      {
+         for( y = y0; y < y1; ++y )
+         {
+            for( x = x0; x < x1; ++x )
+               imageSetPixel( job->image, x, y,
+                              rayTracePixel( job->scene, x, y, (AntialiasMode)antialias, antialiasThreshold, NULL ) );
+         }
+         return;
+      }
+
+      if( wavefront )
+      {
+         renderWavefront( job, x0, y0, x1, y1 );
+         return;
+      }
+
+      if( packets )
+      {
+         for( y = y0; y < y1; y += 2 )
+         {
+            for( x = x0; x < x1; x += 2 )
+               renderPacket( job, x, y, x1, y1 );
+         }
+         return;
+      }
+
+      for( y = y0; y < y1; ++y )
+      {
+         for( x = x0; x < x1; ++x )
+         {
+            Vector ray = camGetRay( job->camera, x, y );
+            Color color = rayTrace( job->scene, job->eye, ray, 0 );
+
+            imageSetPixel( job->image, x, y, color );
+         }
+      }
+   }
+
+   static void renderPacket( RenderJob *job, int x, int y, int xEnd, int yEnd )
+   {
+      Vector rays[PACKET_SIZE];
+      int px[PACKET_SIZE];
+      int py[PACKET_SIZE];
+      Color colors[PACKET_SIZE];
+      PacketHit hit;
+      RayStack stack;
+      PendingRay path;
+      int k;
+
+      for( k = 0; k < PACKET_SIZE; ++k )
+      {
+         px[k] = x + ( k & 1 );
+         py[k] = y + ( k >> 1 );
+         if( px[k] >= xEnd )
+            px[k] = x;
+         if( py[k] >= yEnd )
+            py[k] = y;
+
+         rays[k] = camGetRay( job->camera, px[k], py[k] );
+      }
+
+      /* S os raios primrios andam em pacote; o sombreamento e os raios secundrios
+         de cada pixel seguem pelo caminho escalar */
+      pktGetNearestObjects( sceGetBvh( job->scene ), job->eye, rays, &hit );
+
+      /* Os raios secundrios dos quatro pixels dividem a mesma pilha */
+      rayStackInit( &stack );
+
+      for( k = 0; k < PACKET_SIZE; ++k )
+      {
+         if( ( k & 1 ) && px[k] == x )
+            continue;
+         if( ( k >> 1 ) && py[k] == y )
+            continue;
+
+         path.origin = job->eye;
+         path.direction = rays[k];
+         path.depth = 0;
+         path.travelled = 0.0;
+         path.weight = 1.0;
+         path.throughput = 1.0;
+         path.pixel = k;
+
+         colors[k] = traceHit( job->scene, &path, hit.object[k], hit.distance[k],
+                               hit.u[k], hit.v[k], &stack );
+      }
+
+      traceRays( job->scene, &stack, colors );
+      rayStackDestroy( &stack );
+
+      for( k = 0; k < PACKET_SIZE; ++k )
+      {
+         if( ( k & 1 ) && px[k] == x )
+            continue;
+         if( ( k >> 1 ) && py[k] == y )
+            continue;
+
+         imageSetPixel( job->image, px[k], py[k], colors[k] );
+      }
+   }
+
+   static void renderWavefront( RenderJob *job, int x0, int y0, int x1, int y1 )
+   {
+      Color colors[TILE_SIZE * TILE_SIZE];
+      RayStack wave;
+      RayStack spawned;
+      int x;
+      int y;
+      int i;
+
+      rayStackInit( &wave );
+      rayStackInit( &spawned );
+
+      /* Primeira onda: os raios primrios, na ordem dos pixels */
+      for( y = y0; y < y1; ++y )
+      {
+         for( x = x0; x < x1; ++x )
+         {
+            i = ( y - y0 ) * TILE_SIZE + ( x - x0 );
+            colors[i].red = colors[i].green = colors[i].blue = 0;
+            rayStackPush( &wave, job->eye, camGetRay( job->camera, x, y ), 0, 0.0, 1.0, 1.0, i );
+         }
+      }
+
+      while( wave.count > 0 )
+      {
+         for( i = 0; i < wave.count; ++i )
+            traceRay( job->scene, &wave.rays[i], &spawned, colors );
+
+         /* A prxima onda so os raios secundrios gerados por esta */
+         sortRays( &spawned, &wave );
+      }
+
+      rayStackDestroy( &wave );
+      rayStackDestroy( &spawned );
+
+      for( y = y0; y < y1; ++y )
+      {
+         for( x = x0; x < x1; ++x )
+            imageSetPixel( job->image, x, y, colors[( y - y0 ) * TILE_SIZE + ( x - x0 )] );
+      }
+   }
+
+   static void sortRays( RayStack *source, RayStack *target )
+   {
+      RayKey *keys = NULL;
+      Vector minimum, maximum;
+      double scale[3];
+      PendingRay *ray;
+      int i;
+
+      target->count = 0;
+
+      if( source->count > 1 )
+         keys = (RayKey *)malloc( source->count * sizeof(RayKey) );
+
+      if( keys == NULL )
+      {
+         for( i = 0; i < source->count; ++i )
+         {
+            ray = &source->rays[i];
+            rayStackPush( target, ray->origin, ray->direction, ray->depth, ray->travelled,
+                          ray->weight, ray->throughput, ray->pixel );
+         }
+         source->count = 0;
+         return;
+      }
+
+      /* As origens so quantizadas dentro da caixa envolvente da prpria onda */
+      minimum = maximum = source->rays[0].origin;
+      for( i = 1; i < source->count; ++i )
+      {
+         ray = &source->rays[i];
+         minimum.x = ( ray->origin.x < minimum.x ) ? ray->origin.x : minimum.x;
+         minimum.y = ( ray->origin.y < minimum.y ) ? ray->origin.y : minimum.y;
+         minimum.z = ( ray->origin.z < minimum.z ) ? ray->origin.z : minimum.z;
+         maximum.x = ( ray->origin.x > maximum.x ) ? ray->origin.x : maximum.x;
+         maximum.y = ( ray->origin.y > maximum.y ) ? ray->origin.y : maximum.y;
+         maximum.z = ( ray->origin.z > maximum.z ) ? ray->origin.z : maximum.z;
+      }
+
+      scale[0] = ( maximum.x > minimum.x ) ? ( ( 1 << MORTON_BITS ) - 1 ) / ( maximum.x - minimum.x ) : 0;
+      scale[1] = ( maximum.y > minimum.y ) ? ( ( 1 << MORTON_BITS ) - 1 ) / ( maximum.y - minimum.y ) : 0;
+      scale[2] = ( maximum.z > minimum.z ) ? ( ( 1 << MORTON_BITS ) - 1 ) / ( maximum.z - minimum.z ) : 0;
+
+      for( i = 0; i < source->count; ++i )
+      {
+         ray = &source->rays[i];
+
+         keys[i].index = i;
+         keys[i].key = (unsigned long)( ( ray->direction.x < 0 ) | ( ray->direction.y < 0 ) << 1 |
+                                        ( ray->direction.z < 0 ) << 2 ) << ( 3 * MORTON_BITS ) |
+                       spreadBits( (unsigned long)( ( ray->origin.x - minimum.x ) * scale[0] ) ) |
+                       spreadBits( (unsigned long)( ( ray->origin.y - minimum.y ) * scale[1] ) ) << 1 |
+                       spreadBits( (unsigned long)( ( ray->origin.z - minimum.z ) * scale[2] ) ) << 2;
+      }
+
+      qsort( keys, source->count, sizeof(RayKey), compareRayKeys );
+
+      for( i = 0; i < source->count; ++i )
+      {
+         ray = &source->rays[keys[i].index];
+         rayStackPush( target, ray->origin, ray->direction, ray->depth, ray->travelled,
+                       ray->weight, ray->throughput, ray->pixel );
+      }
+
+      free( keys );
+      source->count = 0;
+   }
+
+   static int compareRayKeys( const void *a, const void *b )
+   {
+      const RayKey *first = (const RayKey *)a;
+      const RayKey *second = (const RayKey *)b;
+
+      if( first->key != second->key )
+         return ( first->key < second->key ) ? -1 : 1;
+
+      /* Mantm a ordem original entre raios de mesma chave */
+      return first->index - second->index;
+   }
+
+   static unsigned long spreadBits( unsigned long value )
+   {
+      value &= ( 1UL << MORTON_BITS ) - 1;
+      value = ( value | ( value << 16 ) ) & 0x030000ffUL;
+      value = ( value | ( value << 8 ) ) & 0x0300f00fUL;
+      value = ( value | ( value << 4 ) ) & 0x030c30c3UL;
+      value = ( value | ( value << 2 ) ) & 0x09249249UL;
 
-	   return 0;
+      return value;
    }
 
 
@@ -20,6 +20,105 @@
 #include "color.h"
 
 
+/************************************************************************/
+/* Constantes Exportadas                                                */
+/************************************************************************/
+/** Lado da grade de amostras de um pixel com antialiasing (at 4x4 = 16 amostras) */
+#define AA_GRID			4
+
+/** Limiar usual de contraste entre as amostras iniciais de um pixel (veja AA_ADAPTIVE) */
+#define AA_THRESHOLD	0.1
+
+
+/************************************************************************/
+/* Tipos Exportados                                                     */
+/************************************************************************/
+/**
+ *   Modos de antialiasing de rayTracePixel().
+ */
+typedef enum
+{
+	/**
+	 *  Uma amostra, no canto (x,y) do pixel.
+	 */
+	AA_NONE,
+	/**
+	 *  Uma amostra em cada linha e em cada coluna da grade (AA_GRID amostras); se
+	 *  alguma componente de cor variar entre elas mais que o limiar, o restante da
+	 *  grade tambm  amostrado.
+	 */
+	AA_ADAPTIVE,
+	/**
+	 *  Sempre a grade inteira (AA_GRID x AA_GRID amostras).
+	 */
+	AA_FULL
+}
+AntialiasMode;
+
+/**
+ *   Estatsticas dos raios de sombra (veja rayTraceGetShadowStats()).
+ */
+typedef struct
+{
+	/**
+	 *  Raios de sombra traados e, destes, os bloqueados.
+	 */
+	long traced;
+	long blocked;
+	/**
+	 *  Raios bloqueados resolvidos testando apenas o objeto que bloqueou o raio
+	 *  anterior da mesma luz, sem percorrer a hierarquia.
+	 */
+	long cacheHits;
+	/**
+	 *  Raios poupados pela amostragem adaptativa das luzes de rea: as amostras
+	 *  que no precisaram ser testadas fora das penumbras.
+	 */
+	long saved;
+}
+ShadowStats;
+
+
+/************************************************************************/
+/* Variveis Exportadas                                                 */
+/************************************************************************/
+/**
+ *	Threads usadas por rayTraceScene() e pelo refinamento progressivo da interface;
+ *	zero usa uma por processador.
+ */
+extern int renderThreads;
+
+/**
+ *	Diferente de zero para traar os raios primrios em pacotes de 2x2 pixels
+ *	(veja packet.h). No se aplica com antialiasing.
+ */
+extern int packets;
+
+/**
+ *	Diferente de zero para traar os blocos em ondas de raios ordenados (primeiro
+ *	os primrios, depois os secundrios gerados por eles). Tem precedncia sobre
+ *	os pacotes e no se aplica com antialiasing.
+ */
+extern int wavefront;
+
+/**
+ *	Antialiasing de rayTraceScene() (um AntialiasMode) e o contraste usado pelo
+ *	modo AA_ADAPTIVE (veja rayTracePixel()).
+ */
+extern int antialias;
+extern double antialiasThreshold;
+
+/**
+ *	Raios secundrios: profundidade mxima e peso mnimo na cor do pixel. Com
+ *	roleta russa (russianRoulette diferente de zero), os raios abaixo do peso
+ *	mnimo sobrevivem com probabilidade proporcional ao peso, em vez de serem
+ *	descartados.
+ */
+extern int maxDepth;
+extern double minRayWeight;
+extern int russianRoulette;
+
+
 /************************************************************************/
 /* Funes Exportadas                                                   */
 /************************************************************************/
@@ -30,9 +129,60 @@
  *	@param eye   vetor de posicao da origem do raio.
  *  @param ray   vetor de direcao do raio.
  *  @param depth nivel de recursao do raio (inicialmente deve ser passado como 0).
+ *               Os raios secundrios so traados at a profundidade da varivel
+ *               global maxDepth, sem recurso (veja traceRays() em raytracing.c).
  *
  *	@return cor  correspondente ao raio.
  */
 Color rayTrace( Scene scene, Vector eye, Vector ray, int depth );
+
+/**
+ *	Calcula a cor de um pixel da cmera da cena, com antialiasing. As amostras
+ *	ficam nos centros das clulas de uma grade de AA_GRID x AA_GRID sobre o pixel,
+ *	e a cor  a mdia das amostras traadas.
+ *
+ *	@param scene Handle para cena.
+ *	@param x Coluna do pixel.
+ *	@param y Linha do pixel.
+ *	@param mode Modo de antialiasing.
+ *	@param threshold Contraste, em cada componente de cor, a partir do qual o modo
+ *					AA_ADAPTIVE amostra a grade inteira.
+ *	@param samples [out]Nmero de raios primrios traados. Pode ser NULL.
+ *
+ *	@return Cor do pixel.
+ */
+Color rayTracePixel( Scene scene, int x, int y, AntialiasMode mode, double threshold, int *samples );
+
+/**
+ *	Renderiza a cena inteira, do ponto de vista da sua cmera. A imagem  dividida
+ *	em blocos distribudos entre vrias threads (uma por processador, a menos que
+ *	a varivel global renderThreads indique outro nmero). O antialiasing  o da
+ *	varivel global antialias (AA_NONE se no for alterada).
+ *
+ *	@param scene Handle para cena.
+ *	@param progress Funo chamada com o percentual (0 a 100) de pixels concludos,
+ *					sempre de uma thread por vez e em ordem crescente. Pode ser NULL.
+ *
+ *	@return Imagem renderizada. NULL se no houver memria.
+ */
+Image rayTraceScene( Scene scene, void (*progress)( int percentage ) );
+
+/**
+ *	Renderiza uma regio da imagem na thread corrente, como rayTraceScene() faz com
+ *	cada bloco (com as mesmas variveis globais de antialiasing e pacotes).
+ *
+ *	@param scene Handle para cena.
+ *	@param image Imagem com as dimenses da tela da cmera.
+ *	@param x0 Primeira coluna.
+ *	@param y0 Primeira linha.
+ *	@param x1 Coluna seguinte  ltima.
+ *	@param y1 Linha seguinte  ltima.
+ */
+void rayTraceRegion( Scene scene, Image image, int x0, int y0, int x1, int y1 );
+
+/**
+ *	Obtm as estatsticas dos raios de sombra da ltima chamada de rayTraceScene().
+ */
+void rayTraceGetShadowStats( ShadowStats *stats );
 #endif
 
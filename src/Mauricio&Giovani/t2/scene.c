@@ -14,6 +14,10 @@
 
 #include "scene.h"
 #include "raytracing.h"
+#include "binary.h"
+#include "tokenizer.h"
+#include "thread.h"
+#include "texture.h"
 #include <math.h>
 #include <stdio.h>
 #include <string.h>
@@ -21,6 +25,154 @@
 #include <sys/timeb.h>
 
 
+/************************************************************************/
+/* Constantes Privadas                                                  */
+/************************************************************************/
+/** Tamanho mnimo, em bytes, do trecho de um arquivo rt4 lido por cada thread */
+#define SCENE_LOAD_CHUNK	( 1 << 20 )
+
+
+/************************************************************************/
+/* Tipos Privados                                                       */
+/************************************************************************/
+/**
+ *   Trecho de um arquivo rt4 lido por uma thread. Os objetos so criados em um
+ *   vetor prprio; as demais linhas (materiais, luzes, cmera...) so apenas
+ *   anotadas, para serem interpretadas depois, na ordem do arquivo.
+ */
+typedef struct
+{
+	Tokenizer tokenizer;
+
+	/**
+	 *  Objetos criados a partir do trecho, na ordem em que aparecem.
+	 */
+	Object *objects;
+	int objectCount;
+	int objectCapacity;
+
+	/**
+	 *  Incio de cada linha que no define um objeto.
+	 */
+	const char **deferred;
+	int deferredCount;
+	int deferredCapacity;
+}
+SceneChunk;
+
+
+/************************************************************************/
+/* Funes Privadas                                                     */
+/************************************************************************/
+/**
+ *	Comandos de um arquivo rt4, identificados pela palavra-chave no incio da linha.
+ */
+typedef enum
+{
+	COMMAND_UNKNOWN,
+	COMMAND_RT,
+	COMMAND_CAMERA,
+	COMMAND_SCENE,
+	COMMAND_MATERIAL,
+	COMMAND_LIGHT,
+	COMMAND_SPHERE,
+	COMMAND_TRIANGLE,
+	COMMAND_BOX
+}
+SceneCommand;
+
+/**
+ *	L a palavra-chave da linha atual e identifica o comando.
+ */
+static SceneCommand sceGetCommand( Tokenizer *tokenizer );
+
+/**
+ *	Compara uma palavra-chave lida (sem '\0') com o nome de um comando.
+ */
+static int sceIsKeyword( const char *keyword, size_t length, const char *name );
+
+/**
+ *	L 'count' nmeros reais seguidos da linha atual.
+ *
+ *	@return Zero se a linha tiver menos nmeros.
+ */
+static int sceReadReals( Tokenizer *tokenizer, double *value, int count );
+
+/**
+ *	Interpreta a linha atual e acrescenta  cena o que ela define.
+ *
+ *	@return Zero se a linha no  um comando vlido.
+ */
+static int sceParseCommand( Scene scene, Tokenizer *tokenizer );
+
+/**
+ *	L os campos de um comando SPHERE, TRIANGLE ou BOX, cuja palavra-chave j foi
+ *	lida, e cria o objeto. No depende da cena, por isso pode ser chamada por
+ *	vrias threads ao mesmo tempo.
+ *
+ *	@return Objeto criado (NULL se a linha no  vlida ou o ndice de material 
+ *			negativo; o limite superior s  conferido por sceCheckMaterials()).
+ */
+static Object sceParseObject( SceneCommand command, Tokenizer *tokenizer );
+
+/**
+ *	L todo o texto na thread corrente, linha a linha.
+ */
+static void sceParseSerial( Scene scene, Tokenizer tokenizer );
+
+/**
+ *	Divide o texto em trechos, em fronteiras de linha, e l cada um em uma thread
+ *	(veja sceParseChunk()). Ao final, as linhas anotadas so interpretadas e os
+ *	objetos acrescentados  cena na ordem do arquivo, de modo que o resultado  o
+ *	mesmo de sceParseSerial(). Os ndices de material dos objetos se referem 
+ *	ordem dos comandos MATERIAL no arquivo inteiro, que tambm  preservada.
+ *
+ *	@return Zero se no houver memria para os trechos (nada foi lido).
+ */
+static int sceParseParallel( Scene scene, const char *text, size_t size, int threadCount );
+
+/**
+ *	Funo das threads de sceParseParallel(): l um trecho (SceneChunk).
+ */
+static void sceParseChunk( void *data );
+
+/**
+ *	Descarta os objetos que referenciam materiais inexistentes. Os ndices se
+ *	referem aos comandos MATERIAL do arquivo inteiro, por isso s podem ser
+ *	conferidos depois que toda a cena foi lida.
+ */
+static void sceCheckMaterials( Scene scene );
+
+/**
+ *	Acrescenta um objeto ao vetor da cena (ou o destri, se no houver memria).
+ *
+ *	@return Sempre no-zero: a linha foi reconhecida, mesmo que o objeto seja ignorado.
+ */
+static int sceAddObject( Scene scene, Object object );
+
+/**
+ *	Conta as definies de materiais, luzes e objetos de um arquivo rt4, para que
+ *	os vetores da cena sejam alocados de uma s vez. Recebe uma cpia do estado
+ *	da leitura, de modo que o texto pode ser percorrido de novo em seguida.
+ */
+static void sceCountCommands( Tokenizer tokenizer, int *materialCount, int *lightCount, int *objectCount );
+
+/**
+ *	Garante espao para pelo menos 'required' elementos de tamanho 'size' em um
+ *	vetor crescente, dobrando sua capacidade quando necessrio.
+ *
+ *	@return Zero se no houver memria (neste caso o vetor original  preservado).
+ */
+static int sceReserve( void **array, int *capacity, int required, size_t size );
+
+/**
+ *	Cria uma cor a partir de componentes lidas em double. As coordenadas e cores do
+ *	arquivo so sempre lidas em double e s ento convertidas, pois Vector e Color
+ *	podem estar em preciso simples (veja ALGEBRA_FLOAT em algebra.h).
+ */
+static Color sceColor( double red, double green, double blue );
+
+
 /************************************************************************/
 /* Definio das Funes Exportadas                                     */
 /************************************************************************/
@@ -117,48 +269,26 @@ Light sceGetLight( Scene scene, int index )
 	return scene->lights[index];
 }
 
-Scene sceLoad( const char *filename )
+Bvh sceGetBvh( Scene scene )
 {
-	FILE *file;
-	char buffer[512];
+	return scene->bvh;
+}
 
+Scene sceLoad( const char *filename )
+{
+	MappedFile file;
+	Tokenizer tokenizer;
 	Scene scene;
+	int threadCount;
 	
-	Color bgColor;
-	Color ambientLight;
-	char backgroundFileName[FILENAME_MAXLEN];
-
-	/* Camera */
-	Vector eye = algVector( 0,0,0,1 );
-	Vector at = algVector( 0,0,0,1 );
-	Vector up = algVector( 0,0,0,1 );
-	double fovy;
-	double nearp;
-	double farp;
-	int screenWidth;
-	int screenHeight;
-
-	/* Material */
-	Color diffuse;
-	Color specular;
-	double specularExponent;
-	double reflective;
-	double refractive;
-	double opacity;
-	char textureFileName[FILENAME_MAXLEN];
-	
-	/* Lights & Objects */
-	Color lightColor;
-	int material;
-	Vector pos1 = algVector( 0,0,0,1 );
-	Vector pos2 = algVector( 0,0,0,1 );
-	Vector pos3 = algVector( 0,0,0,1 );
-	Vector tex1 = algVector( 0,0,0,1 );
-	Vector tex2 = algVector( 0,0,0,1 );
-	Vector tex3 = algVector( 0,0,0,1 );
-	double radius;
-	
-	file = fopen( filename, "rt" );
+	/* Cenas compiladas so mapeadas em memria em vez de interpretadas */
+	if( binIsCompiled( filename ) )
+	{
+		return binLoad( filename );
+	}
+
+	/* O texto  lido diretamente do arquivo mapeado, sem limite de tamanho de linha */
+	file = mapOpen( filename );
 	if( !file )
 	{
 		return NULL;
@@ -167,6 +297,7 @@ Scene sceLoad( const char *filename )
 	scene = (struct _Scene *)malloc( sizeof(struct _Scene) );
 	if( !scene )
 	{
+		mapClose( file );
 		return NULL;
 	}
 
@@ -176,153 +307,657 @@ Scene sceLoad( const char *filename )
 	scene->objectCount = 0;
 	scene->lightCount = 0;
 	scene->materialCount = 0;
+	scene->objectCapacity = 0;
+	scene->lightCapacity = 0;
+	scene->materialCapacity = 0;
+	scene->objects = NULL;
+	scene->lights = NULL;
+	scene->materials = NULL;
+	scene->textureFileNames = NULL;
+	scene->textureFileNameCapacity = 0;
+	scene->bvh = NULL;
+	scene->mapping = NULL;
+	scene->objectBlock = NULL;
+	strcpy( scene->bgFileName, "null" );
 	
-	while( fgets( buffer, sizeof(buffer), file ) ) 
+	/* Arquivos grandes so divididos entre as threads, cada uma com pelo menos SCENE_LOAD_CHUNK bytes */
+	threadCount = thrGetProcessorCount();
+	if( (size_t)threadCount > mapGetSize( file ) / SCENE_LOAD_CHUNK )
 	{
-		if( sscanf( buffer, "RT %lf\n", &at ) == 1 )
+		threadCount = (int)( mapGetSize( file ) / SCENE_LOAD_CHUNK );
+	}
+
+	if( threadCount < 2 || !sceParseParallel( scene, (const char *)mapGetData( file ), mapGetSize( file ), threadCount ) )
+	{
+		tokInit( &tokenizer, (const char *)mapGetData( file ), mapGetSize( file ) );
+		sceParseSerial( scene, tokenizer );
+	}
+
+	/* Adjust background image to screen size */
+	if( scene->camera && scene->bgImage )
+	{
+		scene->bgImage = imageResize( scene->bgImage, camGetScreenWidth( scene->camera ),
+			camGetScreenHeight( scene->camera ) );
+	}
+
+	mapClose( file );
+
+	sceCheckMaterials( scene );
+
+	/* Constri a hierarquia de volumes envolventes uma nica vez, aps a leitura */
+	scene->bvh = bvhCreate( scene->objects, scene->objectCount );
+
+	return scene;
+}
+
+
+int sceGetMaterialCount( Scene scene )
+{
+	return scene->materialCount;
+}
+
+Material sceGetMaterial( Scene scene, int index )
+{
+	if( index < 0 || index >= scene->materialCount )
+	{
+		return NULL;
+	}
+
+	return scene->materials[index];
+}
+
+void sceDestroy( Scene scene )
+{
+	int i;
+
+	camDestroy( scene->camera );
+	imageDestroy( scene->bgImage );
+	bvhDestroy( scene->bvh );
+
+	if( scene->objectBlock )
+	{
+		free( scene->objectBlock );
+	}
+	else
+	{
+		for( i = 0; i < scene->objectCount; ++i )
+		{
+			objDestroy( scene->objects[i] );
+		}
+	}
+
+	for( i = 0; i < scene->materialCount; ++i )
+	{
+		matDestroy( scene->materials[i] );
+	}
+
+	for( i = 0; i < scene->lightCount; ++i )
+	{
+		lightDestroy( scene->lights[i] );
+	}
+
+	free( scene->objects );
+	free( scene->materials );
+	free( scene->textureFileNames );
+	free( scene->lights );
+
+	/* S depois da hierarquia e dos objetos, que podem apontar para o mapeamento */
+	mapClose( scene->mapping );
+	
+	free( scene );
+}
+
+/************************************************************************/
+/* Definio das Funes Privadas                                       */
+/************************************************************************/
+static SceneCommand sceGetCommand( Tokenizer *tokenizer )
+{
+	size_t length;
+	const char *keyword = tokKeyword( tokenizer, &length );
+
+	if( length == 0 )
+	{
+		return COMMAND_UNKNOWN;
+	}
+
+	/* Despacha pela primeira letra; s ento compara a palavra inteira */
+	switch( keyword[0] )
+	{
+	case 'T':
+		return sceIsKeyword( keyword, length, "TRIANGLE" ) ? COMMAND_TRIANGLE : COMMAND_UNKNOWN;
+	case 'S':
+		if( sceIsKeyword( keyword, length, "SPHERE" ) )
 		{
-			/* Ignore File Version Information */
+			return COMMAND_SPHERE;
 		}
-		else if( sscanf( buffer, "CAMERA %lf %lf %lf %lf %lf %lf %lf %lf %lf %lf %lf %lf %d %d\n", &eye.x, &eye.y, &eye.z, &at.x, &at.y, &at.z, &up.x, &up.y, &up.z, &fovy, &nearp, &farp, &screenWidth, &screenHeight ) == 14) 
+		return sceIsKeyword( keyword, length, "SCENE" ) ? COMMAND_SCENE : COMMAND_UNKNOWN;
+	case 'B':
+		return sceIsKeyword( keyword, length, "BOX" ) ? COMMAND_BOX : COMMAND_UNKNOWN;
+	case 'M':
+		return sceIsKeyword( keyword, length, "MATERIAL" ) ? COMMAND_MATERIAL : COMMAND_UNKNOWN;
+	case 'L':
+		return sceIsKeyword( keyword, length, "LIGHT" ) ? COMMAND_LIGHT : COMMAND_UNKNOWN;
+	case 'C':
+		return sceIsKeyword( keyword, length, "CAMERA" ) ? COMMAND_CAMERA : COMMAND_UNKNOWN;
+	case 'R':
+		return sceIsKeyword( keyword, length, "RT" ) ? COMMAND_RT : COMMAND_UNKNOWN;
+	default:
+		return COMMAND_UNKNOWN;
+	}
+}
+
+static int sceIsKeyword( const char *keyword, size_t length, const char *name )
+{
+	return strlen( name ) == length && memcmp( keyword, name, length ) == 0;
+}
+
+static int sceReadReals( Tokenizer *tokenizer, double *value, int count )
+{
+	int i;
+
+	for( i = 0; i < count; ++i )
+	{
+		if( !tokReal( tokenizer, &value[i] ) )
+		{
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+static int sceParseCommand( Scene scene, Tokenizer *tokenizer )
+{
+	SceneCommand command = sceGetCommand( tokenizer );
+	double value[12];
+	char fileName[FILENAME_MAXLEN];
+	Object object;
+
+	switch( command )
+	{
+	case COMMAND_RT:
+		/* Ignore File Version Information */
+		return tokReal( tokenizer, &value[0] );
+
+	case COMMAND_CAMERA:
 		{
+			int screenWidth;
+			int screenHeight;
+
+			if( !sceReadReals( tokenizer, value, 12 ) ||
+				!tokInt( tokenizer, &screenWidth ) || !tokInt( tokenizer, &screenHeight ) )
+			{
+				return 0;
+			}
+
 			if( scene->camera )
 			{
 				camDestroy( scene->camera );
 			}
 
-			scene->camera = camCreate( eye, at, up, fovy, nearp, farp, screenWidth, screenHeight );
+			scene->camera = camCreate( algVector( value[0], value[1], value[2], 1 ),
+									   algVector( value[3], value[4], value[5], 1 ),
+									   algVector( value[6], value[7], value[8], 1 ),
+									   value[9], value[10], value[11], screenWidth, screenHeight );
+			return 1;
+		}
+
+	case COMMAND_SCENE:
+		if( !sceReadReals( tokenizer, value, 6 ) || !tokString( tokenizer, fileName, sizeof(fileName) ) )
+		{
+			return 0;
+		}
+
+		scene->bgColor = colorNormalize( sceColor( value[0], value[1], value[2] ) );
+		scene->ambientLight = colorNormalize( sceColor( value[3], value[4], value[5] ) );
+
+		if( scene->bgImage )
+		{
+			imageDestroy( scene->bgImage );
+		}
+
+		strcpy( scene->bgFileName, fileName );
+
+		if( strcmp( fileName, "null") == 0 )
+		{
+			scene->bgImage = NULL;
 		} 
-		else if( sscanf( buffer, "SCENE %lf %lf %lf %lf %lf %lf %s\n", &bgColor.red, &bgColor.green, &bgColor.blue, &ambientLight.red, &ambientLight.green, &ambientLight.blue, backgroundFileName ) == 7 ) 
+		else 
 		{
-			bgColor = colorNormalize( bgColor );
-			ambientLight = colorNormalize( ambientLight );
+			scene->bgImage = imageLoad( fileName );
+		}
+		return 1;
 
-			scene->bgColor = bgColor;
-			scene->ambientLight = ambientLight;
+	case COMMAND_MATERIAL:
+		{
+			Texture texture = NULL;
+			Color diffuse;
+			Color specular;
 
-			if( scene->bgImage )
+			if( !sceReadReals( tokenizer, value, 10 ) || !tokString( tokenizer, fileName, sizeof(fileName) ) )
 			{
-				imageDestroy( scene->bgImage );
+				return 0;
 			}
 
-			if( strcmp( backgroundFileName, "null") == 0 )
+			if( strcmp( fileName, "null") != 0 )
 			{
-				scene->bgImage = NULL;
-			} 
-			else 
+				texture = texAcquire( fileName );
+			}
+
+			if( !sceReserve( (void **)&scene->materials, &scene->materialCapacity, scene->materialCount + 1, sizeof(Material) ) ||
+				!sceReserve( (void **)&scene->textureFileNames, &scene->textureFileNameCapacity, scene->materialCount + 1, FILENAME_MAXLEN ) )
 			{
-				scene->bgImage = imageLoad( backgroundFileName );
+				texRelease( texture );
+				fprintf( stderr, "sceLoad: Memoria insuficiente para os materiais da cena. Ignorando." );
+				return 1;
 			}
-		} 
-		else if( sscanf( buffer, "MATERIAL %lf %lf %lf %lf %lf %lf %lf %lf %lf %lf %s\n", &diffuse.red, &diffuse.green, &diffuse.blue, &specular.red, &specular.green, &specular.blue, &specularExponent, &reflective, &refractive, &opacity, textureFileName ) == 11 ) 
+
+			diffuse = colorNormalize( sceColor( value[0], value[1], value[2] ) );
+			specular = colorNormalize( sceColor( value[3], value[4], value[5] ) );
+
+			strcpy( scene->textureFileNames[scene->materialCount], fileName );
+			scene->materials[scene->materialCount++] = matCreate( texture, diffuse, specular, value[6], value[7], value[8], value[9] );
+			return 1;
+		}
+
+	case COMMAND_LIGHT:
 		{
-			Image image = NULL;
-			
-			if( strcmp( textureFileName, "null") != 0 )
+			/* LIGHT x y z r g b [SPHERE raio [amostras] | QUAD ux uy uz vx vy vz [amostras]] */
+			Vector position;
+			Color color;
+			const char *shape;
+			size_t length;
+			int samples = LIGHT_DEFAULT_SAMPLES;
+			Light light;
+
+			if( !sceReadReals( tokenizer, value, 6 ) )
 			{
-				image = imageLoad( textureFileName );
+				return 0;
 			}
 
-			if( scene->materialCount >= MAX_MATERIALS )
+			position = algVector( value[0], value[1], value[2], 1 );
+			color = colorNormalize( sceColor( value[3], value[4], value[5] ) );
+
+			shape = tokKeyword( tokenizer, &length );
+			if( length == 0 )
+			{
+				light = lightCreate( position, color );
+			}
+			else if( sceIsKeyword( shape, length, "SPHERE" ) && sceReadReals( tokenizer, value, 1 ) )
 			{
-				imageDestroy( image );
-				fprintf( stderr, "sceLoad: Foi ultrapassado o limite de definicoes de materiais na cena. Ignorando." );
-				continue;
+				tokInt( tokenizer, &samples );
+				light = lightCreateSphere( position, value[0], color, samples );
+			}
+			else if( sceIsKeyword( shape, length, "QUAD" ) && sceReadReals( tokenizer, value, 6 ) )
+			{
+				tokInt( tokenizer, &samples );
+				light = lightCreateQuad( position, algVector( value[0], value[1], value[2], 0 ),
+										 algVector( value[3], value[4], value[5], 0 ), color, samples );
+			}
+			else
+			{
+				return 0;
 			}
 
-			diffuse = colorNormalize( diffuse );
-			specular = colorNormalize( specular );
+			if( !sceReserve( (void **)&scene->lights, &scene->lightCapacity, scene->lightCount + 1, sizeof(Light) ) )
+			{
+				fprintf( stderr, "sceLoad: Memoria insuficiente para as luzes da cena. Ignorando." );
+				lightDestroy( light );
+				return 1;
+			}
 
-			scene->materials[scene->materialCount++] = matCreate( image, diffuse, specular, specularExponent, reflective, refractive, opacity );
-		} 
-		else if( sscanf( buffer, "LIGHT %lf %lf %lf %lf %lf %lf\n", &pos1.x, &pos1.y, &pos1.z, &lightColor.red, &lightColor.green, &lightColor.blue ) == 6 )
+			scene->lights[scene->lightCount++] = light;
+			return 1;
+		}
+
+	case COMMAND_SPHERE:
+	case COMMAND_TRIANGLE:
+	case COMMAND_BOX:
+		object = sceParseObject( command, tokenizer );
+		return object ? sceAddObject( scene, object ) : 0;
+
+	default:
+		return 0;
+	}
+}
+
+static Object sceParseObject( SceneCommand command, Tokenizer *tokenizer )
+{
+	double value[15];
+	int material;
+
+	if( !tokInt( tokenizer, &material ) || material < 0 )
+	{
+		return NULL;
+	}
+
+	switch( command )
+	{
+	case COMMAND_SPHERE:
+		if( !sceReadReals( tokenizer, value, 4 ) )
+		{
+			return NULL;
+		}
+
+		return objCreateSphere( material, algVector( value[1], value[2], value[3], 1 ), value[0] );
+
+	case COMMAND_TRIANGLE:
+		if( !sceReadReals( tokenizer, value, 15 ) )
+		{
+			return NULL;
+		}
+
+		return objCreateTriangle( material,
+								  algVector( value[0], value[1], value[2], 1 ),
+								  algVector( value[3], value[4], value[5], 1 ),
+								  algVector( value[6], value[7], value[8], 1 ),
+								  algVector( value[9], value[10], 0, 1 ),
+								  algVector( value[11], value[12], 0, 1 ),
+								  algVector( value[13], value[14], 0, 1 ) );
+
+	case COMMAND_BOX:
+		if( !sceReadReals( tokenizer, value, 6 ) )
+		{
+			return NULL;
+		}
+
+		return objCreateBox( material, algVector( value[0], value[1], value[2], 1 ),
+							 algVector( value[3], value[4], value[5], 1 ) );
+
+	default:
+		return NULL;
+	}
+}
+
+static void sceParseSerial( Scene scene, Tokenizer tokenizer )
+{
+	int materialTotal;
+	int lightTotal;
+	int objectTotal;
+
+	/* Reserva os vetores de acordo com o que o arquivo define */
+	sceCountCommands( tokenizer, &materialTotal, &lightTotal, &objectTotal );
+	sceReserve( (void **)&scene->materials, &scene->materialCapacity, materialTotal, sizeof(Material) );
+	sceReserve( (void **)&scene->textureFileNames, &scene->textureFileNameCapacity, materialTotal, FILENAME_MAXLEN );
+	sceReserve( (void **)&scene->lights, &scene->lightCapacity, lightTotal, sizeof(Light) );
+	sceReserve( (void **)&scene->objects, &scene->objectCapacity, objectTotal, sizeof(Object) );
+
+	while( tokNextLine( &tokenizer ) ) 
+	{
+		if( !sceParseCommand( scene, &tokenizer ) )
 		{
-			if( scene->lightCount >= MAX_LIGHTS )
+			size_t length;
+			const char *line = tokGetLine( &tokenizer, &length );
+
+			printf( "sceLoad: Ignorando comando:\n %.*s\n", (int)length, line );
+		}
+	}
+}
+
+static int sceParseParallel( Scene scene, const char *text, size_t size, int threadCount )
+{
+	SceneChunk *chunks;
+	Thread *threads;
+	const char *end = text + size;
+	const char *begin = text;
+	int objectTotal = 0;
+	int i, j;
+
+	chunks = (SceneChunk *)malloc( threadCount * sizeof(SceneChunk) );
+	threads = (Thread *)malloc( threadCount * sizeof(Thread) );
+	if( !chunks || !threads )
+	{
+		free( chunks );
+		free( threads );
+		return 0;
+	}
+
+	/* Cada trecho termina logo aps o primeiro '\n' a partir da sua frao do arquivo */
+	for( i = 0; i < threadCount; ++i )
+	{
+		const char *chunkEnd = end;
+
+		if( i < threadCount - 1 )
+		{
+			const char *split = text + (size_t)( (double)size * ( i + 1 ) / threadCount );
+
+			if( split < begin )
 			{
-				fprintf( stderr, "sceLoad: Foi ultrapassado o limite de definicoes de luzes na cena. Ignorando." );
-				continue;
+				split = begin;
 			}
 
-			lightColor = colorNormalize( lightColor );
+			chunkEnd = (const char *)memchr( split, '\n', end - split );
+			chunkEnd = chunkEnd ? chunkEnd + 1 : end;
+		}
 
-			scene->lights[scene->lightCount++] = lightCreate( pos1, lightColor );
-		} 
-		else if( sscanf( buffer, "SPHERE %d %lf %lf %lf %lf\n", &material, &radius, &pos1.x,&pos1.y,&pos1.z ) == 5 ) 
+		tokInit( &chunks[i].tokenizer, begin, chunkEnd - begin );
+		chunks[i].objects = NULL;
+		chunks[i].objectCount = 0;
+		chunks[i].objectCapacity = 0;
+		chunks[i].deferred = NULL;
+		chunks[i].deferredCount = 0;
+		chunks[i].deferredCapacity = 0;
+
+		begin = chunkEnd;
+	}
+
+	/* A thread corrente l o primeiro trecho. Se alguma thread no puder ser criada,
+	   seu trecho tambm  lido pela thread corrente, depois. */
+	for( i = 1; i < threadCount; ++i )
+	{
+		threads[i] = thrCreate( sceParseChunk, &chunks[i] );
+	}
+
+	sceParseChunk( &chunks[0] );
+
+	for( i = 1; i < threadCount; ++i )
+	{
+		if( threads[i] )
+		{
+			thrJoin( threads[i] );
+		}
+		else
+		{
+			sceParseChunk( &chunks[i] );
+		}
+	}
+
+	/* Materiais, luzes e cmera, na ordem do arquivo */
+	for( i = 0; i < threadCount; ++i )
+	{
+		objectTotal += chunks[i].objectCount;
+
+		for( j = 0; j < chunks[i].deferredCount; ++j )
 		{
-			if( scene->objectCount >= MAX_OBJECTS )
+			Tokenizer tokenizer;
+
+			tokInit( &tokenizer, chunks[i].deferred[j], end - chunks[i].deferred[j] );
+			tokNextLine( &tokenizer );
+
+			if( !sceParseCommand( scene, &tokenizer ) )
 			{
-				fprintf( stderr, "sceLoad: Foi ultrapassado o limite de definicoes de objetos na cena. Ignorando." );
-				continue;
+				size_t length;
+				const char *line = tokGetLine( &tokenizer, &length );
+
+				printf( "sceLoad: Ignorando comando:\n %.*s\n", (int)length, line );
 			}
+		}
+	}
 
-			scene->objects[scene->objectCount++] = objCreateSphere( material, pos1, radius );
-		} 
-		else if( sscanf( buffer, "TRIANGLE %d %lf %lf %lf %lf %lf %lf %lf %lf %lf %lf %lf %lf %lf %lf %lf %lf\n", &material, &pos1.x, &pos1.y, &pos1.z, &pos2.x, &pos2.y, &pos2.z, &pos3.x, &pos3.y, &pos3.z, &tex1.x, &tex1.y, &tex2.x, &tex2.y, &tex3.x, &tex3.y) == 16 ) 
+	/* Objetos, concatenados na ordem dos trechos */
+	if( !sceReserve( (void **)&scene->objects, &scene->objectCapacity, scene->objectCount + objectTotal, sizeof(Object) ) )
+	{
+		fprintf( stderr, "sceLoad: Memoria insuficiente para os objetos da cena. Ignorando." );
+	}
+
+	for( i = 0; i < threadCount; ++i )
+	{
+		for( j = 0; j < chunks[i].objectCount; ++j )
 		{
-			if( scene->objectCount >= MAX_OBJECTS )
+			if( scene->objectCount < scene->objectCapacity )
+			{
+				scene->objects[scene->objectCount++] = chunks[i].objects[j];
+			}
+			else
 			{
-				fprintf( stderr, "sceLoad: Foi ultrapassado o limite de definicoes de objetos na cena. Ignorando." );
-				continue;
+				objDestroy( chunks[i].objects[j] );
 			}
-			
-			scene->objects[scene->objectCount++] = objCreateTriangle( material, pos1, pos2, pos3, tex1, tex2, tex3 );
 		}
-	  	else if( sscanf( buffer, "BOX %d %lf %lf %lf %lf %lf %lf\n", &material, &pos1.x, &pos1.y, &pos1.z, &pos2.x, &pos2.y, &pos2.z ) == 7 ) 
+
+		free( chunks[i].objects );
+		free( (void *)chunks[i].deferred );
+	}
+
+	free( chunks );
+	free( threads );
+
+	return 1;
+}
+
+static void sceParseChunk( void *data )
+{
+	SceneChunk *chunk = (SceneChunk *)data;
+	Tokenizer *tokenizer = &chunk->tokenizer;
+
+	while( tokNextLine( tokenizer ) )
+	{
+		SceneCommand command = sceGetCommand( tokenizer );
+		Object object = NULL;
+
+		if( command == COMMAND_SPHERE || command == COMMAND_TRIANGLE || command == COMMAND_BOX )
+		{
+			object = sceParseObject( command, tokenizer );
+		}
+
+		if( object )
 		{
-			if( scene->objectCount >= MAX_OBJECTS )
+			if( sceReserve( (void **)&chunk->objects, &chunk->objectCapacity, chunk->objectCount + 1, sizeof(Object) ) )
 			{
-				fprintf( stderr, "sceLoad: Foi ultrapassado o limite de definicoes de objetos na cena. Ignorando." );
-				continue;
+				chunk->objects[chunk->objectCount++] = object;
 			}
-
-			scene->objects[scene->objectCount++] = objCreateBox( material, pos1, pos2 );
-		} 
+			else
+			{
+				objDestroy( object );
+				fprintf( stderr, "sceLoad: Memoria insuficiente para os objetos da cena. Ignorando." );
+			}
+		}
 		else
-		{			
-			printf( "sceLoad: Ignorando comando:\n %s\n", buffer );
+		{
+			/* Demais comandos (e linhas invlidas) so interpretados depois, em ordem */
+			size_t length;
+
+			if( sceReserve( (void **)&chunk->deferred, &chunk->deferredCapacity, chunk->deferredCount + 1, sizeof(const char *) ) )
+			{
+				chunk->deferred[chunk->deferredCount++] = tokGetLine( tokenizer, &length );
+			}
+			else
+			{
+				fprintf( stderr, "sceLoad: Memoria insuficiente para os comandos da cena. Ignorando." );
+			}
 		}
 	}
+}
 
-	/* Adjust background image to screen size */
-	if( scene->camera && scene->bgImage )
+static void sceCheckMaterials( Scene scene )
+{
+	int count = 0;
+	int i;
+
+	for( i = 0; i < scene->objectCount; ++i )
 	{
-		scene->bgImage = imageResize( scene->bgImage, camGetScreenWidth( scene->camera ),
-			camGetScreenHeight( scene->camera ) );
-	}
+		Object object = scene->objects[i];
+		int material = objGetMaterial( object );
 
-	fclose( file );
+		if( material < scene->materialCount )
+		{
+			scene->objects[count++] = object;
+		}
+		else
+		{
+			printf( "sceLoad: Ignorando objeto com material inexistente (%d).\n", material );
+			objDestroy( object );
+		}
+	}
 
-	return scene;
+	scene->objectCount = count;
 }
 
-
-int sceGetMaterialCount( Scene scene )
+static int sceAddObject( Scene scene, Object object )
 {
-	return scene->materialCount;
+	if( !sceReserve( (void **)&scene->objects, &scene->objectCapacity, scene->objectCount + 1, sizeof(Object) ) )
+	{
+		objDestroy( object );
+		fprintf( stderr, "sceLoad: Memoria insuficiente para os objetos da cena. Ignorando." );
+		return 1;
+	}
+
+	scene->objects[scene->objectCount++] = object;
+	return 1;
 }
 
-Material sceGetMaterial( Scene scene, int index )
+static void sceCountCommands( Tokenizer tokenizer, int *materialCount, int *lightCount, int *objectCount )
 {
-	return scene->materials[index];
+	*materialCount = 0;
+	*lightCount = 0;
+	*objectCount = 0;
+
+	while( tokNextLine( &tokenizer ) )
+	{
+		switch( sceGetCommand( &tokenizer ) )
+		{
+		case COMMAND_MATERIAL:
+			++*materialCount;
+			break;
+		case COMMAND_LIGHT:
+			++*lightCount;
+			break;
+		case COMMAND_SPHERE:
+		case COMMAND_TRIANGLE:
+		case COMMAND_BOX:
+			++*objectCount;
+			break;
+		default:
+			break;
+		}
+	}
 }
 
-void sceDestroy( Scene scene )
+static int sceReserve( void **array, int *capacity, int required, size_t size )
 {
-	int i;
+	int newCapacity;
+	void *newArray;
 
-	camDestroy( scene->camera );
-	imageDestroy( scene->bgImage );
+	if( required <= *capacity )
+	{
+		return 1;
+	}
 
-	for( i = 0; i < scene->objectCount; ++i )
+	newCapacity = ( *capacity > 0 ) ? *capacity : 16;
+	while( newCapacity < required )
 	{
-		objDestroy( scene->objects[i] );
+		newCapacity *= 2;
 	}
 
-	for( i = 0; i < scene->materialCount; ++i )
+	newArray = realloc( *array, newCapacity * size );
+	if( !newArray )
 	{
-		matDestroy( scene->materials[i] );
+		return 0;
 	}
-	
-	free( scene );
+
+	*array = newArray;
+	*capacity = newCapacity;
+
+	return 1;
+}
+
+static Color sceColor( double red, double green, double blue )
+{
+	Color color;
+
+	color.red = (VectorReal)red;
+	color.green = (VectorReal)green;
+	color.blue = (VectorReal)blue;
+
+	return color;
 }
 
@@ -20,14 +20,13 @@
 #include "camera.h"
 #include "object.h"
 #include "material.h"
+#include "bvh.h"
+#include "mapping.h"
 
 
 /************************************************************************/
 /* Constantes Exportadas                                                */
 /************************************************************************/
-#define MAX_MATERIALS	64
-#define MAX_OBJECTS		128
-#define MAX_LIGHTS		8
 #define FILENAME_MAXLEN	64
 
 #ifndef EPSILON
@@ -60,33 +59,67 @@ struct _Scene
      *  Imagem de fundo da cena
      */
 	Image bgImage;
+	/**
+     *  Arquivo da imagem de fundo ("null" se no houver), guardado para binSave()
+     */
+	char bgFileName[FILENAME_MAXLEN];
 
 	/**
      *  Nmero de materiais existentes na cena.
      */
 	int materialCount;
 	/**
-     *  Vetor com os materiais existentes na cena.
+     *  Capacidade alocada para o vetor de materiais.
+     */
+	int materialCapacity;
+	/**
+     *  Vetor crescente com os materiais existentes na cena.
+     */
+	Material *materials;
+	/**
+     *  Arquivo de textura de cada material ("null" se no houver), guardado para binSave().
      */
-	Material materials[MAX_MATERIALS];
+	char (*textureFileNames)[FILENAME_MAXLEN];
+	int textureFileNameCapacity;
 
 	/**
      *  Nmero de objetos existentes na cena.
      */
 	int objectCount;
 	/**
-     *  Vetor com os objetos existentes na cena.
+     *  Capacidade alocada para o vetor de objetos.
      */
-	Object objects[MAX_OBJECTS];
+	int objectCapacity;
+	/**
+     *  Vetor crescente com os objetos existentes na cena.
+     */
+	Object *objects;
 
 	/**
      *  Nmero de fontes de luz existentes na cena.
      */
 	int lightCount;
 	/**
-     *  Vetor com as fontes de luz existentes na cena.
+     *  Capacidade alocada para o vetor de fontes de luz.
+     */
+	int lightCapacity;
+	/**
+     *  Vetor crescente com as fontes de luz existentes na cena.
+     */
+	Light *lights;
+
+	/**
+     *  Hierarquia de volumes envolventes sobre os objetos da cena.
+     */
+	Bvh bvh;
+
+	/**
+     *  Cena compilada mapeada em memria (NULL se a cena foi lida de um arquivo rt4).
+     *  Neste caso a geometria dos objetos e a hierarquia apontam para o mapeamento,
+     *  e os structs de todos os objetos foram alocados em um nico bloco.
      */
-	Light lights[MAX_LIGHTS];
+	MappedFile mapping;
+	struct _Object *objectBlock;
 };
 
 typedef struct _Scene * Scene;
@@ -158,7 +191,23 @@ int sceGetLightCount( Scene scene );
 Light sceGetLight( Scene scene, int index );
 
 /**
- *	L uma cena a partir de um arquivo em formato rt4.
+ *	Obtm a hierarquia de volumes envolventes construda sobre os objetos de uma cena.
+ *
+ *	@param scene Handle para uma cena.
+ *
+ *	@return Hierarquia da cena (NULL se no foi possvel constru-la).
+ */
+Bvh sceGetBvh( Scene scene );
+
+/**
+ *	L uma cena a partir de um arquivo em formato rt4, ou de uma cena compilada
+ *	(veja binary.h), que  reconhecida pelo contedo e mapeada em memria.
+ *
+ *	Alm das luzes pontuais do formato rt4, so aceitas luzes de rea, com o
+ *	nmero de amostras opcional (LIGHT_DEFAULT_SAMPLES se omitido):
+ *		LIGHT x y z r g b SPHERE raio [amostras]
+ *		LIGHT x y z r g b QUAD ux uy uz vx vy vz [amostras]
+ *	onde (x,y,z)  o centro da esfera ou um canto do retngulo de lados u e v.
  *
  *	@param filename nome do arquivo que contm a cena.
  *
@@ -0,0 +1,204 @@
+/**
+ *	@file screen.c Screen: exibio de uma imagem em um canvas OpenGL por meio de uma
+ *		textura.
+ *
+ *	@date
+ *			Criado em:			17 de Outubro de 2026
+ *
+ *	@version 2.0
+ */
+
+#include <stdlib.h>
+
+#include <windows.h>                /* inclui as definicoes do windows para o OpenGL */
+#include <gl/gl.h>
+
+#include "screen.h"
+
+
+/************************************************************************/
+/* Tipos Privados                                                       */
+/************************************************************************/
+struct _Screen
+{
+	/**
+	 *  Imagem exibida e suas dimenses.
+	 */
+	Image image;
+	int width;
+	int height;
+
+	/**
+	 *  Textura (zero se no pde ser criada) e suas dimenses: as menores potncias
+	 *  de 2 que contm a imagem, que ocupa o canto inferior esquerdo.
+	 */
+	GLuint texture;
+	int textureWidth;
+	int textureHeight;
+};
+
+
+/************************************************************************/
+/* Funes Privadas                                                     */
+/************************************************************************/
+/**
+ *	Limita um retngulo  imagem.
+ *
+ *	@return Zero se no sobra nenhum pixel.
+ */
+static int scrClip( Screen screen, int *x, int *y, int *width, int *height );
+
+
+/************************************************************************/
+/* Definio das Funes Exportadas                                     */
+/************************************************************************/
+Screen scrCreate( Image image )
+{
+	Screen screen = (Screen)malloc( sizeof(struct _Screen) );
+	GLint maximum;
+
+	if( screen == NULL )
+		return NULL;
+
+	screen->image = image;
+	imageGetDimensions( image, &screen->width, &screen->height );
+
+	/* Texturas de OpenGL 1.1 tm dimenses potncias de 2 */
+	for( screen->textureWidth = 1; screen->textureWidth < screen->width; screen->textureWidth *= 2 )
+		;
+	for( screen->textureHeight = 1; screen->textureHeight < screen->height; screen->textureHeight *= 2 )
+		;
+
+	screen->texture = 0;
+	glGetIntegerv( GL_MAX_TEXTURE_SIZE, &maximum );
+	if( screen->textureWidth > maximum || screen->textureHeight > maximum )
+		return screen;
+
+	while( glGetError() != GL_NO_ERROR )
+		;
+
+	glPushAttrib( GL_TEXTURE_BIT );
+	glGenTextures( 1, &screen->texture );
+	glBindTexture( GL_TEXTURE_2D, screen->texture );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+	glTexImage2D( GL_TEXTURE_2D, 0, GL_RGB8, screen->textureWidth, screen->textureHeight, 0,
+				  GL_RGB, GL_UNSIGNED_BYTE, NULL );
+	glPopAttrib();
+
+	if( glGetError() != GL_NO_ERROR )
+	{
+		glDeleteTextures( 1, &screen->texture );
+		screen->texture = 0;
+	}
+
+	return screen;
+}
+
+void scrDestroy( Screen screen )
+{
+	if( screen == NULL )
+		return;
+
+	if( screen->texture != 0 )
+		glDeleteTextures( 1, &screen->texture );
+
+	free( screen );
+}
+
+void scrUpload( Screen screen, int x, int y, int width, int height )
+{
+	if( screen->texture == 0 || !scrClip( screen, &x, &y, &width, &height ) )
+		return;
+
+	/* O retngulo  lido diretamente do buffer da imagem, sem cpia */
+	glPushClientAttrib( GL_CLIENT_PIXEL_STORE_BIT );
+	glPushAttrib( GL_TEXTURE_BIT );
+
+	glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+	glPixelStorei( GL_UNPACK_ROW_LENGTH, screen->width );
+	glPixelStorei( GL_UNPACK_SKIP_PIXELS, x );
+	glPixelStorei( GL_UNPACK_SKIP_ROWS, y );
+
+	glBindTexture( GL_TEXTURE_2D, screen->texture );
+	glTexSubImage2D( GL_TEXTURE_2D, 0, x, y, width, height, GL_RGB, GL_UNSIGNED_BYTE,
+					 screen->image->buf );
+
+	glPopAttrib();
+	glPopClientAttrib();
+}
+
+void scrDraw( Screen screen, int x, int y, int width, int height )
+{
+	double s0, t0, s1, t1;
+	int i, j;
+	Color rgb;
+
+	if( !scrClip( screen, &x, &y, &width, &height ) )
+		return;
+
+	glPushAttrib( GL_ENABLE_BIT | GL_TEXTURE_BIT | GL_CURRENT_BIT );
+	glDisable( GL_LIGHTING );
+	glDisable( GL_DEPTH_TEST );
+
+	/* Sem textura, ponto a ponto */
+	if( screen->texture == 0 )
+	{
+		glBegin( GL_POINTS );
+		for( j = y; j < y + height; ++j )
+		{
+			for( i = x; i < x + width; ++i )
+			{
+				rgb = imageGetPixel( screen->image, i, j );
+				glColor3f( (float)rgb.red, (float)rgb.green, (float)rgb.blue );
+				glVertex2i( i, j );
+			}
+		}
+		glEnd();
+
+		glPopAttrib();
+		return;
+	}
+
+	s0 = (double)x / screen->textureWidth;
+	s1 = (double)( x + width ) / screen->textureWidth;
+	t0 = (double)y / screen->textureHeight;
+	t1 = (double)( y + height ) / screen->textureHeight;
+
+	glEnable( GL_TEXTURE_2D );
+	glBindTexture( GL_TEXTURE_2D, screen->texture );
+	glTexEnvi( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE );
+
+	glBegin( GL_QUADS );
+	glTexCoord2d( s0, t0 ); glVertex2i( x, y );
+	glTexCoord2d( s1, t0 ); glVertex2i( x + width, y );
+	glTexCoord2d( s1, t1 ); glVertex2i( x + width, y + height );
+	glTexCoord2d( s0, t1 ); glVertex2i( x, y + height );
+	glEnd();
+
+	glPopAttrib();
+}
+
+
+/************************************************************************/
+/* Definio das Funes Privadas                                       */
+/************************************************************************/
+static int scrClip( Screen screen, int *x, int *y, int *width, int *height )
+{
+	if( *x < 0 )
+	{
+		*width += *x;
+		*x = 0;
+	}
+	if( *y < 0 )
+	{
+		*height += *y;
+		*y = 0;
+	}
+	if( *x + *width > screen->width )
+		*width = screen->width - *x;
+	if( *y + *height > screen->height )
+		*height = screen->height - *y;
+
+	return *width > 0 && *height > 0;
+}
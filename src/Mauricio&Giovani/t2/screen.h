@@ -0,0 +1,69 @@
+/**
+ *	@file screen.h Screen: exibio de uma imagem em um canvas OpenGL por meio de uma
+ *		textura. Os pixels alterados so enviados em retngulos, com glTexSubImage2D(),
+ *		e desenhados com um nico quadriltero texturizado, em vez de um glColor() e
+ *		um glVertex() por pixel.
+ *
+ *		Todas as funes exigem que o contexto OpenGL do canvas esteja corrente, e os
+ *		retngulos so dados em pixels da imagem: a projeo deve ser a ortogrfica em
+ *		[0,largura] x [0,altura] usada pelos canvas do programa.
+ *
+ *	@date
+ *			Criado em:			17 de Outubro de 2026
+ *
+ *	@version 2.0
+ */
+
+#ifndef _SCREEN_H_
+#define _SCREEN_H_
+
+#include "image.h"
+
+
+/************************************************************************/
+/* Tipos Exportados                                                     */
+/************************************************************************/
+typedef struct _Screen * Screen;
+
+
+/************************************************************************/
+/* Funes Exportadas                                                   */
+/************************************************************************/
+/**
+ *	Cria a textura que exibe uma imagem. Se a placa no aceitar uma textura do
+ *	tamanho da imagem, a tela desenha a imagem ponto a ponto.
+ *
+ *	@param image Imagem exibida. No  copiada: deve existir enquanto a tela existir.
+ *
+ *	@return Handle para a tela criada (NULL se no houver memria).
+ */
+Screen scrCreate( Image image );
+
+/**
+ *	Destri uma tela e a sua textura (mas no a imagem). Aceita NULL.
+ */
+void scrDestroy( Screen screen );
+
+/**
+ *	Envia  textura os pixels de um retngulo da imagem, depois que eles mudaram.
+ *	As partes fora da imagem so ignoradas.
+ *
+ *	@param x Coluna do canto inferior esquerdo do retngulo.
+ *	@param y Linha do canto inferior esquerdo do retngulo.
+ *	@param width Largura do retngulo, em pixels.
+ *	@param height Altura do retngulo, em pixels.
+ */
+void scrUpload( Screen screen, int x, int y, int width, int height );
+
+/**
+ *	Desenha um retngulo da imagem como ele foi enviado por scrUpload(). O estado
+ *	do OpenGL (texturas, iluminao, teste de profundidade)  restaurado ao final.
+ *
+ *	@param x Coluna do canto inferior esquerdo do retngulo.
+ *	@param y Linha do canto inferior esquerdo do retngulo.
+ *	@param width Largura do retngulo, em pixels.
+ *	@param height Altura do retngulo, em pixels.
+ */
+void scrDraw( Screen screen, int x, int y, int width, int height );
+
+#endif
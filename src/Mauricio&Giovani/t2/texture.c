@@ -0,0 +1,495 @@
+/**
+ *	@file texture.c Texture: texturas filtradas e cache de texturas compartilhadas.
+ *		Cada textura guarda a imagem original e uma cadeia de redues (mipmaps),
+ *		armazenadas em blocos de 4x4 texels contguos. Cada arquivo de imagem 
+ *		lido uma nica vez e compartilhado, com contagem de referncias.
+ *
+ *	@date
+ *			Criado em:			17 de Outubro de 2026
+ *
+ *	@version 2.0
+ */
+
+/* realpath()  POSIX; em -std=c89/c99 precisa ser pedida antes dos cabealhos */
+#ifndef _WIN32
+#define _XOPEN_SOURCE 500
+#endif
+
+#include "texture.h"
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+
+#ifdef _WIN32
+#define TEXTURE_PATH_MAXLEN		_MAX_PATH
+#define texComparePaths			_stricmp
+#else
+#ifndef PATH_MAX
+#define PATH_MAX				4096
+#endif
+#define TEXTURE_PATH_MAXLEN		PATH_MAX
+#define texComparePaths			strcmp
+#endif
+
+
+/************************************************************************/
+/* Constantes Privadas                                                  */
+/************************************************************************/
+/** Lado dos blocos de texels: 4x4 texels de 4 bytes ocupam 64 bytes */
+#define TEXTURE_TILE_SHIFT	2
+#define TEXTURE_TILE		( 1 << TEXTURE_TILE_SHIFT )
+
+/** Bytes por texel (vermelho, verde, azul e um byte de alinhamento) */
+#define TEXTURE_TEXEL_SIZE	4
+
+/** Nmero mximo de nveis: suficiente para imagens de at 65535 pixels de lado */
+#define TEXTURE_MAX_LEVELS	17
+
+
+/************************************************************************/
+/* Tipos Privados                                                       */
+/************************************************************************/
+/**
+ *   Um nvel da cadeia de mipmaps. Os texels so guardados bloco a bloco, com os
+ *   blocos em ordem de linhas; dentro de cada bloco, tambm em ordem de linhas.
+ */
+typedef struct
+{
+	int width;
+	int height;
+	/**
+	 *  Nmero de blocos por linha.
+	 */
+	int tilesX;
+	unsigned char *texels;
+}
+TextureLevel;
+
+struct _Texture
+{
+	/**
+	 *  Nvel 0  a imagem original; cada nvel seguinte tem metade do lado.
+	 */
+	TextureLevel levels[TEXTURE_MAX_LEVELS];
+	int levelCount;
+	/**
+	 *  Memria ocupada por todos os nveis.
+	 */
+	size_t bytes;
+};
+
+/**
+ *   Textura no cache.
+ */
+typedef struct _TextureEntry
+{
+	/**
+	 *  Caminho cannico do arquivo.
+	 */
+	char *path;
+	Texture texture;
+	int references;
+
+	struct _TextureEntry *next;
+}
+TextureEntry;
+
+
+/************************************************************************/
+/* Variveis Privadas                                                   */
+/************************************************************************/
+/** Lista das texturas no cache */
+static TextureEntry *texEntries = NULL;
+
+static int texCount = 0;
+static size_t texResidentBytes = 0;
+
+
+/************************************************************************/
+/* Funes Privadas                                                     */
+/************************************************************************/
+/**
+ *	Obtm o caminho absoluto de um arquivo, sem "." e "..". Se o sistema no
+ *	conseguir resolv-lo, o nome  usado como foi dado.
+ */
+static void texCanonicalPath( const char *filename, char *path, size_t size );
+
+/**
+ *	Cria uma textura a partir de uma imagem, construindo a cadeia de mipmaps. A
+ *	imagem no  mais necessria depois.
+ *
+ *	@return Textura criada (NULL se no houver memria).
+ */
+static Texture texCreate( Image image );
+
+/**
+ *	Destri uma textura criada com texCreate().
+ */
+static void texDestroy( Texture texture );
+
+/**
+ *	Aloca os blocos de um nvel com as dimenses especificadas.
+ *
+ *	@return Memria alocada, em bytes (zero se no houver memria).
+ */
+static size_t texCreateLevel( TextureLevel *level, int width, int height );
+
+/**
+ *	Obtm o endereo de um texel de um nvel.
+ */
+static unsigned char *texGetTexel( const TextureLevel *level, int x, int y );
+
+/**
+ *	Filtragem bilinear em um nvel, com repetio da textura nas bordas.
+ *
+ *	@param rgb [out]Cor obtida, com componentes entre 0 e 255.
+ */
+static void texBilinear( const TextureLevel *level, double u, double v, double rgb[3] );
+
+
+/************************************************************************/
+/* Definio das Funes Exportadas                                     */
+/************************************************************************/
+Texture texAcquire( const char *filename )
+{
+	char path[TEXTURE_PATH_MAXLEN];
+	TextureEntry *entry;
+	Texture texture;
+	Image image;
+
+	texCanonicalPath( filename, path, sizeof(path) );
+
+	for( entry = texEntries; entry; entry = entry->next )
+	{
+		if( texComparePaths( entry->path, path ) == 0 )
+		{
+			++entry->references;
+			return entry->texture;
+		}
+	}
+
+	image = imageLoad( (char *)filename );
+	if( !image )
+	{
+		return NULL;
+	}
+
+	texture = texCreate( image );
+	imageDestroy( image );
+	if( !texture )
+	{
+		return NULL;
+	}
+
+	/* Sem memria para o cache a textura ainda  usada; texRelease() a destri */
+	entry = (TextureEntry *)malloc( sizeof(TextureEntry) );
+	if( !entry )
+	{
+		return texture;
+	}
+
+	entry->path = (char *)malloc( strlen( path ) + 1 );
+	if( !entry->path )
+	{
+		free( entry );
+		return texture;
+	}
+
+	strcpy( entry->path, path );
+	entry->texture = texture;
+	entry->references = 1;
+	entry->next = texEntries;
+	texEntries = entry;
+
+	++texCount;
+	texResidentBytes += texture->bytes;
+
+	return texture;
+}
+
+void texRelease( Texture texture )
+{
+	TextureEntry **link;
+
+	if( !texture )
+	{
+		return;
+	}
+
+	for( link = &texEntries; *link; link = &(*link)->next )
+	{
+		TextureEntry *entry = *link;
+
+		if( entry->texture == texture )
+		{
+			if( --entry->references == 0 )
+			{
+				*link = entry->next;
+
+				--texCount;
+				texResidentBytes -= texture->bytes;
+
+				texDestroy( texture );
+				free( entry->path );
+				free( entry );
+			}
+			return;
+		}
+	}
+
+	/* Textura que no coube no cache */
+	texDestroy( texture );
+}
+
+Color texGetColor( Texture texture, double u, double v, double footprint )
+{
+	const TextureLevel *base = &texture->levels[0];
+	double rgb[3];
+	double lod = 0;
+	Color color;
+
+	/* Nvel de detalhe: log2 do nmero de texels da imagem original cobertos pela regio */
+	if( footprint > 0 )
+	{
+		lod = log( footprint * ( base->width > base->height ? base->width : base->height ) ) / log( 2.0 );
+	}
+
+	if( lod <= 0 || texture->levelCount == 1 )
+	{
+		texBilinear( base, u, v, rgb );
+	}
+	else if( lod >= texture->levelCount - 1 )
+	{
+		texBilinear( &texture->levels[texture->levelCount - 1], u, v, rgb );
+	}
+	else
+	{
+		/* Interpola entre os dois nveis mais prximos */
+		int level = (int)lod;
+		double weight = lod - level;
+		double coarse[3];
+
+		texBilinear( &texture->levels[level], u, v, rgb );
+		texBilinear( &texture->levels[level + 1], u, v, coarse );
+
+		rgb[0] += weight * ( coarse[0] - rgb[0] );
+		rgb[1] += weight * ( coarse[1] - rgb[1] );
+		rgb[2] += weight * ( coarse[2] - rgb[2] );
+	}
+
+	color.red = (VectorReal)( rgb[0] / 255. );
+	color.green = (VectorReal)( rgb[1] / 255. );
+	color.blue = (VectorReal)( rgb[2] / 255. );
+
+	return color;
+}
+
+void texGetDimensions( Texture texture, int *width, int *height )
+{
+	*width = texture->levels[0].width;
+	*height = texture->levels[0].height;
+}
+
+int texGetCount( void )
+{
+	return texCount;
+}
+
+size_t texGetResidentBytes( void )
+{
+	return texResidentBytes;
+}
+
+
+/************************************************************************/
+/* Definio das Funes Privadas                                       */
+/************************************************************************/
+static void texCanonicalPath( const char *filename, char *path, size_t size )
+{
+#ifdef _WIN32
+	if( _fullpath( path, filename, size ) )
+	{
+		return;
+	}
+#else
+	/* realpath() exige um buffer de PATH_MAX bytes */
+	if( size >= PATH_MAX && realpath( filename, path ) )
+	{
+		return;
+	}
+#endif
+
+	strncpy( path, filename, size - 1 );
+	path[size - 1] = '\0';
+}
+
+static Texture texCreate( Image image )
+{
+	Texture texture = (struct _Texture *)malloc( sizeof(struct _Texture) );
+	int width;
+	int height;
+	int level;
+	int x, y, k;
+
+	if( !texture )
+	{
+		return NULL;
+	}
+
+	imageGetDimensions( image, &width, &height );
+
+	texture->levelCount = 0;
+	texture->bytes = 0;
+
+	/* Nvel 0: cpia da imagem, reorganizada em blocos */
+	texture->bytes += texCreateLevel( &texture->levels[0], width, height );
+	if( !texture->levels[0].texels )
+	{
+		free( texture );
+		return NULL;
+	}
+	texture->levelCount = 1;
+
+	for( y = 0; y < height; ++y )
+	{
+		for( x = 0; x < width; ++x )
+		{
+			const unsigned char *pixel = image->buf + ( (size_t)y * width + x ) * 3;
+			unsigned char *texel = texGetTexel( &texture->levels[0], x, y );
+
+			texel[0] = pixel[0];
+			texel[1] = pixel[1];
+			texel[2] = pixel[2];
+			texel[3] = 0;
+		}
+	}
+
+	/* Cada nvel  a mdia de blocos de 2x2 texels do anterior, at chegar a 1x1 */
+	for( level = 1; level < TEXTURE_MAX_LEVELS && ( width > 1 || height > 1 ); ++level )
+	{
+		const TextureLevel *source = &texture->levels[level - 1];
+		TextureLevel *target = &texture->levels[level];
+
+		width = ( width > 1 ) ? width / 2 : 1;
+		height = ( height > 1 ) ? height / 2 : 1;
+
+		texture->bytes += texCreateLevel( target, width, height );
+		if( !target->texels )
+		{
+			/* Sem memria: a textura fica s com os nveis j construdos */
+			break;
+		}
+		texture->levelCount = level + 1;
+
+		for( y = 0; y < height; ++y )
+		{
+			int y0 = ( 2 * y < source->height ) ? 2 * y : source->height - 1;
+			int y1 = ( 2 * y + 1 < source->height ) ? 2 * y + 1 : source->height - 1;
+
+			for( x = 0; x < width; ++x )
+			{
+				int x0 = ( 2 * x < source->width ) ? 2 * x : source->width - 1;
+				int x1 = ( 2 * x + 1 < source->width ) ? 2 * x + 1 : source->width - 1;
+				const unsigned char *a = texGetTexel( source, x0, y0 );
+				const unsigned char *b = texGetTexel( source, x1, y0 );
+				const unsigned char *c = texGetTexel( source, x0, y1 );
+				const unsigned char *d = texGetTexel( source, x1, y1 );
+				unsigned char *texel = texGetTexel( target, x, y );
+
+				for( k = 0; k < 3; ++k )
+				{
+					texel[k] = (unsigned char)( ( a[k] + b[k] + c[k] + d[k] + 2 ) / 4 );
+				}
+				texel[3] = 0;
+			}
+		}
+	}
+
+	return texture;
+}
+
+static void texDestroy( Texture texture )
+{
+	int i;
+
+	for( i = 0; i < texture->levelCount; ++i )
+	{
+		free( texture->levels[i].texels );
+	}
+
+	free( texture );
+}
+
+static size_t texCreateLevel( TextureLevel *level, int width, int height )
+{
+	int tilesY = ( height + TEXTURE_TILE - 1 ) >> TEXTURE_TILE_SHIFT;
+	size_t bytes;
+
+	level->width = width;
+	level->height = height;
+	level->tilesX = ( width + TEXTURE_TILE - 1 ) >> TEXTURE_TILE_SHIFT;
+
+	bytes = (size_t)level->tilesX * tilesY * TEXTURE_TILE * TEXTURE_TILE * TEXTURE_TEXEL_SIZE;
+	level->texels = (unsigned char *)calloc( bytes, 1 );
+
+	return level->texels ? bytes : 0;
+}
+
+static unsigned char *texGetTexel( const TextureLevel *level, int x, int y )
+{
+	size_t tile = (size_t)( y >> TEXTURE_TILE_SHIFT ) * level->tilesX + ( x >> TEXTURE_TILE_SHIFT );
+	int inside = ( ( y & ( TEXTURE_TILE - 1 ) ) << TEXTURE_TILE_SHIFT ) + ( x & ( TEXTURE_TILE - 1 ) );
+
+	return level->texels + ( ( tile << ( 2 * TEXTURE_TILE_SHIFT ) ) + inside ) * TEXTURE_TEXEL_SIZE;
+}
+
+static void texBilinear( const TextureLevel *level, double u, double v, double rgb[3] )
+{
+	/* Centro dos texels em coordenadas inteiras; fmod() evita estouro em coordenadas grandes */
+	double s = fmod( u * level->width - 0.5, (double)level->width );
+	double t = fmod( v * level->height - 0.5, (double)level->height );
+	double ws, wt;
+	int x0, y0, x1, y1, k;
+	const unsigned char *a, *b, *c, *d;
+
+	if( s < 0 )
+	{
+		s += level->width;
+	}
+	if( t < 0 )
+	{
+		t += level->height;
+	}
+
+	x0 = (int)s;
+	y0 = (int)t;
+	ws = s - x0;
+	wt = t - y0;
+
+	/* Arredondamentos de fmod() podem levar exatamente ao lado da imagem */
+	if( x0 >= level->width )
+	{
+		x0 = level->width - 1;
+	}
+	if( y0 >= level->height )
+	{
+		y0 = level->height - 1;
+	}
+
+	x1 = ( x0 + 1 < level->width ) ? x0 + 1 : 0;
+	y1 = ( y0 + 1 < level->height ) ? y0 + 1 : 0;
+
+	a = texGetTexel( level, x0, y0 );
+	b = texGetTexel( level, x1, y0 );
+	c = texGetTexel( level, x0, y1 );
+	d = texGetTexel( level, x1, y1 );
+
+	for( k = 0; k < 3; ++k )
+	{
+		double top = a[k] + ws * ( b[k] - a[k] );
+		double bottom = c[k] + ws * ( d[k] - c[k] );
+
+		rgb[k] = top + wt * ( bottom - top );
+	}
+}
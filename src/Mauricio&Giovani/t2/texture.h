@@ -0,0 +1,84 @@
+/**
+ *	@file texture.h Texture: texturas filtradas e cache de texturas compartilhadas.
+ *		Cada textura guarda a imagem original e uma cadeia de redues (mipmaps),
+ *		armazenadas em blocos de 4x4 texels contguos, de modo que os texels
+ *		vizinhos usados por uma consulta ficam na mesma linha de cache. As
+ *		consultas so trilineares, com o nvel de detalhe escolhido pela rea da
+ *		textura vista pelo raio.
+ *
+ *		Cada arquivo de imagem  lido uma nica vez, identificado pelo seu caminho
+ *		cannico, e a mesma textura  entregue a todos os materiais que o usam, com
+ *		contagem de referncias. texAcquire() e texRelease() devem ser chamadas por
+ *		uma thread de cada vez (a leitura e a destruio de cenas); texGetColor()
+ *		pode ser chamada por vrias threads durante a renderizao.
+ *
+ *	@date
+ *			Criado em:			17 de Outubro de 2026
+ *
+ *	@version 2.0
+ */
+
+#ifndef _TEXTURE_H_
+#define _TEXTURE_H_
+
+#include <stddef.h>
+#include "image.h"
+#include "color.h"
+
+
+/************************************************************************/
+/* Tipos Exportados                                                     */
+/************************************************************************/
+typedef struct _Texture * Texture;
+
+
+/************************************************************************/
+/* Funes Exportadas                                                   */
+/************************************************************************/
+/**
+ *	Obtm a textura de um arquivo, lendo-o apenas se ele ainda no estiver no cache.
+ *	Cada chamada acrescenta uma referncia, que deve ser liberada com texRelease().
+ *
+ *	@param filename Nome do arquivo (caminhos diferentes para o mesmo arquivo
+ *					compartilham a mesma textura).
+ *
+ *	@return Textura compartilhada (NULL se o arquivo no pde ser lido).
+ */
+Texture texAcquire( const char *filename );
+
+/**
+ *	Libera uma referncia obtida com texAcquire(). A textura  destruda quando a
+ *	ltima referncia  liberada. Aceita NULL.
+ */
+void texRelease( Texture texture );
+
+/**
+ *	Obtm a cor filtrada de uma textura. A textura se repete fora de [0,1].
+ *
+ *	@param texture Handle para a textura.
+ *	@param u Coordenada horizontal de textura.
+ *	@param v Coordenada vertical de textura.
+ *	@param footprint Largura da regio vista, nas mesmas unidades de (u,v). Zero
+ *					usa apenas a imagem original (filtragem bilinear).
+ *
+ *	@return Cor, com componentes entre 0 e 1.
+ */
+Color texGetColor( Texture texture, double u, double v, double footprint );
+
+/**
+ *	Obtm as dimenses da imagem original de uma textura.
+ */
+void texGetDimensions( Texture texture, int *width, int *height );
+
+/**
+ *	Obtm o nmero de texturas distintas no cache.
+ */
+int texGetCount( void );
+
+/**
+ *	Obtm a memria ocupada pelos texels das texturas no cache (incluindo os
+ *	mipmaps), em bytes.
+ */
+size_t texGetResidentBytes( void );
+
+#endif
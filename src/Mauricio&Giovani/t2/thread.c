@@ -0,0 +1,246 @@
+/**
+ *	@file thread.c Thread: primitivas portveis de concorrncia (threads, mutexes e
+ *		operaes atmicas), implementadas sobre a API Win32 ou sobre pthreads.
+ *
+ *	@date
+ *			Criado em:			17 de Outubro de 2026
+ *
+ *	@version 2.0
+ */
+
+/* clock_gettime()  POSIX; em -std=c89/c99 precisa ser pedida antes dos cabealhos */
+#ifndef _WIN32
+#define _XOPEN_SOURCE 600
+#endif
+
+#include "thread.h"
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+
+/************************************************************************/
+/* Tipos Privados                                                       */
+/************************************************************************/
+struct _Thread
+{
+	/**
+	 *  Funo executada pela thread e seu parmetro.
+	 */
+	ThreadFunction function;
+	void *data;
+
+	/**
+	 *  Handle do sistema.
+	 */
+#ifdef _WIN32
+	HANDLE handle;
+#else
+	pthread_t handle;
+#endif
+};
+
+struct _Mutex
+{
+#ifdef _WIN32
+	CRITICAL_SECTION section;
+#else
+	pthread_mutex_t mutex;
+#endif
+};
+
+
+/************************************************************************/
+/* Funes Privadas                                                     */
+/************************************************************************/
+/**
+ *	Ponto de entrada comum das threads: adapta a assinatura do sistema a ThreadFunction.
+ */
+#ifdef _WIN32
+static DWORD WINAPI thrEntry( LPVOID parameter );
+#else
+static void *thrEntry( void *parameter );
+#endif
+
+
+/************************************************************************/
+/* Definio das Funes Exportadas                                     */
+/************************************************************************/
+int thrGetProcessorCount( void )
+{
+	long count;
+
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo( &info );
+	count = (long)info.dwNumberOfProcessors;
+#else
+	count = sysconf( _SC_NPROCESSORS_ONLN );
+#endif
+
+	return ( count > 0 ) ? (int)count : 1;
+}
+
+Thread thrCreate( ThreadFunction function, void *data )
+{
+	Thread thread = (struct _Thread *)malloc( sizeof(struct _Thread) );
+	if( !thread )
+		return NULL;
+
+	thread->function = function;
+	thread->data = data;
+
+#ifdef _WIN32
+	thread->handle = CreateThread( NULL, 0, thrEntry, thread, 0, NULL );
+	if( !thread->handle )
+	{
+		free( thread );
+		return NULL;
+	}
+#else
+	if( pthread_create( &thread->handle, NULL, thrEntry, thread ) != 0 )
+	{
+		free( thread );
+		return NULL;
+	}
+#endif
+
+	return thread;
+}
+
+void thrJoin( Thread thread )
+{
+#ifdef _WIN32
+	WaitForSingleObject( thread->handle, INFINITE );
+	CloseHandle( thread->handle );
+#else
+	pthread_join( thread->handle, NULL );
+#endif
+
+	free( thread );
+}
+
+Mutex thrCreateMutex( void )
+{
+	Mutex mutex = (struct _Mutex *)malloc( sizeof(struct _Mutex) );
+	if( !mutex )
+		return NULL;
+
+#ifdef _WIN32
+	InitializeCriticalSection( &mutex->section );
+#else
+	pthread_mutex_init( &mutex->mutex, NULL );
+#endif
+
+	return mutex;
+}
+
+void thrLock( Mutex mutex )
+{
+#ifdef _WIN32
+	EnterCriticalSection( &mutex->section );
+#else
+	pthread_mutex_lock( &mutex->mutex );
+#endif
+}
+
+void thrUnlock( Mutex mutex )
+{
+#ifdef _WIN32
+	LeaveCriticalSection( &mutex->section );
+#else
+	pthread_mutex_unlock( &mutex->mutex );
+#endif
+}
+
+void thrDestroyMutex( Mutex mutex )
+{
+#ifdef _WIN32
+	DeleteCriticalSection( &mutex->section );
+#else
+	pthread_mutex_destroy( &mutex->mutex );
+#endif
+
+	free( mutex );
+}
+
+long thrAtomicIncrement( volatile long *value )
+{
+#ifdef _WIN32
+	return InterlockedIncrement( (LONG *)value );
+#else
+	return __sync_add_and_fetch( value, 1 );
+#endif
+}
+
+long thrAtomicAdd( volatile long *value, long amount )
+{
+#ifdef _WIN32
+	return InterlockedExchangeAdd( (LONG *)value, amount ) + amount;
+#else
+	return __sync_add_and_fetch( value, amount );
+#endif
+}
+
+long thrAtomicCompareExchange( volatile long *value, long expected, long desired )
+{
+#ifdef _WIN32
+	return InterlockedCompareExchange( (LONG volatile *)value, desired, expected );
+#else
+	return __sync_val_compare_and_swap( value, expected, desired );
+#endif
+}
+
+void thrYield( void )
+{
+#ifdef _WIN32
+	Sleep( 0 );
+#else
+	sched_yield();
+#endif
+}
+
+unsigned long thrGetMilliseconds( void )
+{
+#ifdef _WIN32
+	LARGE_INTEGER frequency, counter;
+
+	QueryPerformanceFrequency( &frequency );
+	QueryPerformanceCounter( &counter );
+
+	return (unsigned long)( counter.QuadPart / ( frequency.QuadPart / 1000 ) );
+#else
+	struct timespec now;
+
+	clock_gettime( CLOCK_MONOTONIC, &now );
+
+	return (unsigned long)now.tv_sec * 1000UL + (unsigned long)( now.tv_nsec / 1000000L );
+#endif
+}
+
+
+/************************************************************************/
+/* Definio das Funes Privadas                                       */
+/************************************************************************/
+#ifdef _WIN32
+static DWORD WINAPI thrEntry( LPVOID parameter )
+{
+	Thread thread = (Thread)parameter;
+	thread->function( thread->data );
+	return 0;
+}
+#else
+static void *thrEntry( void *parameter )
+{
+	Thread thread = (Thread)parameter;
+	thread->function( thread->data );
+	return NULL;
+}
+#endif
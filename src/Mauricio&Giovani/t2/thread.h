@@ -0,0 +1,131 @@
+/**
+ *	@file thread.h Thread: primitivas portveis de concorrncia (threads, mutexes e
+ *		operaes atmicas), implementadas sobre a API Win32 ou sobre pthreads.
+ *
+ *	@date
+ *			Criado em:			17 de Outubro de 2026
+ *
+ *	@version 2.0
+ */
+
+#ifndef _THREAD_H_
+#define _THREAD_H_
+
+
+/************************************************************************/
+/* Constantes Exportadas                                                */
+/************************************************************************/
+/**
+ *   Qualificador de variveis estticas com uma cpia por thread. Em compiladores
+ *   sem suporte a varivel fica compartilhada; s deve guardar dados para os quais
+ *   isso  inofensivo (estatsticas, caches que so conferidos antes do uso).
+ */
+#if defined( _MSC_VER )
+#define THREAD_LOCAL	__declspec( thread )
+#elif defined( __GNUC__ )
+#define THREAD_LOCAL	__thread
+#else
+#define THREAD_LOCAL
+#endif
+
+
+/************************************************************************/
+/* Tipos Exportados                                                     */
+/************************************************************************/
+/**
+ *   Funo executada por uma thread.
+ */
+typedef void (*ThreadFunction)( void *data );
+
+typedef struct _Thread * Thread;
+
+typedef struct _Mutex * Mutex;
+
+
+/************************************************************************/
+/* Funes Exportadas                                                   */
+/************************************************************************/
+/**
+ *	Obtm o nmero de processadores disponveis na mquina.
+ *
+ *	@return Nmero de processadores (pelo menos 1).
+ */
+int thrGetProcessorCount( void );
+
+/**
+ *	Cria e inicia uma thread.
+ *
+ *	@param function Funo executada pela thread.
+ *	@param data Parmetro repassado  funo.
+ *
+ *	@return Handle para a thread criada (NULL em caso de falha).
+ */
+Thread thrCreate( ThreadFunction function, void *data );
+
+/**
+ *	Espera o trmino de uma thread criada com thrCreate() e a destri.
+ */
+void thrJoin( Thread thread );
+
+/**
+ *	Cria um mutex.
+ *
+ *	@return Handle para o mutex criado (NULL em caso de falha).
+ */
+Mutex thrCreateMutex( void );
+
+/**
+ *	Obtm o mutex, bloqueando a thread corrente at que ele esteja livre.
+ */
+void thrLock( Mutex mutex );
+
+/**
+ *	Libera um mutex obtido com thrLock().
+ */
+void thrUnlock( Mutex mutex );
+
+/**
+ *	Destri um mutex criado com thrCreateMutex().
+ */
+void thrDestroyMutex( Mutex mutex );
+
+/**
+ *	Incrementa atomicamente um contador compartilhado entre threads.
+ *
+ *	@return Valor do contador aps o incremento.
+ */
+long thrAtomicIncrement( volatile long *value );
+
+/**
+ *	Soma atomicamente um valor a um contador compartilhado entre threads.
+ *
+ *	@return Valor do contador aps a soma.
+ */
+long thrAtomicAdd( volatile long *value, long amount );
+
+/**
+ *	Troca atomicamente o valor de um contador compartilhado, se ele ainda for o
+ *	esperado. Tambm serve de barreira de memria: as escritas feitas antes pela
+ *	thread corrente ficam visveis s threads que lerem o novo valor.
+ *
+ *	@param expected Valor que o contador deve ter para ser trocado.
+ *	@param desired Novo valor.
+ *
+ *	@return Valor do contador antes da operao (igual a 'expected' se houve troca).
+ */
+long thrAtomicCompareExchange( volatile long *value, long expected, long desired );
+
+/**
+ *	Cede o restante da fatia de tempo da thread corrente a outras threads prontas.
+ */
+void thrYield( void );
+
+/**
+ *	Obtm o tempo real decorrido, em milissegundos, de um relgio que no volta
+ *	atrs. Ao contrrio de clock(), que soma o tempo de processador de todas as
+ *	threads, serve para medir renderizaes paralelas. O valor s tem sentido
+ *	como diferena entre duas chamadas (a subtrao sem sinal tolera a volta).
+ */
+unsigned long thrGetMilliseconds( void );
+
+#endif
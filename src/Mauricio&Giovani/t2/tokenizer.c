@@ -0,0 +1,316 @@
+/**
+ *	@file tokenizer.c Tokenizer: leitura de texto linha a linha e campo a campo, sem
+ *		cpias. O texto  percorrido diretamente na memria (tipicamente um arquivo
+ *		mapeado com mapOpen()), no precisa terminar em '\0' e as linhas no tm
+ *		tamanho mximo. Os nmeros so convertidos sem passar por sscanf().
+ *
+ *	@date
+ *			Criado em:			17 de Outubro de 2026
+ *
+ *	@version 2.0
+ */
+
+#include "tokenizer.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+/************************************************************************/
+/* Constantes Privadas                                                  */
+/************************************************************************/
+/** Algarismos significativos que cabem exatamente na mantissa de um double (< 2^53) */
+#define TOK_MAX_DIGITS		15
+
+/** Maior potncia de 10 representvel exatamente em double */
+#define TOK_MAX_EXPONENT	22
+
+/** Tamanho mximo de um nmero repassado a strtod() */
+#define TOK_NUMBER_MAXLEN	64
+
+static const double tokPowersOf10[TOK_MAX_EXPONENT + 1] =
+{
+	1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+
+/************************************************************************/
+/* Funes Privadas                                                     */
+/************************************************************************/
+#define tokIsDigit( c )		( (c) >= '0' && (c) <= '9' )
+#define tokIsLetter( c )	( ( (c) >= 'A' && (c) <= 'Z' ) || ( (c) >= 'a' && (c) <= 'z' ) )
+#define tokIsBlank( c )		( (c) == ' ' || (c) == '\t' || (c) == '\r' || (c) == '\v' || (c) == '\f' )
+
+/**
+ *	Pula os espaos antes do prximo campo da linha atual.
+ *
+ *	@return Incio do prximo campo (lineEnd se a linha terminou).
+ */
+static const char *tokSkipBlanks( Tokenizer *tokenizer );
+
+/**
+ *	Converte com strtod() o nmero que comea no prximo campo. Usada quando a
+ *	converso direta no  exata ou no reconhece a sintaxe (infinito, hexadecimal...).
+ */
+static int tokRealFallback( Tokenizer *tokenizer, double *value );
+
+
+/************************************************************************/
+/* Definio das Funes Exportadas                                     */
+/************************************************************************/
+void tokInit( Tokenizer *tokenizer, const char *text, size_t size )
+{
+	tokenizer->line = text;
+	tokenizer->lineEnd = text;
+	tokenizer->cursor = text;
+	tokenizer->next = text;
+	tokenizer->end = text + size;
+}
+
+int tokNextLine( Tokenizer *tokenizer )
+{
+	const char *lineEnd;
+
+	if( tokenizer->next >= tokenizer->end )
+	{
+		return 0;
+	}
+
+	lineEnd = (const char *)memchr( tokenizer->next, '\n', tokenizer->end - tokenizer->next );
+	if( !lineEnd )
+	{
+		lineEnd = tokenizer->end;
+	}
+
+	tokenizer->line = tokenizer->next;
+	tokenizer->lineEnd = lineEnd;
+	tokenizer->cursor = tokenizer->next;
+	tokenizer->next = ( lineEnd < tokenizer->end ) ? lineEnd + 1 : lineEnd;
+
+	return 1;
+}
+
+const char *tokGetLine( Tokenizer *tokenizer, size_t *length )
+{
+	const char *lineEnd = tokenizer->lineEnd;
+
+	/* Arquivos gravados no Windows terminam as linhas com "\r\n" */
+	if( lineEnd > tokenizer->line && lineEnd[-1] == '\r' )
+	{
+		--lineEnd;
+	}
+
+	*length = (size_t)( lineEnd - tokenizer->line );
+	return tokenizer->line;
+}
+
+const char *tokKeyword( Tokenizer *tokenizer, size_t *length )
+{
+	const char *start = tokSkipBlanks( tokenizer );
+	const char *p = start;
+
+	while( p < tokenizer->lineEnd && tokIsLetter( *p ) )
+	{
+		++p;
+	}
+
+	tokenizer->cursor = p;
+	*length = (size_t)( p - start );
+
+	return start;
+}
+
+int tokReal( Tokenizer *tokenizer, double *value )
+{
+	const char *p = tokSkipBlanks( tokenizer );
+	const char *end = tokenizer->lineEnd;
+	double mantissa = 0;
+	int negative = 0;
+	int digits = 0;
+	int significant = 0;
+	int exponent = 0;
+
+	if( p < end && ( *p == '+' || *p == '-' ) )
+	{
+		negative = ( *p == '-' );
+		++p;
+	}
+
+	/* Parte inteira e parte fracionria, acumuladas em uma nica mantissa */
+	for( ; p < end && tokIsDigit( *p ); ++p, ++digits )
+	{
+		if( significant > 0 || *p != '0' )
+		{
+			if( ++significant > TOK_MAX_DIGITS )
+			{
+				return tokRealFallback( tokenizer, value );
+			}
+			mantissa = mantissa * 10 + ( *p - '0' );
+		}
+	}
+
+	if( p < end && *p == '.' )
+	{
+		for( ++p; p < end && tokIsDigit( *p ); ++p, ++digits )
+		{
+			if( significant > 0 || *p != '0' )
+			{
+				if( ++significant > TOK_MAX_DIGITS )
+				{
+					return tokRealFallback( tokenizer, value );
+				}
+				mantissa = mantissa * 10 + ( *p - '0' );
+			}
+			--exponent;
+		}
+	}
+
+	/* Sem algarismos (ou "0x..."): pode ainda ser "inf", "nan" ou hexadecimal */
+	if( digits == 0 || ( p < end && ( *p == 'x' || *p == 'X' ) ) )
+	{
+		return tokRealFallback( tokenizer, value );
+	}
+
+	/* O expoente s  consumido se tiver ao menos um algarismo, como em strtod() */
+	if( p < end && ( *p == 'e' || *p == 'E' ) )
+	{
+		const char *q = p + 1;
+		int exponentNegative = 0;
+		int exponentValue = 0;
+
+		if( q < end && ( *q == '+' || *q == '-' ) )
+		{
+			exponentNegative = ( *q == '-' );
+			++q;
+		}
+
+		if( q < end && tokIsDigit( *q ) )
+		{
+			for( ; q < end && tokIsDigit( *q ); ++q )
+			{
+				if( exponentValue < 10000 )
+				{
+					exponentValue = exponentValue * 10 + ( *q - '0' );
+				}
+			}
+
+			exponent += exponentNegative ? -exponentValue : exponentValue;
+			p = q;
+		}
+	}
+
+	/* Mantissa e potncia de 10 exatas: um nico arredondamento, como em strtod() */
+	if( exponent < -TOK_MAX_EXPONENT || exponent > TOK_MAX_EXPONENT )
+	{
+		return tokRealFallback( tokenizer, value );
+	}
+
+	if( exponent < 0 )
+	{
+		mantissa /= tokPowersOf10[-exponent];
+	}
+	else
+	{
+		mantissa *= tokPowersOf10[exponent];
+	}
+
+	*value = negative ? -mantissa : mantissa;
+	tokenizer->cursor = p;
+
+	return 1;
+}
+
+int tokInt( Tokenizer *tokenizer, int *value )
+{
+	const char *p = tokSkipBlanks( tokenizer );
+	const char *end = tokenizer->lineEnd;
+	long result = 0;
+	int negative = 0;
+
+	if( p < end && ( *p == '+' || *p == '-' ) )
+	{
+		negative = ( *p == '-' );
+		++p;
+	}
+
+	if( p >= end || !tokIsDigit( *p ) )
+	{
+		return 0;
+	}
+
+	for( ; p < end && tokIsDigit( *p ); ++p )
+	{
+		result = result * 10 + ( *p - '0' );
+	}
+
+	*value = (int)( negative ? -result : result );
+	tokenizer->cursor = p;
+
+	return 1;
+}
+
+int tokString( Tokenizer *tokenizer, char *buffer, size_t size )
+{
+	const char *p = tokSkipBlanks( tokenizer );
+	size_t length = 0;
+
+	if( p >= tokenizer->lineEnd )
+	{
+		return 0;
+	}
+
+	for( ; p < tokenizer->lineEnd && !tokIsBlank( *p ); ++p )
+	{
+		if( length + 1 < size )
+		{
+			buffer[length++] = *p;
+		}
+	}
+
+	buffer[length] = '\0';
+	tokenizer->cursor = p;
+
+	return 1;
+}
+
+
+/************************************************************************/
+/* Definio das Funes Privadas                                       */
+/************************************************************************/
+static const char *tokSkipBlanks( Tokenizer *tokenizer )
+{
+	const char *p = tokenizer->cursor;
+
+	while( p < tokenizer->lineEnd && tokIsBlank( *p ) )
+	{
+		++p;
+	}
+
+	tokenizer->cursor = p;
+	return p;
+}
+
+static int tokRealFallback( Tokenizer *tokenizer, double *value )
+{
+	char number[TOK_NUMBER_MAXLEN];
+	const char *p = tokSkipBlanks( tokenizer );
+	char *numberEnd;
+	size_t length = 0;
+
+	/* O texto no termina em '\0': copia o campo para poder usar strtod() */
+	while( p + length < tokenizer->lineEnd && !tokIsBlank( p[length] ) && length + 1 < sizeof(number) )
+	{
+		number[length] = p[length];
+		++length;
+	}
+	number[length] = '\0';
+
+	*value = strtod( number, &numberEnd );
+	if( numberEnd == number )
+	{
+		return 0;
+	}
+
+	tokenizer->cursor = p + ( numberEnd - number );
+	return 1;
+}
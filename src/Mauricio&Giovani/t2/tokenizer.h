@@ -0,0 +1,110 @@
+/**
+ *	@file tokenizer.h Tokenizer: leitura de texto linha a linha e campo a campo, sem
+ *		cpias. O texto  percorrido diretamente na memria (tipicamente um arquivo
+ *		mapeado com mapOpen()), no precisa terminar em '\0' e as linhas no tm
+ *		tamanho mximo. Os nmeros so convertidos sem passar por sscanf().
+ *
+ *	@date
+ *			Criado em:			17 de Outubro de 2026
+ *
+ *	@version 2.0
+ */
+
+#ifndef _TOKENIZER_H_
+#define _TOKENIZER_H_
+
+#include <stddef.h>
+
+
+/************************************************************************/
+/* Tipos Exportados                                                     */
+/************************************************************************/
+/**
+ *   Posio da leitura em um texto.  um valor comum, que pode ser declarado na
+ *   pilha e copiado; s deve ser alterado pelas funes abaixo.
+ */
+typedef struct
+{
+	/**
+	 *  Linha atual: incio, fim (o '\n' ou o fim do texto) e prximo campo.
+	 */
+	const char *line;
+	const char *lineEnd;
+	const char *cursor;
+	/**
+	 *  Incio da prxima linha e fim do texto.
+	 */
+	const char *next;
+	const char *end;
+}
+Tokenizer;
+
+
+/************************************************************************/
+/* Funes Exportadas                                                   */
+/************************************************************************/
+/**
+ *	Prepara a leitura de um texto. Nenhuma linha fica selecionada at a primeira
+ *	chamada de tokNextLine().
+ *
+ *	@param tokenizer [out]Estado da leitura.
+ *	@param text Incio do texto.
+ *	@param size Tamanho do texto, em bytes.
+ */
+void tokInit( Tokenizer *tokenizer, const char *text, size_t size );
+
+/**
+ *	Avana para a prxima linha do texto.
+ *
+ *	@return Zero se o texto terminou e no-zero caso contrrio.
+ */
+int tokNextLine( Tokenizer *tokenizer );
+
+/**
+ *	Obtm a linha atual inteira, sem o '\n' (por exemplo, para mensagens de erro).
+ *
+ *	@param length [out]Tamanho da linha.
+ *
+ *	@return Incio da linha (no termina em '\0').
+ */
+const char *tokGetLine( Tokenizer *tokenizer, size_t *length );
+
+/**
+ *	L uma palavra-chave: a seqncia de letras no incio do prximo campo.
+ *
+ *	@param length [out]Nmero de letras lidas (zero se o campo no comea com letra).
+ *
+ *	@return Incio da palavra (no termina em '\0').
+ */
+const char *tokKeyword( Tokenizer *tokenizer, size_t *length );
+
+/**
+ *	L um nmero real, com a mesma sintaxe de "%lf" em sscanf(). Nmeros com at
+ *	15 algarismos significativos e expoente pequeno so convertidos diretamente,
+ *	com o mesmo resultado (exato) de strtod(); os demais so repassados a strtod().
+ *
+ *	@param value [out]Valor lido.
+ *
+ *	@return Zero se o prximo campo no  um nmero (a posio no muda).
+ */
+int tokReal( Tokenizer *tokenizer, double *value );
+
+/**
+ *	L um nmero inteiro, com a mesma sintaxe de "%d" em sscanf().
+ *
+ *	@return Zero se o prximo campo no  um nmero inteiro.
+ */
+int tokInt( Tokenizer *tokenizer, int *value );
+
+/**
+ *	L uma palavra qualquer (at o prximo espao), como "%s" em sscanf(). Palavras
+ *	maiores que o buffer so truncadas.
+ *
+ *	@param buffer [out]Palavra lida, terminada em '\0'.
+ *	@param size Tamanho do buffer.
+ *
+ *	@return Zero se a linha no tem mais campos.
+ */
+int tokString( Tokenizer *tokenizer, char *buffer, size_t size );
+
+#endif